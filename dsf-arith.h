@@ -0,0 +1,252 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Arithmetic Policies
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * The number formats `DsfOscT` can evaluate Moorer's formula
+ * in, chosen at compile time: fix15 for the FPU-less RP2040,
+ * a narrow Q1.15 whose products fit one 32-bit multiply, a
+ * 32-bit fixed point with 26 fraction bits for more
+ * precision without an FPU, and single-precision float for
+ * targets with an FPU (RP2350, hosts). A policy only supplies
+ * the value type, conversions, multiply, divide and the DAC
+ * mapping; the algorithm itself is written once.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cmath>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "inc/fix15.h"
+
+/*!
+    @brief enumeration of sample kernels, i.e. how the division in Moorer's formula is evaluated
+
+    @param kernel_divide full 64-bit fixed-point division every sample (reference)
+    @param kernel_reciprocal division-free: seeded Newton-Raphson reciprocal, within 1 LSB of `kernel_divide`
+*/
+enum dsf_kernel_t : uint8_t
+{
+    kernel_divide,
+    kernel_reciprocal
+};
+
+/*!
+    @brief fix15 (Q16.15 in 32 bits), the macros from `inc/fix15.h`; the only policy with `kernel_reciprocal`
+
+    Every policy provides:
+    * `value_t`: the number type; `+`, `-`, comparisons and division by an integer count work on it directly
+    * `table_t`: the type the sine table stores, `value_t` or narrower
+    * `dac_t`: the type of the precomputed half DAC range, see `dacScale()`
+    * `fromDouble(x)`, `fromFix15(x)`: conversions, `constexpr` so tables and limits are built at compile time;
+      `toDouble(x)` for host-side checks
+    * `one`: 1 in `value_t`
+    * `mul(a, b)`, `div<K>(num, den)`: product and quotient; `K` selects the kernel where the policy has more than one
+    * `quotient<K, WIDE>(num, s, den)`: the sample `num * s / den`; `WIDE` is set for the finite sum, whose numerator
+      reaches 3.61 (only `dsf_arith_q15` treats it differently)
+    * `flush(x)`: 0 for values too small to matter, so high powers of `a` can't turn into slow denormals
+    * `mulFrac(x, frac)`: `x * frac / 2^32` for a difference of two table entries, for interpolated lookups
+    * `dacScale(halfDac)`, `toDac(sample, scale)`: maps a sample in [-1, 1] to a DAC code, `sample * halfDac + halfDac`
+*/
+struct dsf_arith_fix15 {
+    typedef fix15 value_t;
+    typedef fix15 table_t;
+    typedef fix15 dac_t;
+
+    static constexpr const char *name = "fix15";
+    static constexpr value_t one = int2fix15(1);
+
+    static constexpr value_t fromDouble(double x) { return float2fix15(x); }
+    static constexpr value_t fromFix15(fix15 x) { return x; }
+    static constexpr double toDouble(value_t x) { return (double)x / 32768.0; }
+
+    static inline value_t mul(value_t a, value_t b) { return multfix15(a, b); }
+    static inline value_t flush(value_t x) { return x; }
+    // table steps are below 2^10 and the fraction is cut to 15 bits, so a 32-bit multiply is enough
+    static inline value_t mulFrac(value_t x, uint32_t frac) { return (x * (int32_t)(frac >> 17)) >> 15; }
+
+    template <dsf_kernel_t K>
+    static inline value_t div(value_t num, value_t den)
+    {
+        if (K == kernel_reciprocal) return recipdivfix15(num, den);
+        return divfix15(num, den);
+    }
+
+    template <dsf_kernel_t K, bool WIDE>
+    static inline value_t quotient(value_t num, value_t s, value_t den) { return div<K>(mul(num, s), den); }
+
+    static inline dac_t dacScale(fix15 halfDac) { return halfDac; }
+    static inline uint16_t toDac(value_t sample, dac_t halfDac) { return (uint16_t)fix2int15((multfix15(sample, halfDac) + halfDac)); }
+};
+
+/*!
+    @brief Q1.15 with 32-bit products and quotients, for the Cortex-M0+ (no 32x32->64 multiply)
+
+    The values are fix15's: 15 fraction bits, held in 32-bit registers, truncated the same way (products shifted down,
+    quotients rounded towards zero). The difference is the width of the arithmetic. `multfix15()` and `divfix15()` widen
+    to 64 bits, which the M0+ can only do in library calls (`__aeabi_lmul`, `__aeabi_ldivmod`); here a product is one
+    `MULS` and a shift, and a quotient is one 32-bit division, which the RP2040's hardware divider answers in 8 cycles.
+    The sine table is stored as `int16_t`, half the size of fix15's.
+
+    Headroom: a 32-bit product holds `|x * y| < 2` and a quotient needs `|num| < 2` (raw `|num| < 2^16`), since the
+    numerator is scaled up by `one` before the division; the scaling is a multiply, not a left shift, which would be
+    undefined for negative values (the compiler still emits `LSLS`). In every product of the formula one
+    factor is a table entry or `a` (at most 1) and the other stays below 2: `a^2`, `2a cos(β)` (1.8 at `a` = 0.9),
+    `(1 - a^2) sin(θ)` and the powers of `a`. The finite sum's numerator reaches `1 - a^2 + 2 a^(N+1) (1 + a)` = 3.61,
+    so `quotient<K, true>` keeps that one product and quotient at 64 bits, like fix15. The DAC mapping works modulo
+    2^32, which holds the bits the 16-bit code keeps, so it matches fix15 for any sample and any DAC up to 16 bits.
+
+    The only difference to fix15's output is the table: Q1.15 can't hold +1.0, so the entries at a quarter cycle (and
+    nothing else) hold 32767/32768. There is one division kernel; `kernel_reciprocal` falls back to it.
+*/
+struct dsf_arith_q15 {
+    typedef int32_t value_t;
+    typedef int16_t table_t;
+    typedef uint32_t dac_t;
+
+    static constexpr const char *name = "q15";
+    static constexpr int frac = 15;
+    static constexpr value_t one = (value_t)1 << frac;
+
+    static constexpr value_t fromDouble(double x) { return (value_t)(x * (double)one); }
+    static constexpr value_t fromFix15(fix15 x) { return x; }
+    static constexpr double toDouble(value_t x) { return (double)x / (double)one; }
+
+    static inline value_t mul(value_t a, value_t b) { return (a * b) >> frac; }
+    static inline value_t flush(value_t x) { return x; }
+    static inline value_t mulFrac(value_t x, uint32_t f) { return (x * (int32_t)(f >> 17)) >> frac; }
+
+    template <dsf_kernel_t K>
+    static inline value_t div(value_t num, value_t den)
+    {
+        return (num * one) / den;
+    }
+
+    template <dsf_kernel_t K, bool WIDE>
+    static inline value_t quotient(value_t num, value_t s, value_t den)
+    {
+        if (!WIDE) return div<K>(mul(num, s), den);
+        return (value_t)(((int64_t)(value_t)(((int64_t)num * s) >> frac) * one) / den);
+    }
+
+    // the full code range 2^bits - 1 as an integer: halfDac is exactly (2^bits - 1) * 2^14
+    static inline dac_t dacScale(fix15 halfDac) { return (dac_t)(halfDac >> 14); }
+    // (sample * full + full * 2^15) / 2^16, wrapping at 32 bits like fix15's multfix15() + halfDac does at its top bits
+    static inline uint16_t toDac(value_t sample, dac_t full) { return (uint16_t)(((uint32_t)sample * full + (full << 15)) >> 16); }
+};
+
+/*!
+    @brief 32-bit fixed point with 26 fraction bits (Q5.26), 64-bit products and quotients
+
+    2^11 times finer than fix15 at the same storage and a similar cost. Q1.31 would not do: the denominator reaches
+    `(1 + a)^2` = 3.61 and the unnormalised sample `(1 + a) / (1 - a)` = 19 at `a` = 0.9, so the format keeps five integer
+    bits. There is one division kernel; `kernel_reciprocal` falls back to it.
+*/
+struct dsf_arith_q26 {
+    typedef int32_t value_t;
+    typedef int32_t table_t;
+    typedef fix15 dac_t;
+
+    static constexpr const char *name = "q26";
+    static constexpr int frac = 26;
+    static constexpr value_t one = (value_t)1 << frac;
+
+    static constexpr value_t fromDouble(double x) { return (value_t)(x * (double)one); }
+    static constexpr value_t fromFix15(fix15 x) { return (value_t)((uint32_t)x << (frac - 15)); }
+    static constexpr double toDouble(value_t x) { return (double)x / (double)one; }
+
+    static inline value_t mul(value_t a, value_t b) { return (value_t)(((int64_t)a * b) >> frac); }
+    static inline value_t flush(value_t x) { return x; }
+    static inline value_t mulFrac(value_t x, uint32_t f) { return (value_t)(((int64_t)x * (f >> 1)) >> 31); }
+
+    template <dsf_kernel_t K>
+    static inline value_t div(value_t num, value_t den)
+    {
+        return (value_t)(((int64_t)num * one) / den);
+    }
+
+    template <dsf_kernel_t K, bool WIDE>
+    static inline value_t quotient(value_t num, value_t s, value_t den) { return div<K>(mul(num, s), den); }
+
+    static inline dac_t dacScale(fix15 halfDac) { return halfDac; }
+    static inline uint16_t toDac(value_t sample, dac_t halfDac)
+    {
+        fix15 scaled = (fix15)(((int64_t)sample * halfDac) >> frac);
+        return (uint16_t)fix2int15((scaled + halfDac));
+    }
+};
+
+/*!
+    @brief single-precision float, for targets with an FPU (RP2350, hosts)
+
+    On the RP2040 every operation would go through the software float library. There is one division kernel;
+    `kernel_reciprocal` falls back to it.
+*/
+struct dsf_arith_float {
+    typedef float value_t;
+    typedef float table_t;
+    typedef float dac_t;
+
+    static constexpr const char *name = "float";
+    static constexpr value_t one = 1.0f;
+
+    static constexpr value_t fromDouble(double x) { return (value_t)x; }
+    static constexpr value_t fromFix15(fix15 x) { return (value_t)x * (1.0f / 32768.0f); }
+    static constexpr double toDouble(value_t x) { return (double)x; }
+
+    static inline value_t mul(value_t a, value_t b) { return a * b; }
+    // a^(N+1) reaches 1e-39 at a = 0.5, N = 127: denormal, and every multiply with it would be many times slower
+    static inline value_t flush(value_t x) { return (fabsf(x) < 0x1p-64f) ? 0.0f : x; }
+    // 24 fraction bits are all a float holds, and a signed conversion is cheaper than an unsigned one
+    static inline value_t mulFrac(value_t x, uint32_t frac) { return x * ((float)(int32_t)(frac >> 8) * 0x1p-24f); }
+
+    template <dsf_kernel_t K>
+    static inline value_t div(value_t num, value_t den)
+    {
+        return num / den;
+    }
+
+    template <dsf_kernel_t K, bool WIDE>
+    static inline value_t quotient(value_t num, value_t s, value_t den) { return div<K>(mul(num, s), den); }
+
+    static inline dac_t dacScale(fix15 halfDac) { return fix2float15(halfDac); }
+    // rounded down like the fixed-point policies' shift, so all three wrap the same way below code 0
+    static inline uint16_t toDac(value_t sample, dac_t halfDac) { return (uint16_t)(int32_t)floorf(sample * halfDac + halfDac); }
+};
+
+/*!
+    @brief `a^2` along a linear ramp of `a`: `value()` is the square of the current `a`, `next()` advances `a` by `step`
+
+    The general version squares every sample. The fix15 specialisation below tracks `a^2` exactly in Q30 with two running
+    differences instead, which saves the multiply on the RP2040.
+*/
+template <class P>
+struct dsf_square_ramp_t {
+    typename P::value_t a, step;
+
+    dsf_square_ramp_t(typename P::value_t a, typename P::value_t step) : a(a), step(step) {}
+    inline typename P::value_t value() const { return P::mul(a, a); }
+    inline void next() { a += step; }
+};
+
+template <>
+struct dsf_square_ramp_t<dsf_arith_fix15> {
+    // a^2 in Q30: exact, so (sq30 >> 15) == multfix15(a, a) for every sample
+    int32_t sq30, delta, delta2;
+
+    dsf_square_ramp_t(fix15 a, fix15 step) : sq30(a * a), delta((2 * a + step) * step), delta2(2 * step * step) {}
+    inline fix15 value() const { return (fix15)(sq30 >> 15); }
+    inline void next()
+    {
+        sq30 += delta;
+        delta += delta2;
+    }
+};
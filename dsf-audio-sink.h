@@ -0,0 +1,72 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Audio Sink Interface
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Block-based output: the renderer asks a sink for a free
+ * block, fills it with DAC codes and hands it back. Device
+ * sinks play the blocks from a ring while the next ones are
+ * rendered; host sinks write them to files or discard them.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+
+/*!
+    @brief Destination for rendered blocks of DAC codes.
+
+    Usage from the render loop:
+
+        while (uint16_t *block = sink.acquire()) {
+            voices.renderBlock(block, sink.blockSize());
+            sink.commit();
+        }
+
+    `acquire()` returns `nullptr` while the sink has no free block (the renderer is far enough ahead), so the loop above
+    never blocks. `underruns()` counts blocks a paced sink had to play before they were rendered.
+*/
+class DsfAudioSink {
+
+    public:
+        virtual ~DsfAudioSink() {}
+
+        /*!
+            @return a buffer of `blockSize()` samples to fill, or `nullptr` if the sink cannot take a block yet
+        */
+        virtual uint16_t *acquire() = 0;
+
+        /*!
+            @brief hands the block returned by the last `acquire()` to the sink
+        */
+        virtual void commit() = 0;
+
+        /*!
+            @return the number of samples in every block
+        */
+        virtual size_t blockSize() const = 0;
+
+        /*!
+            @return the sample clock at which the block from the next `acquire()` will play; a paced sink skips ahead
+            after an underrun to stay with playback
+        */
+        virtual uint32_t position() const { return blockCount * (uint32_t)blockSize(); }
+
+        /*!
+            @return blocks the sink played before the renderer had committed them (stale audio)
+        */
+        uint32_t underruns() const { return underrunCount; }
+
+        /*!
+            @return blocks committed so far
+        */
+        uint32_t blocks() const { return blockCount; }
+
+    protected:
+        uint32_t underrunCount = 0, blockCount = 0;
+};
@@ -0,0 +1,134 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Control Input Filter
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Turns a free-running, round-robin ADC stream (written into
+ * a ring buffer by DMA on the RP2040, or by a simulated
+ * source on the host) into filtered, decimated control
+ * values. The audio path reads them lock-free in constant
+ * time and never touches the ADC.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * CONTROL SETTINGS
+ */
+#define DSF_CTRL_MAX 4095 // full scale of a 12-bit ADC
+
+/*!
+    @brief Filter/decimator for round-robin ADC control inputs.
+
+    The ring holds interleaved conversions: entry `i` is channel `i % CHANNELS`, which holds as long as the ring length is a
+    multiple of `CHANNELS` and the round-robin sequence starts at channel 0 together with the ring. `update()` runs outside
+    the audio interrupt (the main loop), consumes everything the producer has written since the last call, averages
+    `decimate` conversions per channel and smooths the averages with a one-pole low-pass (`smoothShift`: the new value
+    weighs `2^-smoothShift`). `value()` is a single atomic load and is safe from any interrupt or core.
+
+    @tparam CHANNELS number of channels in the round-robin sequence
+    @tparam RING ring length in samples (a multiple of `CHANNELS`)
+*/
+template <uint8_t CHANNELS, uint16_t RING>
+class DsfControls {
+
+    static_assert(CHANNELS > 0 && RING % CHANNELS == 0, "the ring must hold whole round-robin frames");
+
+    public:
+        DsfControls(uint8_t decimate, uint8_t smoothShift);
+        void update(const volatile uint16_t *ring, uint16_t writePos);
+
+        /*!
+            @return the latest filtered value of `channel` (0..`DSF_CTRL_MAX`), constant time and lock-free
+        */
+        uint16_t value(uint8_t channel) const { return out[channel].load(std::memory_order_relaxed); }
+
+        /*!
+            @return the number of filtered values published so far, summed over all channels
+        */
+        uint32_t published() const { return frames; }
+
+    private:
+        void filter(uint8_t channel);
+
+        uint32_t sum[CHANNELS], state[CHANNELS]; // state is Q8
+        uint8_t count[CHANNELS];
+        bool primed[CHANNELS];
+        std::atomic<uint16_t> out[CHANNELS];
+
+        uint32_t frames = 0;
+        uint16_t readPos = 0;
+        uint8_t decimation, shift;
+};
+
+/*!
+    @brief Constructor.
+
+    @param decimate conversions averaged per channel before each filter step (at least 1)
+    @param smoothShift one-pole coefficient as a shift; 0 publishes the plain averages
+*/
+template <uint8_t CHANNELS, uint16_t RING>
+DsfControls<CHANNELS, RING>::DsfControls(uint8_t decimate, uint8_t smoothShift)
+{
+    decimation = (decimate > 0) ? decimate : 1;
+    shift = smoothShift;
+
+    for (uint8_t c = 0; c < CHANNELS; c++) {
+        sum[c] = state[c] = 0;
+        count[c] = 0;
+        primed[c] = false;
+        out[c].store(0, std::memory_order_relaxed);
+    }
+}
+
+/*!
+    @brief consumes new conversions from the ring and publishes filtered values
+
+    Call it often enough that the producer cannot lap the reader (within `RING` conversions); if it does, the overwritten
+    conversions are simply replaced by newer ones, which a control filter tolerates.
+
+    @param ring the ring buffer the producer writes
+    @param writePos index of the next entry the producer will write (e.g. from the DMA write address)
+*/
+template <uint8_t CHANNELS, uint16_t RING>
+void DsfControls<CHANNELS, RING>::update(const volatile uint16_t *ring, uint16_t writePos)
+{
+    writePos %= RING;
+
+    while (readPos != writePos) {
+        uint8_t c = readPos % CHANNELS;
+        sum[c] += ring[readPos] & DSF_CTRL_MAX;
+        if (++count[c] == decimation) filter(c);
+        readPos = (readPos + 1 == RING) ? 0 : readPos + 1;
+    }
+}
+
+/*!
+    @brief one filter step for `channel`: average, smooth and publish
+*/
+template <uint8_t CHANNELS, uint16_t RING>
+void DsfControls<CHANNELS, RING>::filter(uint8_t channel)
+{
+    uint32_t mean8 = (sum[channel] << 8) / decimation;
+    sum[channel] = 0;
+    count[channel] = 0;
+
+    if (!primed[channel]) {
+        // start from the first reading instead of gliding up from zero at boot
+        state[channel] = mean8;
+        primed[channel] = true;
+    } else {
+        state[channel] = state[channel] + (int32_t)(mean8 - state[channel]) / (1 << shift);
+    }
+
+    out[channel].store((uint16_t)((state[channel] + 128) >> 8), std::memory_order_relaxed);
+    frames++;
+}
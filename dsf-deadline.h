@@ -0,0 +1,211 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Real-Time Deadline Monitor
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Measures how close the render loop runs to its deadline:
+ * a histogram of the time each block took against the time
+ * the sink needs to play it, the worst case, overrun and
+ * late-block counters and a per-stage breakdown. A handful
+ * of clock reads and adds per block, cheap enough to stay
+ * enabled; `print()` dumps it on demand.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstdio>
+
+/*!
+    @brief Deadline statistics for a block renderer.
+
+    A block is timed from `blockStart()` to `blockEnd()`. Its time is binned into a histogram of `BINS` equal bins from 0
+    to twice the budget (the last bin also takes anything longer), and a block that took longer than the budget counts
+    as an overrun: rendered at that pace the loop falls behind the sink. `blockEnd()` also takes the block's slack, the
+    samples left until the sink plays it; a negative slack means it was committed too late to be heard (the sink
+    replays old audio) and counts as late.
+
+    Stages are timed back to back: `stageStart()` (or `blockStart()`) sets the mark and every `stageEnd(s)` charges the
+    time since the mark to stage `s` and moves the mark, so consecutive stages need one clock read each. Stages may run
+    outside a block too (e.g. control input filtering in the main loop); they are counted per call.
+
+    The clock is a compile-time policy with `start()`, `now()` (a counter that counts up and wraps at `mask`) and
+    `hz()`: the SysTick counter on the RP2040, `std::chrono` on the host. Differences are taken modulo `mask + 1`, so
+    nothing timed may take a whole clock wrap (126 ms for the 24-bit SysTick at 133 MHz). Not thread-safe: record and
+    print from the same core.
+
+    @tparam CLOCK the clock policy
+    @tparam STAGES number of stages
+    @tparam BINS number of histogram bins
+*/
+template <class CLOCK, uint8_t STAGES, uint8_t BINS = 16>
+class DsfDeadlineMonitor {
+
+    static_assert(STAGES > 0 && BINS > 1, "the monitor needs at least one stage and two bins");
+
+    public:
+        void start(uint32_t budgetTicks);
+        void reset();
+        void print(const char *const names[STAGES]) const;
+
+        /*!
+            @brief marks the start of a block, and of its first stage
+        */
+        inline void blockStart() { blockMark = stageMark = CLOCK::now(); }
+
+        /*!
+            @brief marks the start of a stage outside a block
+        */
+        inline void stageStart() { stageMark = CLOCK::now(); }
+
+        /*!
+            @brief charges the time since the last mark to stage `s` and sets the mark for the next stage
+        */
+        inline void stageEnd(uint8_t s)
+        {
+            uint32_t t = CLOCK::now(), dt = (t - stageMark) & CLOCK::mask;
+            stageMark = t;
+            stageTotal[s] += dt;
+            stageCalls[s]++;
+            if (dt > stageWorst[s]) stageWorst[s] = dt;
+        }
+
+        /*!
+            @brief closes the block opened by `blockStart()`
+
+            @param slack samples from now until the sink plays the block; negative if it is already late
+        */
+        inline void blockEnd(int32_t slack)
+        {
+            uint32_t dt = (CLOCK::now() - blockMark) & CLOCK::mask;
+            uint32_t bin = dt / binWidth;
+            histogram[(bin < BINS) ? bin : BINS - 1]++;
+            total += dt;
+            blockCount++;
+            if (dt > worstTicks) worstTicks = dt;
+            if (dt > budget) overrunCount++;
+            if (slack < 0) lateCount++;
+            if (slack < slackMin) slackMin = slack;
+        }
+
+        /*!
+            @return the time a block may take, in clock ticks
+        */
+        uint32_t budgetTicks() const { return budget; }
+
+        /*!
+            @return blocks timed since `start()` or `reset()`
+        */
+        uint32_t blocks() const { return blockCount; }
+
+        /*!
+            @return blocks that took longer than the budget
+        */
+        uint32_t overruns() const { return overrunCount; }
+
+        /*!
+            @return blocks committed after the sink needed them
+        */
+        uint32_t late() const { return lateCount; }
+
+        /*!
+            @return the longest block, in clock ticks
+        */
+        uint32_t worst() const { return worstTicks; }
+
+        /*!
+            @return the smallest slack passed to `blockEnd()`, in samples (`INT32_MAX` before the first block)
+        */
+        int32_t minSlack() const { return slackMin; }
+
+        /*!
+            @return blocks in histogram bin `i`, which covers `i * 2 * budget / BINS` up to the next bin
+        */
+        uint32_t bin(uint8_t i) const { return histogram[i]; }
+
+        /*!
+            @return calls, total and longest time of stage `s`, in clock ticks
+        */
+        uint32_t calls(uint8_t s) const { return stageCalls[s]; }
+        uint64_t stageTicks(uint8_t s) const { return stageTotal[s]; }
+        uint32_t stageMax(uint8_t s) const { return stageWorst[s]; }
+
+    private:
+        uint64_t total = 0, stageTotal[STAGES] = {};
+        uint32_t budget = 1, binWidth = 1, blockMark = 0, stageMark = 0;
+        uint32_t blockCount = 0, overrunCount = 0, lateCount = 0, worstTicks = 0;
+        int32_t slackMin = INT32_MAX;
+        uint32_t histogram[BINS] = {}, stageCalls[STAGES] = {}, stageWorst[STAGES] = {};
+};
+
+/*!
+    @brief starts the clock and clears the statistics
+
+    @param budgetTicks the time a block may take, in clock ticks: the block's playing time, e.g.
+    `CLOCK::hz() * SINK_BLOCK / SAMPLE_RATE`
+*/
+template <class CLOCK, uint8_t STAGES, uint8_t BINS>
+void DsfDeadlineMonitor<CLOCK, STAGES, BINS>::start(uint32_t budgetTicks)
+{
+    CLOCK::start();
+    budget = (budgetTicks > 0) ? budgetTicks : 1;
+    binWidth = (2 * (uint64_t)budget + BINS - 1) / BINS;
+    reset();
+}
+
+/*!
+    @brief clears the statistics, keeping the budget
+*/
+template <class CLOCK, uint8_t STAGES, uint8_t BINS>
+void DsfDeadlineMonitor<CLOCK, STAGES, BINS>::reset()
+{
+    total = 0;
+    blockCount = overrunCount = lateCount = worstTicks = 0;
+    slackMin = INT32_MAX;
+    for (uint8_t i = 0; i < BINS; i++) histogram[i] = 0;
+    for (uint8_t s = 0; s < STAGES; s++) {
+        stageTotal[s] = 0;
+        stageCalls[s] = stageWorst[s] = 0;
+    }
+}
+
+/*!
+    @brief prints the statistics with `printf()`: summary, per-stage breakdown and histogram, times in µs
+
+    @param names a name for each stage
+*/
+template <class CLOCK, uint8_t STAGES, uint8_t BINS>
+void DsfDeadlineMonitor<CLOCK, STAGES, BINS>::print(const char *const names[STAGES]) const
+{
+    double us = 1e6 / (double)CLOCK::hz();
+
+    printf("deadline: %u blocks, budget %.1f us, mean %.1f us, worst %.1f us (%.0f%%), %u overruns, %u late",
+           blockCount, budget * us, blockCount ? (double)total / blockCount * us : 0.0, worstTicks * us,
+           100.0 * worstTicks / budget, overrunCount, lateCount);
+    if (blockCount) printf(", min slack %d samples", (int)slackMin);
+    printf("\n");
+
+    printf("  %-12s %10s %10s %10s\n", "stage", "calls", "mean us", "worst us");
+    for (uint8_t s = 0; s < STAGES; s++) {
+        printf("  %-12s %10u %10.2f %10.2f\n", names[s], stageCalls[s],
+               stageCalls[s] ? (double)stageTotal[s] / stageCalls[s] * us : 0.0, stageWorst[s] * us);
+    }
+
+    printf("  %-9s %10s\n", "budget", "blocks");
+    // bars scaled to the fullest bin
+    uint32_t fullest = 1;
+    for (uint8_t i = 0; i < BINS; i++) if (histogram[i] > fullest) fullest = histogram[i];
+    for (uint8_t i = 0; i < BINS; i++) {
+        uint32_t from = 200 * i / BINS;
+        char bar[33];
+        uint32_t len = (uint32_t)((uint64_t)histogram[i] * 32 / fullest);
+        for (uint32_t j = 0; j < 32; j++) bar[j] = (j < len) ? '#' : ' ';
+        bar[32] = 0;
+        if (i < BINS - 1) printf("  %3u-%3u%% %10u %s\n", from, 200 * (i + 1) / BINS, histogram[i], bar);
+        else printf("  %3u%%+    %10u %s\n", from, histogram[i], bar);
+    }
+}
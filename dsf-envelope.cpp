@@ -0,0 +1,182 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * ADSR Envelope
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-envelope.h"
+
+/*!
+    @brief Constructor. Starts idle at level 0 with 10 ms attack, 100 ms decay, full sustain and 100 ms release.
+
+    @param sample_rate the rate `next()` is called at, in Hz
+    @param period_bits the control period is `2^period_bits` samples (e.g. 4 for 16, 5 for 32)
+*/
+DsfEnvelope::DsfEnvelope(uint16_t sample_rate, uint8_t period_bits)
+{
+    fs = sample_rate;
+    periodBits = period_bits;
+    setAttack(10);
+    setDecay(100);
+    setRelease(100);
+}
+
+/*!
+    @return the number of control periods in `ms` milliseconds, at least 1
+*/
+uint32_t DsfEnvelope::ticksFor(uint32_t ms) const
+{
+    uint32_t ticks = (uint32_t)(((uint64_t)ms * fs / 1000) >> periodBits);
+    return ticks ? ticks : 1;
+}
+
+/*!
+    @brief per-tick change for a segment of `ticks` control periods: a slope for linear segments, a Q16 one-pole
+    coefficient for exponential ones
+*/
+static int32_t segmentStep(dsf_env_shape_t shape, uint32_t ticks)
+{
+    if (shape == env_linear) return DSF_ENV_ONE / (int32_t)ticks;
+    uint32_t coef = DSF_ENV_EXP_C / ticks;
+    if (coef > 65536) coef = 65536;
+    return coef ? (int32_t)coef : 1;
+}
+
+/*!
+    @brief sets the attack time (0 to full scale); only recalculates when the time in control periods changes
+
+    @param ms attack time in milliseconds
+*/
+void DsfEnvelope::setAttack(uint32_t ms)
+{
+    uint32_t ticks = ticksFor(ms);
+    if (ticks == attackTicks) return;
+    attackTicks = ticks;
+    attackStep = segmentStep(shape, ticks);
+}
+
+/*!
+    @brief sets the decay time (full scale to 0 for linear segments, full scale to a sustain of 0 for exponential ones)
+
+    @param ms decay time in milliseconds
+*/
+void DsfEnvelope::setDecay(uint32_t ms)
+{
+    uint32_t ticks = ticksFor(ms);
+    if (ticks == decayTicks) return;
+    decayTicks = ticks;
+    decayStep = segmentStep(shape, ticks);
+}
+
+/*!
+    @brief sets the release time (full scale to 0)
+
+    @param ms release time in milliseconds
+*/
+void DsfEnvelope::setRelease(uint32_t ms)
+{
+    uint32_t ticks = ticksFor(ms);
+    if (ticks == releaseTicks) return;
+    releaseTicks = ticks;
+    releaseStep = segmentStep(shape, ticks);
+}
+
+/*!
+    @brief sets the sustain level; a sustaining envelope follows it at the next control period
+
+    @param level fixed-point level, `0 <= level <= one15`
+*/
+void DsfEnvelope::setSustain(fix15 level)
+{
+    if (level < 0) level = 0;
+    if (level > int2fix15(1)) level = int2fix15(1);
+    sustain = level << 9;
+}
+
+/*!
+    @brief selects linear or exponential segments and recalculates their increments
+
+    @param s the segment shape
+*/
+void DsfEnvelope::setShape(dsf_env_shape_t s)
+{
+    shape = s;
+    attackStep = segmentStep(shape, attackTicks);
+    decayStep = segmentStep(shape, decayTicks);
+    releaseStep = segmentStep(shape, releaseTicks);
+}
+
+/*!
+    @brief opens or closes the gate
+
+    Opening starts the attack from the current level (so retriggering never clicks back to 0); closing starts the
+    release from wherever the envelope is.
+
+    @param on `true` for note on, `false` for note off
+*/
+void DsfEnvelope::gate(bool on)
+{
+    if (on) {
+        current = env_attack;
+    } else if (current != env_idle) {
+        current = env_release;
+    }
+}
+
+/*!
+    @brief advances one control period
+
+    @return the level at the end of the period, `0 <= level <= one15`
+*/
+fix15 DsfEnvelope::tick()
+{
+    control();
+    return (fix15)(level >> 9);
+}
+
+/*!
+    @brief one control-rate step of the current segment, including the stage changes at its end
+*/
+void DsfEnvelope::control()
+{
+    bool exponential = (shape == env_exponential);
+
+    switch (current)
+    {
+    case env_attack:
+        if (exponential) level += (int32_t)(((int64_t)(DSF_ENV_ONE + DSF_ENV_OVERSHOOT - level) * attackStep) >> 16);
+        else level += attackStep;
+        if (level >= DSF_ENV_ONE) {
+            level = DSF_ENV_ONE;
+            current = env_decay;
+        }
+        break;
+
+    case env_decay:
+        if (exponential) level -= (int32_t)(((int64_t)(level - (sustain - DSF_ENV_OVERSHOOT)) * decayStep) >> 16);
+        else level -= decayStep;
+        if (level <= sustain) {
+            level = sustain;
+            current = env_sustain;
+        }
+        break;
+
+    case env_sustain:
+        level = sustain;
+        break;
+
+    case env_release:
+        if (exponential) level -= (int32_t)(((int64_t)(level + DSF_ENV_OVERSHOOT) * releaseStep) >> 16);
+        else level -= releaseStep;
+        if (level <= 0) {
+            level = 0;
+            current = env_idle;
+        }
+        break;
+
+    default:
+        level = 0;
+        break;
+    }
+}
@@ -0,0 +1,121 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * ADSR Envelope
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Attack/decay/sustain/release envelope with linear or
+ * exponential segments. The segments advance at a control
+ * rate (every 2^period_bits samples) and are interpolated to
+ * audio rate with one add per sample; every increment is
+ * calculated when a time changes, never per sample.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "inc/fix15.h"
+
+/*
+ * ENVELOPE CONSTANTS
+ */
+#define DSF_ENV_ONE (1 << 24) // full scale of the internal level (Q24)
+#define DSF_ENV_OVERSHOOT (DSF_ENV_ONE / 5) // exponential segments aim this far past their end point
+#define DSF_ENV_EXP_C 117427 // ln(1 + 1/0.2) in Q16: an aim 20% past the end arrives after one segment time
+
+/*!
+    @brief enumeration of envelope stages
+
+    @param env_idle gate off and release finished, level 0
+    @param env_attack rising to full scale
+    @param env_decay falling to the sustain level
+    @param env_sustain holding the sustain level while the gate is on
+    @param env_release falling to 0 after the gate turned off
+*/
+enum dsf_env_stage_t : uint8_t
+{
+    env_idle,
+    env_attack,
+    env_decay,
+    env_sustain,
+    env_release
+};
+
+/*!
+    @brief enumeration of segment shapes
+
+    @param env_linear constant slope; times are for a full-scale (0 to 1) segment
+    @param env_exponential RC-style curve aimed past the end point, so it still arrives in finite time
+*/
+enum dsf_env_shape_t : uint8_t
+{
+    env_linear,
+    env_exponential
+};
+
+/*!
+    @brief ADSR envelope generator, integer only.
+
+    Call `next()` once per sample for an interpolated level, or `tick()` once per control period to get the level at the
+    end of the period (e.g. as `param_a_end` of `DsfOsc::renderBlock()`). Don't mix the two on one envelope.
+*/
+class DsfEnvelope {
+
+    public:
+        DsfEnvelope(uint16_t sample_rate, uint8_t period_bits = 5);
+        void setAttack(uint32_t ms);
+        void setDecay(uint32_t ms);
+        void setSustain(fix15 level);
+        void setRelease(uint32_t ms);
+        void setShape(dsf_env_shape_t s);
+        void gate(bool on);
+        fix15 tick();
+
+        /*!
+            @brief advances one sample
+
+            @return the envelope level, `0 <= level <= one15`, linearly interpolated between control points
+        */
+        inline fix15 next()
+        {
+            if (countdown == 0) {
+                int32_t from = level;
+                control();
+                slope = (level - from) >> periodBits;
+                interp = from;
+                countdown = 1 << periodBits;
+            }
+            countdown--;
+            interp += slope;
+            return (fix15)(interp >> 9);
+        }
+
+        dsf_env_stage_t stage() const { return current; }
+        bool active() const { return current != env_idle; }
+
+        /*!
+            @return samples per control period
+        */
+        uint16_t period() const { return 1 << periodBits; }
+
+    private:
+        uint32_t ticksFor(uint32_t ms) const;
+        void control();
+
+        // per-tick increments (linear) or Q16 coefficients (exponential), updated only when a time or the shape changes
+        uint32_t attackTicks = 0, decayTicks = 0, releaseTicks = 0;
+        int32_t attackStep, decayStep, releaseStep;
+        int32_t level = 0, sustain = DSF_ENV_ONE, interp = 0, slope = 0;
+        uint16_t fs, countdown = 0;
+        uint8_t periodBits;
+        dsf_env_shape_t shape = env_linear;
+        dsf_env_stage_t current = env_idle;
+};
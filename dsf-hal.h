@@ -0,0 +1,136 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Hardware Abstraction Layer
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * The hardware an application loop around `DsfSynth` talks
+ * to: the timer, GPIO outputs, the DAC (as a `DsfAudioSink`),
+ * the second core and its inputs (pots, buttons, encoder,
+ * MIDI, SysEx). The RP2040 implements it with the Pico SDK;
+ * the host implements it with a simulated clock and inputs
+ * replayed from a trace (`dsf-trace.h`), so the same loop
+ * runs on both and renders the same DAC codes.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-audio-sink.h"
+
+/*!
+    @brief kinds of `dsf_input_t`
+
+    @param input_control a filtered pot reading: `id` is the channel, `value` 0..`DSF_CTRL_MAX`
+    @param input_button a button interrupt: `id` is the button (numbered by the application), `value` its state
+    @param input_encoder encoder steps: `id` is the encoder, `value` the steps since the last read
+    @param input_midi a channel message (`midi`) and the sample in its block it was applied at (`offset`)
+    @param input_sysex a complete SysEx message, `len` bytes at `data`
+*/
+enum dsf_input_type_t : uint8_t
+{
+    input_control,
+    input_button,
+    input_encoder,
+    input_midi,
+    input_sysex,
+    input_types
+};
+
+/*!
+    @brief one input event, as the application applies it between blocks
+
+    @param type a `dsf_input_type_t`
+    @param id control channel, button or encoder
+    @param value control reading, button state or encoder steps
+    @param offset `input_midi`: sample of the block the message is applied at
+    @param midi `input_midi`: status and data bytes
+    @param len `input_sysex`: message length, `F0` to `F7`
+    @param data `input_sysex`: the message; only valid until the next `DsfHal::pollInput()`
+*/
+typedef struct {
+    uint8_t type, id;
+    int16_t value;
+    uint16_t offset;
+    uint8_t midi[3];
+    uint16_t len;
+    const uint8_t *data;
+} dsf_input_t;
+
+/*!
+    @brief Hardware the application loop uses.
+
+    All calls come from the loop's core (core 0 on the RP2040), except that `timeUs()` may be called from anywhere.
+    Inputs that arrive asynchronously (interrupts, the other core, DMA) are collected by the implementation and handed
+    to the loop by `pollInput()` between blocks, so everything that changes what the loop renders happens at a known
+    block. The deadline hooks default to nothing.
+*/
+class DsfHal {
+
+    public:
+        virtual ~DsfHal() {}
+
+        /*!
+            @return microseconds on a free-running timer
+        */
+        virtual uint64_t timeUs() = 0;
+
+        /*!
+            @brief sets output pin `pin`
+        */
+        virtual void gpioPut(uint8_t pin, bool on) = 0;
+
+        /*!
+            @brief sets (`on`) or clears the output pins in `mask`
+        */
+        virtual void gpioMask(uint32_t mask, bool on) = 0;
+
+        /*!
+            @return the sink the loop renders into (the DAC)
+        */
+        virtual DsfAudioSink &dac() = 0;
+
+        /*!
+            @brief once per pass of the loop: brings asynchronous inputs up to date (e.g. filters new ADC conversions)
+        */
+        virtual void poll() {}
+
+        /*!
+            @brief takes the next input that has arrived, between blocks
+
+            @return `false` when there is none
+        */
+        virtual bool pollInput(dsf_input_t &in) = 0;
+
+        /*!
+            @brief asks the other core to render its part of an `n`-sample span
+
+            @return `false` if there is no other core; the caller renders everything itself
+        */
+        virtual bool core1Start(size_t n)
+        {
+            (void)n;
+            return false;
+        }
+
+        /*!
+            @brief waits for the part started by `core1Start()`
+        */
+        virtual void core1Wait() {}
+
+        /*!
+            @brief deadline hooks, see `DsfDeadlineMonitor`
+        */
+        virtual void stageStart() {}
+        virtual void stageEnd(uint8_t stage) { (void)stage; }
+        virtual void blockStart() {}
+        virtual void blockEnd(int32_t slack) { (void)slack; }
+};
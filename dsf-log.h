@@ -0,0 +1,159 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Deferred Log
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Diagnostics without printf in time-critical code: interrupt
+ * handlers and the render loop push a compact record (format
+ * string and integer arguments) into a lock-free ring, and a
+ * low-priority task formats and emits the records later.
+ * Producers never wait; a full ring drops the record and
+ * counts it, and the count is reported in the output.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+/*
+ * LOG SETTINGS
+ */
+#define DSF_LOG_ARGS 6 // integer arguments per record
+#define DSF_LOG_LINE 96 // longest formatted line, without the line ending
+
+/*!
+    @brief one deferred `printf()` call
+
+    @param fmt the format: a string literal, which lives in flash as long as the program, so the pointer identifies it
+    @param args its arguments, all integers
+*/
+typedef struct {
+    const char *fmt;
+    int32_t args[DSF_LOG_ARGS];
+} dsf_log_record_t;
+
+/*!
+    @brief Deferred log with one wait-free SPSC ring per producer context.
+
+    The Cortex-M0+ has no atomic read-modify-write, so several producers can't share one lock-free ring. Instead each
+    context that logs (e.g. the main loop, GPIO interrupts, the other core) gets its own channel, and `log()` may only
+    be called for a channel from that one context. The rings work like `DsfMidiQueue`: the producer owns `head`, the
+    consumer owns `tail`, and both publish with release stores. `format()` is the single consumer: it takes the channels
+    in turn, so records of one channel stay in order but those of different channels may interleave out of time order.
+
+    A `log()` call stores a pointer and `DSF_LOG_ARGS` words; the formatting, and the time the output takes, happen
+    wherever `format()` is called. Formats may only use integer conversions (`%d`, `%u`, `%x`, `%c`, with flags and
+    widths); every argument is passed to `snprintf()` as an `int32_t`.
+
+    @tparam CHANNELS number of producer contexts
+    @tparam SIZE records per channel, a power of two
+*/
+template <uint8_t CHANNELS, uint16_t SIZE>
+class DsfLog {
+
+    static_assert(CHANNELS > 0, "the log needs at least one channel");
+    static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0, "the ring size must be a power of two");
+
+    public:
+        bool log(uint8_t channel, const char *fmt, int32_t a0 = 0, int32_t a1 = 0, int32_t a2 = 0, int32_t a3 = 0,
+                 int32_t a4 = 0, int32_t a5 = 0);
+        size_t format(char *line, size_t len);
+
+        /*!
+            @return records `log()` dropped on `channel` because its ring was full
+        */
+        uint32_t dropped(uint8_t channel) const { return ch[channel].drops.load(std::memory_order_relaxed); }
+
+        /*!
+            @return records `log()` accepted on `channel` so far
+        */
+        uint32_t logged(uint8_t channel) const { return ch[channel].head.load(std::memory_order_relaxed); }
+
+    private:
+        struct channel_t {
+            dsf_log_record_t slots[SIZE];
+            std::atomic<uint32_t> head{ 0 }, tail{ 0 }, drops{ 0 };
+            uint32_t reported = 0; // drops already reported by format(); consumer only
+        };
+
+        channel_t ch[CHANNELS];
+        uint8_t turn = 0; // channel format() looks at first
+};
+
+/*!
+    @brief queues a record; call for each channel from one context only
+
+    @param channel the calling context's channel
+    @param fmt `printf()` format with integer conversions only; must stay valid until formatted (use a literal)
+    @param a0 ... a5 the arguments; unused ones are ignored
+    @return `false` if the channel's ring was full and the record was dropped (counted in `dropped()`)
+*/
+template <uint8_t CHANNELS, uint16_t SIZE>
+bool DsfLog<CHANNELS, SIZE>::log(uint8_t channel, const char *fmt, int32_t a0, int32_t a1, int32_t a2, int32_t a3,
+                                 int32_t a4, int32_t a5)
+{
+    channel_t &c = ch[channel];
+    uint32_t h = c.head.load(std::memory_order_relaxed);
+    if (h - c.tail.load(std::memory_order_acquire) >= SIZE) {
+        // only this channel's producer writes the counter, so a load and a store are enough
+        c.drops.store(c.drops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+    dsf_log_record_t &r = c.slots[h & (SIZE - 1)];
+    r.fmt = fmt;
+    r.args[0] = a0;
+    r.args[1] = a1;
+    r.args[2] = a2;
+    r.args[3] = a3;
+    r.args[4] = a4;
+    r.args[5] = a5;
+    c.head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+/*!
+    @brief formats the next record, or a notice of records dropped since the last one; the consumer side
+
+    A channel's drops are reported once its ring has run empty, after the records that were already queued, as
+    `log: N records dropped on channel C`.
+
+    @param line receives the text, without a line ending, always terminated
+    @param len size of `line`; longer lines are cut
+    @return the length of the text in `line`, 0 if there was nothing to format
+*/
+template <uint8_t CHANNELS, uint16_t SIZE>
+size_t DsfLog<CHANNELS, SIZE>::format(char *line, size_t len)
+{
+    if (len == 0) return 0;
+    for (uint8_t i = 0; i < CHANNELS; i++) {
+        uint8_t n = turn;
+        turn = (turn + 1 < CHANNELS) ? turn + 1 : 0;
+        channel_t &c = ch[n];
+
+        int written = 0;
+        uint32_t t = c.tail.load(std::memory_order_relaxed);
+        uint32_t drops = c.drops.load(std::memory_order_relaxed);
+        if (t != c.head.load(std::memory_order_acquire)) {
+            const dsf_log_record_t &r = c.slots[t & (SIZE - 1)];
+            written = snprintf(line, len, r.fmt, r.args[0], r.args[1], r.args[2], r.args[3], r.args[4], r.args[5]);
+            c.tail.store(t + 1, std::memory_order_release);
+        } else if (drops != c.reported) {
+            // the ring is empty, so every drop counted so far happened before anything still to come
+            written = snprintf(line, len, "log: %u records dropped on channel %u", (unsigned)(drops - c.reported),
+                               (unsigned)n);
+            c.reported = drops;
+        } else {
+            continue;
+        }
+        if (written < 0) written = 0;
+        return ((size_t)written < len) ? (size_t)written : len - 1;
+    }
+    return 0;
+}
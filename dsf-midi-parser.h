@@ -0,0 +1,198 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * MIDI Stream Parser
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Incremental MIDI 1.0 byte-stream decoder: feed it bytes as
+ * they arrive, in chunks of any size, and it hands out every
+ * complete channel message. Handles running status, real-time
+ * bytes in the middle of a message, SysEx and system common
+ * messages, and stray data bytes. No allocation, a few bytes
+ * of state.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-midi-queue.h"
+
+/*
+ * PARSER SETTINGS
+ */
+#define DSF_MIDI_OMNI 0xFF // setChannel() value that accepts every channel
+
+/*!
+    @brief Incremental MIDI 1.0 stream parser.
+
+    Only channel voice messages (0x8n-0xEn) are emitted; SysEx, system common and real-time messages are consumed and
+    dropped, except that SysEx messages can be collected into a buffer given to `captureSysEx()`. Running status is kept
+    across channel messages, cleared by SysEx and system common messages and left alone by real-time bytes (0xF8-0xFF),
+    which may appear anywhere, even between the data bytes of a message. A data byte with no status to belong to, or a
+    message cut short by a new status byte, is dropped and counted in `errors()`.
+*/
+class DsfMidiParser {
+
+    public:
+        /*!
+            @brief decodes one byte
+
+            @param byte the next byte of the stream
+            @param e receives the message when one is complete; `e.time` is left unchanged
+            @return `true` if `e` holds a new message
+        */
+        inline bool feed(uint8_t byte, dsf_midi_event_t &e)
+        {
+            if (byte >= 0xF8) return false; // real-time: no effect on the message in progress
+
+            if (byte & 0x80) {
+                if (have < need) errorCount += (have > 0);
+                if (inSysEx && sxFill) {
+                    // F7 completes the capture; any other status byte cuts the message short
+                    if (byte == 0xF7 && sxLen < sxSize) {
+                        sxBuf[sxLen++] = byte;
+                        sxDone = true;
+                    }
+                    sxFill = false;
+                }
+                if (byte < 0xF0) {
+                    status = byte;
+                    need = dataBytes(byte);
+                } else {
+                    // SysEx and system common: skip their data bytes and forget the running status
+                    status = 0;
+                    need = 0;
+                    inSysEx = (byte == 0xF0);
+                    skip = (byte == 0xF2) ? 2 : (byte == 0xF1 || byte == 0xF3) ? 1 : 0;
+                    if (inSysEx && sxBuf && !sxDone) {
+                        sxBuf[0] = byte;
+                        sxLen = 1;
+                        sxFill = true;
+                    }
+                }
+                have = 0;
+                return false;
+            }
+
+            if (status == 0) {
+                if (skip > 0) skip--;
+                else if (!inSysEx) errorCount++;
+                else if (sxFill) {
+                    if (sxLen < sxSize) sxBuf[sxLen++] = byte;
+                    else sxFill = false; // too long for the buffer: dropped
+                }
+                return false;
+            }
+
+            data[have++] = byte;
+            if (have < need) return false;
+            have = 0; // running status: the next data byte starts another message
+
+            if (channel != DSF_MIDI_OMNI && (status & 0x0F) != channel) return false;
+            e.status = status;
+            e.data1 = data[0];
+            e.data2 = (need > 1) ? data[1] : 0;
+            return true;
+        }
+
+        /*!
+            @brief decodes a chunk of the stream and hands every complete message to `emit`
+
+            @param bytes the next bytes of the stream
+            @param n the number of bytes
+            @param time timestamp given to every message in the chunk, e.g. the audio sample clock when it arrived
+            @param emit called as `emit(const dsf_midi_event_t &)` for each message
+            @return the number of messages emitted
+        */
+        template <typename F>
+        size_t parse(const uint8_t *bytes, size_t n, uint32_t time, F emit)
+        {
+            size_t count = 0;
+            dsf_midi_event_t e;
+            e.time = time;
+            for (size_t i = 0; i < n; i++) {
+                if (feed(bytes[i], e)) {
+                    emit(e);
+                    count++;
+                }
+            }
+            return count;
+        }
+
+        /*!
+            @brief only emit messages on one channel
+
+            @param ch MIDI channel 0-15, or `DSF_MIDI_OMNI` (the default) for all channels
+        */
+        void setChannel(uint8_t ch) { channel = (ch < 16) ? ch : DSF_MIDI_OMNI; }
+
+        /*!
+            @brief collects SysEx messages into `buf`, e.g. for tuning dumps; `nullptr` turns it off
+
+            A message is kept from `F0` to `F7` when it fits; a longer one, or one cut short by another status byte, is
+            dropped. Once one is complete (see `sysEx()`) later ones are dropped until `releaseSysEx()`.
+
+            @param buf the buffer, owned by the caller
+            @param size its size in bytes
+        */
+        void captureSysEx(uint8_t *buf, size_t size)
+        {
+            sxBuf = buf;
+            sxSize = buf ? size : 0;
+            sxLen = 0;
+            sxFill = sxDone = false;
+        }
+
+        /*!
+            @return the length of the complete SysEx message in the capture buffer, `F0` and `F7` included; 0 if none
+        */
+        size_t sysEx() const { return sxDone ? sxLen : 0; }
+
+        /*!
+            @brief frees the capture buffer for the next SysEx message
+        */
+        void releaseSysEx()
+        {
+            sxLen = 0;
+            sxDone = false;
+        }
+
+        /*!
+            @brief forgets the message in progress and the running status, e.g. after a device is plugged in
+        */
+        void reset()
+        {
+            status = 0;
+            have = need = skip = 0;
+            inSysEx = false;
+            sxFill = false;
+        }
+
+        /*!
+            @return stray data bytes and truncated messages dropped so far
+        */
+        uint32_t errors() const { return errorCount; }
+
+        /*!
+            @return the number of data bytes a channel message with status `s` carries
+        */
+        static inline uint8_t dataBytes(uint8_t s) { return ((s & 0xE0) == 0xC0) ? 1 : 2; }
+
+    private:
+        uint32_t errorCount = 0;
+        uint8_t status = 0, data[2] = { 0, 0 }, have = 0, need = 0, skip = 0;
+        uint8_t channel = DSF_MIDI_OMNI;
+        bool inSysEx = false;
+        // SysEx capture, see captureSysEx()
+        uint8_t *sxBuf = nullptr;
+        size_t sxSize = 0, sxLen = 0;
+        bool sxFill = false, sxDone = false;
+};
@@ -0,0 +1,131 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * MIDI Event Queue
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Single-producer/single-consumer ring that carries MIDI
+ * messages from the USB host task on core 1 to the audio
+ * side on core 0. Neither side ever waits: a full queue
+ * drops the message and counts it, an empty one returns
+ * nothing. The consumer applies messages between render
+ * spans (at their timestamps, see `DsfSynth::applyDue()`),
+ * so a message is never applied while a span is rendering.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/*!
+    @brief one complete MIDI channel message
+
+    @param status status byte, including the channel
+    @param data1 first data byte (note, controller, bend LSB)
+    @param data2 second data byte (velocity, value, bend MSB), 0 for one-byte messages
+    @param time when it arrived, on the audio sample clock (see `DsfSynth::applyDue()`); 0 if unused
+*/
+typedef struct {
+    uint8_t status, data1, data2;
+    uint32_t time;
+} dsf_midi_event_t;
+
+/*!
+    @brief Wait-free SPSC queue of `dsf_midi_event_t`.
+
+    `push()` may only be called from one context (the producer) and `pop()` from one other (the consumer). The
+    producer owns `head`, the consumer owns `tail`; each publishes its index with a release store after touching the
+    slot and reads the other's with an acquire load, so a popped message is always the complete message that was
+    pushed. Indices run freely and wrap at 2^32, which `SIZE` divides. Only loads and stores are used, no
+    read-modify-write, so nothing needs the atomic helpers the Cortex-M0+ lacks.
+
+    @tparam SIZE number of slots, a power of two
+*/
+template <uint16_t SIZE>
+class DsfMidiQueue {
+
+    static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0, "the queue size must be a power of two");
+
+    public:
+        bool push(const dsf_midi_event_t &e);
+        bool pop(dsf_midi_event_t &e);
+        bool peek(dsf_midi_event_t &e) const;
+
+        /*!
+            @return messages waiting; exact from the consumer, a snapshot from anywhere else
+        */
+        uint32_t size() const
+        {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+
+        /*!
+            @return messages dropped by `push()` because the queue was full
+        */
+        uint32_t overflows() const { return dropped.load(std::memory_order_relaxed); }
+
+        /*!
+            @return messages accepted by `push()` so far
+        */
+        uint32_t pushed() const { return head.load(std::memory_order_relaxed); }
+
+    private:
+        dsf_midi_event_t slots[SIZE];
+        std::atomic<uint32_t> head{ 0 }, tail{ 0 }, dropped{ 0 };
+};
+
+/*!
+    @brief queues a message; producer side only
+
+    @param e the message
+    @return `false` if the queue was full and the message was dropped (counted in `overflows()`)
+*/
+template <uint16_t SIZE>
+bool DsfMidiQueue<SIZE>::push(const dsf_midi_event_t &e)
+{
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= SIZE) {
+        // only the producer writes the counter, so a load and a store are enough
+        dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+    slots[h & (SIZE - 1)] = e;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+/*!
+    @brief takes the oldest message; consumer side only
+
+    @param e receives the message
+    @return `false` if the queue was empty
+*/
+template <uint16_t SIZE>
+bool DsfMidiQueue<SIZE>::pop(dsf_midi_event_t &e)
+{
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    e = slots[t & (SIZE - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+/*!
+    @brief reads the oldest message without taking it; consumer side only
+
+    @param e receives the message
+    @return `false` if the queue was empty
+*/
+template <uint16_t SIZE>
+bool DsfMidiQueue<SIZE>::peek(dsf_midi_event_t &e) const
+{
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    e = slots[t & (SIZE - 1)];
+    return true;
+}
@@ -0,0 +1,111 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * MIDI Note Map
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Equal-tempered MIDI note frequencies and the carrier/
+ * modulator choices of the example's Standard and Strange Modes, shared by the
+ * firmware and the host tools so both play a note the same
+ * way.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "inc/fix15.h"
+
+/*
+ * NOTE TABLES
+ */
+constexpr fix15 root2 = float2fix15(1.4142135624);
+constexpr uint8_t strangeModeRoots[8] = { 60, 62, 64, 65, 67, 69, 70, 71 }; // threw in Bb because jazz
+constexpr fix15 modFactor15[2] = { divfix15(int2fix15(1), int2fix15(2)), int2fix15(2) };
+
+/*!
+    @brief equal-tempered MIDI note frequencies, `440 * 2^((note - 69) / 12)` Hz, generated at compile time
+
+    Evaluated in double precision (a Taylor series for the fraction of an octave) and rounded once, into Q16.16 for
+    `DsfTuning` and into fix15. The old table of frequencies rounded to two decimals was up to 0.9 cents off at the bottom
+    of the range.
+
+    @tparam T the value type
+    @tparam FRAC fraction bits of the result: 16 or 15
+*/
+template <typename T, int FRAC>
+struct dsf_midi_table_t {
+    T v[128];
+
+    constexpr dsf_midi_table_t() : v()
+    {
+        constexpr double ln2 = 0.69314718055994530942;
+        for (int i = 0; i < 128; i++) {
+            // 2^((i - 69) / 12) as 2^octaves * 2^(semis / 12), with 0 <= semis < 12
+            int semis = i + 3, octaves = semis / 12 - 6;
+            semis %= 12;
+            double x = ln2 * (double)semis / 12.0, term = 1.0, sum = 1.0;
+            for (int n = 1; n < 16; n++) {
+                term *= x / (double)n;
+                sum += term;
+            }
+            double hz = 440.0 * sum;
+            for (int o = 0; o < octaves; o++) hz *= 2.0;
+            for (int o = 0; o > octaves; o--) hz /= 2.0;
+            v[i] = (T)(hz * (double)(1 << FRAC) + 0.5);
+        }
+    }
+
+    constexpr T operator[](size_t note) const { return v[note]; }
+};
+
+/*!
+    @brief equal-tempered note frequencies in Q16.16 Hz, the default `DsfTuning`
+*/
+inline constexpr dsf_midi_table_t<uint32_t, 16> midiFreq16{};
+
+/*!
+    @brief equal-tempered note frequencies in fix15 Hz
+*/
+inline constexpr dsf_midi_table_t<fix15, 15> midiFreq15{};
+
+/*!
+    @brief how a note is turned into carrier and modulator frequencies
+
+    @param strange Strange Mode: the carrier is fixed at `strangeModeRoots[strangeKey]` and the note is the modulator
+    @param strangeKey index into `strangeModeRoots`, 0..7
+    @param harmonic Standard Mode: when false the modulator is also multiplied by `root2` (inharmonic)
+    @param mult Standard Mode: modulator at double (true) or half (false) the note
+*/
+typedef struct {
+    bool strange;
+    uint8_t strangeKey;
+    bool harmonic, mult;
+} dsf_note_mode_t;
+
+/*!
+    @brief carrier and modulator frequencies for `note` in the given mode
+
+    @param note MIDI note number
+    @param mode Standard or Strange Mode settings
+    @param freqNote receives the fixed-point carrier frequency
+    @param freqMod receives the fixed-point modulator frequency
+*/
+static inline void noteFreqs(uint8_t note, const dsf_note_mode_t &mode, fix15 &freqNote, fix15 &freqMod)
+{
+    note &= 0x7F;
+    if (mode.strange) {
+        freqNote = midiFreq15[strangeModeRoots[mode.strangeKey & 0x07]];
+        freqMod = midiFreq15[note];
+    } else {
+        freqNote = midiFreq15[note];
+        freqMod = multfix15(midiFreq15[note], multfix15(modFactor15[mode.mult], (mode.harmonic ? int2fix15(1) : root2)));
+    }
+}
@@ -20,33 +20,48 @@
 /*!
     @brief Constructor.
 
-    Sets up the fixed-point sine tables and basic state variables
+    Sets up the basic state variables. The sine table is generated at compile time and shared by every instance, so 
+    constructing an oscillator costs a few stores.
 
     @param sample_rate the sample rate of the calling timer, in Hz.
     @param dac_bit_depth the number of bits (e.g., 12) in the DAC used by the calling program.
 */
-DsfOsc::DsfOsc (uint16_t sample_rate, uint8_t dac_bit_depth)
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+DsfOscT<P, TABLE_BITS, LOOKUP>::DsfOscT (uint16_t sample_rate, uint8_t dac_bit_depth)
 {
     fs = sample_rate;
     dacbits = dac_bit_depth;    
-    halfDac = float2fix15(((float)((1 << dacbits) - 1) / 2.0));
-
-    for (uint t = 0; t < 256; t++) {
-        table_sine[t] = float2fix15(table_sine_f[t]);
-        table_cosine[t] = float2fix15(table_cosine_f[t]);
-    }
-    
+    stepScale = phaseScale(fs);
+    halfDac = P::dacScale(float2fix15(((float)((1 << dacbits) - 1) / 2.0)));
 }
 
 /*!
     @brief resets the oscillator count for carrier and modulator to zero.
 */
-void DsfOsc::resetCount()
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::resetCount()
 {
     countNote = 0;
     countMod = 0;
 }
 
+/*!
+    @brief precomputes the frequency-to-increment scale for `phaseStep()`
+
+    This is the only division on the frequency path and runs once per sample rate (in the constructor), so note changes, 
+    bends and glides never touch soft-float or the divider.
+
+    @param sample_rate the sample rate in Hz, above 512 (any audio rate, 8000 and up in practice); lower rates are raised
+           to `DSF_MIN_SAMPLE_RATE`, since `2^41 / 512` is `2^32` and would truncate to 0
+    @return `2^41 / sample_rate`
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+uint32_t DsfOscT<P, TABLE_BITS, LOOKUP>::phaseScale(uint16_t sample_rate)
+{
+    if (sample_rate < DSF_MIN_SAMPLE_RATE) sample_rate = DSF_MIN_SAMPLE_RATE;
+    return (uint32_t)((1ull << 41) / sample_rate);
+}
+
 /*!
     @brief sets the carrier and modulation frequencies for the oscillator
 
@@ -54,13 +69,17 @@ void DsfOsc::resetCount()
     @param freqMod the fixed-point frequency for the modulator
     @param reset resets the frequency counters; defaults true
 */
-void DsfOsc::freqs(fix15 freqNote, fix15 freqMod, bool reset) 
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::freqs(fix15 freqNote, fix15 freqMod, bool reset) 
 {
     fn = freqNote;
     fm = freqMod;
 
-    stepNote = (fix2float15(fn) * two32) / (float)fs;
-    stepMod = (fix2float15(fm) * two32) / (float)fs;
+    baseNote = phaseStep(fn, stepScale);
+    baseMod = phaseStep(fm, stepScale);
+    stepNote = pitchStep(baseNote, pitchOffset);
+    stepMod = pitchStep(baseMod, pitchOffset);
+    updateHarmonics();
 
     if (reset) resetCount();
 }
@@ -72,15 +91,127 @@ void DsfOsc::freqs(fix15 freqNote, fix15 freqMod, bool reset)
     @param freqMod the fixed-point frequency for the modulator
     @param reset resets the frequency counters; defaults false
 */
-void DsfOsc::freqs(fix15 freqMod, bool reset)
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::freqs(fix15 freqMod, bool reset)
 {
     fm = freqMod;
 
-    stepMod = (fix2float15(fm) * two32) / fs;
+    baseMod = phaseStep(fm, stepScale);
+    stepMod = pitchStep(baseMod, pitchOffset);
+    updateHarmonics();
 
     if (reset) resetCount();
 }
 
+/*!
+    @brief shifts the pitch of carrier and modulator together (pitch bend, glide, vibrato)
+
+    The offset is exponential and applied to both increments, so the carrier/modulator ratio and therefore the timbre are 
+    kept. It costs two `pitchStep()` calls (integer multiplies and shifts) and can be called every sample or once per block; 
+    the offset stays in effect across `freqs()` calls until it is changed.
+
+    @param octaves16 pitch offset in Q16 octaves (`65536` = one octave up, `0` = no offset); see `bendToOct16()`
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::pitch(int32_t octaves16)
+{
+    pitchOffset = octaves16;
+    stepNote = pitchStep(baseNote, octaves16);
+    stepMod = pitchStep(baseMod, octaves16);
+    updateHarmonics();
+}
+
+/*!
+    @brief switches between the infinite sum (default) and Moorer's finite sum with N sidebands on each side
+
+    The infinite sum has partials at `fn ± k * fm` for every k, so high notes and large `a` fold partials above Nyquist back
+    into the audio band. The finite sum stops at the largest N that keeps `fn + N * fm` below Nyquist; N is chosen from the
+    current increments whenever `freqs()` or `pitch()` changes them. Its numerator is
+    `sin(θ) * (1 - a^2 - 2 a^(N+1) (cos((N+1)β) - a cos(Nβ)))`; `a^(N+1)` is calculated when `a` or N changes, so the extra
+    per-sample cost is two table lookups and two multiplies (see `bandTail()`).
+
+    @param on `true` for the band-limited finite sum
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::setBandLimited(bool on)
+{
+    bandLimited = on;
+    updateHarmonics();
+}
+
+/*!
+    @brief recalculates the sideband count after the increments changed (band-limited mode only)
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::updateHarmonics()
+{
+    if (!bandLimited) return;
+    uint32_t n = harmonics(stepNote, stepMod);
+    if (n == bandN) return;
+    bandN = n;
+    bandA = -1; // a^(N+1) has to be recalculated
+}
+
+/*!
+    @brief `a^e` by repeated squaring (at most `2 * log2(e)` multiplies); negligible results are flushed to 0
+
+    @param a base, `0 <= a < 1`
+    @param e exponent
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+typename P::value_t DsfOscT<P, TABLE_BITS, LOOKUP>::powA(value_t a, uint32_t e)
+{
+    value_t result = P::one;
+    while (e) {
+        if (e & 1) result = P::mul(result, a);
+        a = P::mul(a, a);
+        e >>= 1;
+    }
+    return P::flush(result);
+}
+
+/*!
+    @return `a^(N+1)` for the current sideband count, recalculated only when `a` or N changed since the last call
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+typename P::value_t DsfOscT<P, TABLE_BITS, LOOKUP>::bandPower(value_t a)
+{
+    if (a != bandA) {
+        bandA = a;
+        aPowN1 = powA(a, bandN + 1);
+    }
+    return aPowN1;
+}
+
+/*!
+    @brief limits `a` to the range `param_a_min15 <= a <= param_a_max15` and converts it to the policy's format
+
+    @param param_a the `a` term from Moorer's equation
+    @return the clamped value
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+inline typename P::value_t DsfOscT<P, TABLE_BITS, LOOKUP>::clampA(fix15 param_a)
+{
+    if (param_a > param_a_max15) return P::fromFix15(param_a_max15);
+    if (param_a < param_a_min15) return P::fromFix15(param_a_min15);
+    return P::fromFix15(param_a);
+}
+
+/*!
+    @brief selects how the division in Moorer's formula is evaluated
+
+    `kernel_divide` (the default) uses `divfix15()`, a full 64-bit division per sample. `kernel_reciprocal` replaces it with 
+    a small seed table and two Newton-Raphson steps (multiplies only); see `recipdivfix15()` for the error bound. Only the 
+    fix15 policy has the reciprocal kernel; the others divide either way.
+
+    @param k the kernel used by `getNextSample()` and `renderBlock()`
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::setKernel(dsf_kernel_t k)
+{
+    kernel = k;
+}
+
 /*!
     @brief generates the next sample of the synthesized wave
 
@@ -91,29 +222,259 @@ void DsfOsc::freqs(fix15 freqMod, bool reset)
     @return a 16-bit integer value that can be passed directly to the DAC (assuming dac_bits is set correctly)
 
 */
-uint16_t DsfOsc::getNextSample(fix15 param_a)
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+uint16_t DsfOscT<P, TABLE_BITS, LOOKUP>::getNextSample(fix15 param_a)
 {
 
-    fix15 param_a_safe;
+    value_t param_a_safe = clampA(param_a);
 
-    if (param_a > param_a_max15) {
-        param_a_safe = param_a_max15;
-    } else if (param_a < param_a_min15) {
-        param_a_safe = param_a_min15;
-    } else {
-        param_a_safe = param_a;
-    }
+    value_t a_squared = P::mul(param_a_safe, param_a_safe);
 
-    fix15 a_squared = multfix15(param_a_safe, param_a_safe);
+    value_t numScale = P::one - a_squared;
+    if (bandLimited) {
+        value_t aN1 = bandPower(param_a_safe);
+        numScale -= bandTail(countMod, bandN, aN1, P::mul(aN1, param_a_safe));
+    }
 
-    fix15 sample = divfix15((multfix15((one15 - a_squared), table_sine[countNote >> 24])), 
-                            ((one15 + a_squared) - (multfix15((multfix15(two15, param_a_safe)), table_cosine[countMod >> 24]))));
+    value_t sine_note = sine(countNote);
+    value_t denominator = (P::one + a_squared) - P::mul(param_a_safe + param_a_safe, cosine(countMod));
 
-    fix15 dacValue = multfix15(sample, halfDac) + halfDac;
+    value_t sample;
+    if (kernel == kernel_reciprocal) {
+        sample = bandLimited ? P::template quotient<kernel_reciprocal, true>(numScale, sine_note, denominator)
+                             : P::template quotient<kernel_reciprocal, false>(numScale, sine_note, denominator);
+    } else {
+        sample = bandLimited ? P::template quotient<kernel_divide, true>(numScale, sine_note, denominator)
+                             : P::template quotient<kernel_divide, false>(numScale, sine_note, denominator);
+    }
 
     countNote += stepNote;
     countMod += stepMod;
 
-    return (uint16_t)fix2int15(dacValue);
+    return P::toDac(sample, halfDac);
+}
+
+/*!
+    @brief renders a block of samples with a constant `a`
+
+    Produces exactly the same values as calling `getNextSample(param_a)` `n` times, but the clamp and every `a`-dependent 
+    term (`a^2`, `1 - a^2`, `1 + a^2` and `2a`) are calculated once per block and the counters live in registers for the 
+    duration of the loop.
+
+    @param out caller-supplied buffer of at least `n` samples
+    @param n the number of samples to render
+    @param param_a the `a` term from Moorer's equation, clamped the same way as in `getNextSample()`
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::renderBlock(uint16_t *out, size_t n, fix15 param_a)
+{
+    value_t a = clampA(param_a);
+    if (kernel == kernel_reciprocal) {
+        if (bandLimited) renderConst<kernel_reciprocal, true>(out, n, a);
+        else renderConst<kernel_reciprocal, false>(out, n, a);
+    } else {
+        if (bandLimited) renderConst<kernel_divide, true>(out, n, a);
+        else renderConst<kernel_divide, false>(out, n, a);
+    }
+}
+
+/*!
+    @brief renders a block of samples while ramping `a` linearly
+
+    Both ends of the ramp are clamped once, so every value in between is already in range. `a` advances by 
+    `(param_a_end - param_a_start) / n` per sample; `a^2` is tracked exactly with two running differences 
+    (the second difference of a linear ramp squared is the constant `2 * step^2`), so the inner loop has no 
+    extra multiplies and each sample matches `getNextSample()` called with the same `a`. In band-limited mode that holds
+    only for the infinite-sum terms: `a^(N+1)` and `a^(N+2)` are calculated at both ends of the block and interpolated
+    linearly in between (`renderRamp()`), so the finite-sum correction is an approximation there, exact at the first
+    sample and close while the block's change of `a` is small.
+
+    @param out caller-supplied buffer of at least `n` samples
+    @param n the number of samples to render
+    @param param_a_start the `a` term used for the first sample
+    @param param_a_end the `a` term the ramp heads towards; pass this as `param_a_start` of the next block
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::renderBlock(uint16_t *out, size_t n, fix15 param_a_start, fix15 param_a_end)
+{
+    if (n == 0) return;
+
+    value_t a = clampA(param_a_start);
+    value_t step = (clampA(param_a_end) - a) / (value_t)n;
+
+    if (kernel == kernel_reciprocal) {
+        if (bandLimited) {
+            if (step == 0) renderConst<kernel_reciprocal, true>(out, n, a);
+            else renderRamp<kernel_reciprocal, true>(out, n, a, step);
+        } else {
+            if (step == 0) renderConst<kernel_reciprocal, false>(out, n, a);
+            else renderRamp<kernel_reciprocal, false>(out, n, a, step);
+        }
+    } else {
+        if (bandLimited) {
+            if (step == 0) renderConst<kernel_divide, true>(out, n, a);
+            else renderRamp<kernel_divide, true>(out, n, a, step);
+        } else {
+            if (step == 0) renderConst<kernel_divide, false>(out, n, a);
+            else renderRamp<kernel_divide, false>(out, n, a, step);
+        }
+    }
+}
+
+/*!
+    @brief renders a block of samples with a per-sample pitch offset (exponential FM, audio-rate vibrato)
+
+    Sample `i` is played at `pitch16[i]` octaves from the frequencies set with `freqs()`, exactly as if `pitch(pitch16[i])` 
+    were called before each `getNextSample(param_a)`. The last offset stays in effect after the block.
+
+    @param out caller-supplied buffer of at least `n` samples
+    @param n the number of samples to render
+    @param param_a the `a` term from Moorer's equation, clamped the same way as in `getNextSample()`
+    @param pitch16 `n` pitch offsets in Q16 octaves
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::renderBlock(uint16_t *out, size_t n, fix15 param_a, const int32_t *pitch16)
+{
+    if (n == 0) return;
+
+    value_t a = clampA(param_a);
+    if (kernel == kernel_reciprocal) {
+        if (bandLimited) renderPitch<kernel_reciprocal, true>(out, n, a, pitch16);
+        else renderPitch<kernel_reciprocal, false>(out, n, a, pitch16);
+    } else {
+        if (bandLimited) renderPitch<kernel_divide, true>(out, n, a, pitch16);
+        else renderPitch<kernel_divide, false>(out, n, a, pitch16);
+    }
+
+    pitch(pitch16[n - 1]);
+}
+
+/*!
+    @brief inner loop of `renderBlock()` for a constant, already clamped `a`
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+template <dsf_kernel_t K, bool BAND>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::renderConst(uint16_t *out, size_t n, value_t a)
+{
+    value_t a_squared = P::mul(a, a);
+    value_t numScale = P::one - a_squared,
+            denBase = P::one + a_squared,
+            twoA = a + a;
+    value_t aN1 = BAND ? bandPower(a) : 0, aN2 = P::mul(aN1, a);
+    const uint32_t bands = bandN;
+
+    uint32_t cNote = countNote, cMod = countMod;
+
+    for (size_t i = 0; i < n; i++) {
+        value_t num = BAND ? numScale - bandTail(cMod, bands, aN1, aN2) : numScale;
+        value_t sample = P::template quotient<K, BAND>(num, sine(cNote), 
+                                                       (denBase - P::mul(twoA, cosine(cMod))));
+        out[i] = P::toDac(sample, halfDac);
+        cNote += stepNote;
+        cMod += stepMod;
+    }
+
+    countNote = cNote;
+    countMod = cMod;
+}
+
+/*!
+    @brief inner loop of `renderBlock()` for a linear ramp of an already clamped `a`
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+template <dsf_kernel_t K, bool BAND>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::renderRamp(uint16_t *out, size_t n, value_t a, value_t step)
+{
+    dsf_square_ramp_t<P> square(a, step);
+
+    // a^(N+1) and a^(N+2) are calculated at both ends of the ramp and interpolated in between
+    value_t aN1 = 0, aN2 = 0, aN1Step = 0, aN2Step = 0;
+    const uint32_t bands = bandN;
+    if (BAND) {
+        value_t aLast = a + step * (value_t)(n - 1);
+        value_t aN1Last = powA(aLast, bands + 1);
+        aN1 = bandPower(a);
+        aN2 = P::mul(aN1, a);
+        if (n > 1) {
+            aN1Step = (aN1Last - aN1) / (value_t)(n - 1);
+            aN2Step = (P::mul(aN1Last, aLast) - aN2) / (value_t)(n - 1);
+        }
+    }
+
+    uint32_t cNote = countNote, cMod = countMod;
+
+    for (size_t i = 0; i < n; i++) {
+        value_t a_squared = square.value();
+        value_t num = P::one - a_squared;
+        if (BAND) {
+            num -= bandTail(cMod, bands, aN1, aN2);
+            aN1 += aN1Step;
+            aN2 += aN2Step;
+        }
+        value_t sample = P::template quotient<K, BAND>(num, sine(cNote), 
+                                                       ((P::one + a_squared) - P::mul(a + a, cosine(cMod))));
+        out[i] = P::toDac(sample, halfDac);
+        cNote += stepNote;
+        cMod += stepMod;
+
+        a += step;
+        square.next();
+    }
+
+    countNote = cNote;
+    countMod = cMod;
+}
+
+/*!
+    @brief inner loop of `renderBlock()` for a constant, already clamped `a` and per-sample pitch offsets
+*/
+template <class P, uint8_t TABLE_BITS, dsf_lookup_t LOOKUP>
+template <dsf_kernel_t K, bool BAND>
+void DsfOscT<P, TABLE_BITS, LOOKUP>::renderPitch(uint16_t *out, size_t n, value_t a, const int32_t *pitch16)
+{
+    value_t a_squared = P::mul(a, a);
+    value_t numScale = P::one - a_squared,
+            denBase = P::one + a_squared,
+            twoA = a + a;
+
+    // one sideband count for the whole block, from its highest pitch, so no sample aliases
+    uint32_t bands = 0;
+    value_t aN1 = 0, aN2 = 0;
+    if (BAND) {
+        int32_t highest = pitch16[0];
+        for (size_t i = 1; i < n; i++) {
+            if (pitch16[i] > highest) highest = pitch16[i];
+        }
+        bands = harmonics(pitchStep(baseNote, highest), pitchStep(baseMod, highest));
+        aN1 = powA(a, bands + 1);
+        aN2 = P::mul(aN1, a);
+    }
+
+    uint32_t cNote = countNote, cMod = countMod;
+
+    for (size_t i = 0; i < n; i++) {
+        value_t num = BAND ? numScale - bandTail(cMod, bands, aN1, aN2) : numScale;
+        value_t sample = P::template quotient<K, BAND>(num, sine(cNote), 
+                                                       (denBase - P::mul(twoA, cosine(cMod))));
+        out[i] = P::toDac(sample, halfDac);
+        cNote += pitchStep(baseNote, pitch16[i]);
+        cMod += pitchStep(baseMod, pitch16[i]);
+    }
+
+    countNote = cNote;
+    countMod = cMod;
 }
 
+// the policies and tables the library is built for; see dsf-arith.h and dsf_lookup_t
+template class DsfOscT<dsf_arith_fix15>;
+template class DsfOscT<dsf_arith_fix15, 8, lookup_linear>;
+template class DsfOscT<dsf_arith_fix15, 10>;
+template class DsfOscT<dsf_arith_fix15, 10, lookup_linear>;
+template class DsfOscT<dsf_arith_fix15, 12>;
+template class DsfOscT<dsf_arith_fix15, 12, lookup_linear>;
+template class DsfOscT<dsf_arith_q15>;
+template class DsfOscT<dsf_arith_q15, 12, lookup_linear>;
+template class DsfOscT<dsf_arith_q26>;
+template class DsfOscT<dsf_arith_q26, 12, lookup_linear>;
+template class DsfOscT<dsf_arith_float>;
+template class DsfOscT<dsf_arith_float, 12, lookup_linear>;
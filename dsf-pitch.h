@@ -0,0 +1,197 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Integer Pitch Modulation
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Exponential pitch offsets (bend, glide, FM) applied to the
+ * 32-bit phase increments with integer math only, cheap
+ * enough to run every sample on an FPU-less Cortex-M0+.
+ *
+ * Pitch offsets are signed Q16 octaves: 65536 is one octave
+ * up, -65536/12 is one semitone down.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * PITCH CONSTANTS
+ */
+#define DSF_OCTAVE16 65536 // one octave in Q16 pitch units
+#define DSF_EXP2_BITS 6 // 64 table segments per octave, linearly interpolated
+
+/*!
+    @brief `2^(i / SIZE)` for `i = 0..SIZE` in Q30, generated at compile time
+
+    The extra last entry (`2^1`) lets the interpolation read `v[i + 1]` without a bounds check.
+
+    @tparam SIZE number of segments per octave
+*/
+template <size_t SIZE>
+struct dsf_exp2_table_t {
+    uint32_t v[SIZE + 1];
+
+    constexpr dsf_exp2_table_t() : v()
+    {
+        constexpr double ln2 = 0.69314718055994530942;
+        for (size_t i = 0; i <= SIZE; i++) {
+            double x = ln2 * (double)i / (double)SIZE, term = 1.0, sum = 1.0;
+            for (int n = 1; n < 16; n++) {
+                term *= x / (double)n;
+                sum += term;
+            }
+            v[i] = (uint32_t)(sum * 1073741824.0 + 0.5);
+        }
+    }
+};
+
+inline constexpr dsf_exp2_table_t<(1 << DSF_EXP2_BITS)> dsf_exp2_table{};
+
+/*!
+    @brief scales a phase increment by `2^(octaves16 / 65536)`
+
+    The integer octaves become a shift, the fraction is looked up in `dsf_exp2_table` and interpolated (worst-case error
+    about 0.03 cents). An offset of 0 returns `step` unchanged.
+
+    @param step unmodulated phase increment
+    @param octaves16 pitch offset in Q16 octaves
+    @return modulated phase increment, saturated at the top of the counter range
+*/
+static inline uint32_t pitchStep(uint32_t step, int32_t octaves16)
+{
+    int32_t octaves = octaves16 >> 16; // floor, so the fraction below is always positive
+    uint32_t frac = (uint32_t)octaves16 & 0xFFFF;
+    uint32_t idx = frac >> (16 - DSF_EXP2_BITS), within = frac & ((1u << (16 - DSF_EXP2_BITS)) - 1);
+    uint32_t lo = dsf_exp2_table.v[idx], hi = dsf_exp2_table.v[idx + 1];
+    uint32_t mult = lo + (uint32_t)(((uint64_t)(hi - lo) * within) >> (16 - DSF_EXP2_BITS));
+
+    int32_t shift = 30 - octaves;
+    if (shift <= 0) return UINT32_MAX;
+    if (shift >= 63) return 0;
+    uint64_t scaled = ((uint64_t)step * mult) >> shift;
+    return (scaled > UINT32_MAX) ? UINT32_MAX : (uint32_t)scaled;
+}
+
+/*!
+    @brief the pitch offset from `ref` to `step`, the inverse of `pitchStep()`
+
+    Normalises the ratio to one octave and inverts the same interpolated `dsf_exp2_table`, so
+    `pitchStep(ref, stepToOct16(step, ref))` is within the table's 0.03 cents of `step`. It divides, so it is meant for
+    tables built at load time rather than for every sample.
+
+    @param step a phase increment (or frequency), not 0
+    @param ref the increment (or frequency, in the same units) of pitch offset 0, not 0
+    @return pitch offset in Q16 octaves
+*/
+static inline int32_t stepToOct16(uint32_t step, uint32_t ref)
+{
+    if (step == 0 || ref == 0) return 0;
+    uint64_t s = step, r = ref;
+    int32_t octaves = 0;
+    while (s >= 2 * r) {
+        r <<= 1;
+        octaves++;
+    }
+    while (s < r) {
+        s <<= 1;
+        octaves--;
+    }
+
+    // s / r in [1, 2) as Q30, then the table segment it falls in
+    uint32_t mult = (uint32_t)((s << 30) / r);
+    uint32_t lo = 0, hi = 1u << DSF_EXP2_BITS;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (dsf_exp2_table.v[mid] <= mult) lo = mid;
+        else hi = mid;
+    }
+    uint32_t span = dsf_exp2_table.v[lo + 1] - dsf_exp2_table.v[lo];
+    uint32_t within = (uint32_t)((((uint64_t)(mult - dsf_exp2_table.v[lo]) << (16 - DSF_EXP2_BITS)) + span / 2) / span);
+    return octaves * DSF_OCTAVE16 + (int32_t)((lo << (16 - DSF_EXP2_BITS)) + within);
+}
+
+/*!
+    @brief converts a 14-bit MIDI pitch bend into a pitch offset
+
+    @param bend pitch bend centred on zero (-8192..8191)
+    @param rangeSemis bend range in semitones at full deflection
+    @return pitch offset in Q16 octaves
+*/
+static inline int32_t bendToOct16(int16_t bend, uint8_t rangeSemis)
+{
+    // bend / 8192 * range / 12 * 65536 == bend * range * 2 / 3
+    return ((int32_t)bend * rangeSemis * 2) / 3;
+}
+
+/*!
+    @brief converts a distance in semitones into a pitch offset
+
+    @param semis signed number of semitones
+    @return pitch offset in Q16 octaves
+*/
+static inline int32_t semisToOct16(int32_t semis)
+{
+    return (semis * DSF_OCTAVE16) / 12;
+}
+
+/*!
+    @brief Linear glide (portamento) in the pitch domain.
+
+    `set()` plans a constant-time glide from the current value to a target; `next()` advances one step. Both are integer
+    only, so `next()` can run every sample.
+*/
+class DsfGlide {
+
+    public:
+        /*!
+            @brief glides from the current pitch to `target16` over `steps` calls of `next()`
+
+            @param target16 target pitch offset in Q16 octaves
+            @param steps glide duration in calls of `next()`; 0 jumps immediately
+        */
+        void set(int32_t target16, uint32_t steps)
+        {
+            target = target16;
+            if (steps == 0) {
+                current = target;
+                rate = 0;
+                return;
+            }
+            rate = (target - current) / (int32_t)steps;
+            if (rate == 0) rate = (target > current) ? 1 : -1;
+        }
+
+        /*!
+            @brief jumps to `value16` and stops any glide in progress
+        */
+        void jump(int32_t value16)
+        {
+            current = target = value16;
+            rate = 0;
+        }
+
+        /*!
+            @brief advances the glide by one step
+
+            @return the pitch offset in Q16 octaves for this step
+        */
+        int32_t next()
+        {
+            if (current != target) {
+                current += rate;
+                if ((rate > 0 && current > target) || (rate < 0 && current < target)) current = target;
+            }
+            return current;
+        }
+
+        int32_t value() const { return current; }
+
+    private:
+        int32_t current = 0, target = 0, rate = 0;
+};
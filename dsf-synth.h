@@ -0,0 +1,360 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Synth Voice
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * A voice pool, the shared ADSR envelope sweeping `a`, and
+ * the note handling of the example (Standard/Strange Mode,
+ * legato glide, pitch bend, last-note release) in one place,
+ * so the firmware and the host renderer play MIDI the same
+ * way.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-voice-pool.h"
+#include "dsf-envelope.h"
+#include "dsf-notes.h"
+#include "dsf-tuning.h"
+#include "dsf-midi-queue.h"
+
+/*
+ * SYNTH SETTINGS
+ */
+#define DSF_SYNTH_BLOCK 256 // the most samples one prepareBlock() covers
+#define DSF_SYNTH_FADE 512 // samples a note released under other held notes fades out over
+
+/*!
+    @brief N-voice DSF synth driven by MIDI-style note events.
+
+    One envelope is shared by all voices; its level sweeps `a` across `param_a_min15..param_a_max15` (or back down when
+    inverted). A note released while others are held fades out on its own over `DSF_SYNTH_FADE` samples (see
+    `DsfVoicePool::noteFade()`); the last note-off closes the envelope instead, and `service()` stops every voice when
+    the release has finished. Notes are tuned by `tuning`, equal temperament unless another tuning is loaded into it. `env`, `voices` and
+    `tuning` are public so callers can set envelope times, voice settings and the tuning directly.
+
+    @tparam N number of voices
+*/
+template <uint8_t N>
+class DsfSynth {
+
+    public:
+        DsfSynth(uint16_t sample_rate, uint8_t dac_bit_depth, uint8_t env_period_bits = 5);
+        void noteOn(uint8_t note, uint8_t velocity, const dsf_note_mode_t &mode);
+        void noteOff(uint8_t note);
+        void pitchBend(int16_t bend);
+        void controlChange(uint8_t controller, uint8_t value);
+        void midi(const dsf_midi_event_t &e, const dsf_note_mode_t &mode);
+        template <uint16_t Q>
+        size_t applyDue(DsfMidiQueue<Q> &queue, uint32_t now, size_t maxLen, const dsf_note_mode_t &mode,
+                        void (*applied)(const dsf_midi_event_t &e) = nullptr);
+        void setBendRange(uint8_t semis) { bendRange = semis; }
+        void setEnvInvert(bool invert) { envInvert = invert; }
+        bool service();
+        void renderBlock(uint16_t *out, size_t n);
+        void prepareBlock(size_t n);
+
+        /*!
+            @brief renders part `part` of `parts` of the voices for the block set up by `prepareBlock()`, see
+            `DsfVoicePool::renderVoices()`; the parts may run concurrently
+        */
+        void renderPart(int32_t *acc, size_t n, uint8_t part, uint8_t parts)
+        {
+            voices.renderVoices(acc, n, part, parts, passA);
+        }
+
+        /*!
+            @brief mixes the rendered parts into DAC codes, see `DsfVoicePool::mixDown()`
+        */
+        void finishBlock(uint16_t *out, size_t n, const int32_t *acc, const int32_t *acc2 = nullptr) const
+        {
+            voices.mixDown(out, acc, n, acc2);
+        }
+
+        /*!
+            @brief generates the next sample, moving `a` with the envelope
+
+            @return a 16-bit integer value that can be passed directly to the DAC
+        */
+        inline uint16_t nextSample()
+        {
+            fix15 swing = multfix15(env.next(), param_a_range);
+            voices.setA(envInvert ? param_a_min15 + swing : param_a_max15 - swing);
+            return voices.getNextSample();
+        }
+
+        /*!
+            @return `true` while the last note's release is still sounding
+        */
+        bool releasing() const { return inRelease; }
+
+        DsfEnvelope env;
+        DsfVoicePool<N> voices;
+        DsfTuning tuning;
+
+    private:
+        bool inRelease = false, envInvert = true;
+        uint8_t lastNote = 60; // last Standard Mode note, for legato glide
+        uint8_t bendRange = 2;
+        fix15 passA[DSF_SYNTH_BLOCK / DSF_POOL_BLOCK]; // `a` for each pool pass of the prepared block
+};
+
+/*!
+    @brief Constructor.
+
+    @param sample_rate the output sample rate, in Hz
+    @param dac_bit_depth the number of bits (e.g., 12) of the output samples
+    @param env_period_bits envelope control period of `2^env_period_bits` samples, see `DsfEnvelope`
+*/
+template <uint8_t N>
+DsfSynth<N>::DsfSynth(uint16_t sample_rate, uint8_t dac_bit_depth, uint8_t env_period_bits)
+    : env(sample_rate, env_period_bits), voices(sample_rate, dac_bit_depth), tuning(sample_rate)
+{
+}
+
+/*!
+    @brief starts a note and opens the envelope
+
+    A note-on cuts a release that is still sounding. The phase increments come from `tuning`, chosen by the mode the way
+    `noteFreqs()` chooses frequencies. In Standard Mode a note played while others are held slides in from the previous
+    note's pitch over the glide time set with `voices.setGlideTime()`. A velocity of 0 is a note-off.
+
+    @param note MIDI note number
+    @param velocity MIDI velocity, scaled to the voice gain
+    @param mode Standard or Strange Mode, see `noteFreqs()`
+*/
+template <uint8_t N>
+void DsfSynth<N>::noteOn(uint8_t note, uint8_t velocity, const dsf_note_mode_t &mode)
+{
+    if (velocity == 0) {
+        noteOff(note);
+        return;
+    }
+    note &= 0x7F;
+    velocity &= 0x7F;
+
+    if (inRelease) {
+        voices.allNotesOff();
+        inRelease = false;
+    }
+
+    uint32_t stepNote, stepMod;
+    tuning.steps(note, mode, stepNote, stepMod);
+    fix15 velocityGain = divfix15(int2fix15(velocity), int2fix15(127));
+
+    if (mode.strange) {
+        voices.noteOnStep(note, stepNote, stepMod, velocityGain);
+    } else {
+        int32_t glideFrom = (voices.heldVoices() > 0) ? tuning.pitch16(lastNote) - tuning.pitch16(note) : 0;
+        voices.noteOnStep(note, stepNote, stepMod, velocityGain, glideFrom);
+        lastNote = note;
+    }
+    env.gate(true);
+}
+
+/*!
+    @brief releases `note`
+
+    While other notes are held the voice fades out over `DSF_SYNTH_FADE` samples and stops, leaving the shared
+    envelope to them. The last held note closes the envelope instead: its voice, and any still fading, play through
+    the release until `service()` stops them.
+
+    @param note MIDI note number
+*/
+template <uint8_t N>
+void DsfSynth<N>::noteOff(uint8_t note)
+{
+    if (!voices.isHeld(note)) return;
+    if (voices.heldVoices() > 1) {
+        voices.noteFade(note, DSF_SYNTH_FADE);
+    } else {
+        voices.noteRelease(note);
+        env.gate(false);
+        inRelease = true;
+    }
+}
+
+/*!
+    @brief bends every voice
+
+    @param bend 14-bit MIDI bend value minus 8192, `-8192 <= bend <= 8191`
+*/
+template <uint8_t N>
+void DsfSynth<N>::pitchBend(int16_t bend)
+{
+    voices.pitch(bendToOct16(bend, bendRange));
+}
+
+/*!
+    @brief handles the Channel Mode messages; other controllers are ignored
+
+    All Notes Off (123) releases everything through the envelope like the last note-off; All Sound Off (120) and Reset
+    All Controllers (121, bend only) act immediately.
+
+    @param controller controller number
+    @param value controller value
+*/
+template <uint8_t N>
+void DsfSynth<N>::controlChange(uint8_t controller, uint8_t value)
+{
+    (void)value;
+    switch (controller)
+    {
+    case 120:
+        voices.allNotesOff();
+        env.gate(false);
+        inRelease = false;
+        break;
+
+    case 121:
+        pitchBend(0);
+        break;
+
+    case 123:
+        if (voices.activeVoices() > 0) {
+            env.gate(false);
+            inRelease = true;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/*!
+    @brief applies one channel message: note on/off, control change and pitch bend; the channel is ignored
+
+    @param e the message, e.g. from a `DsfMidiQueue`
+    @param mode Standard or Strange Mode for note-ons, see `noteFreqs()`
+*/
+template <uint8_t N>
+void DsfSynth<N>::midi(const dsf_midi_event_t &e, const dsf_note_mode_t &mode)
+{
+    switch (e.status & 0xF0)
+    {
+    case 0x90:
+        noteOn(e.data1, e.data2, mode);
+        break;
+
+    case 0x80:
+        noteOff(e.data1);
+        break;
+
+    case 0xB0:
+        controlChange(e.data1 & 0x7F, e.data2 & 0x7F);
+        break;
+
+    case 0xE0:
+        // 14-bit bend, LSB first, centred on 8192
+        pitchBend((int16_t)((((e.data2 & 0x7F) << 7) | (e.data1 & 0x7F)) - 8192));
+        break;
+
+    default:
+        break;
+    }
+}
+
+/*!
+    @brief applies the queued messages that are due at sample `now` and tells the caller how far to render before the
+    next one
+
+    For sample-accurate timing: render a block in spans, calling this at the start of each span with the sample clock
+    of the span's first sample and rendering as many samples as it returns. A message is due when its `time` (plus
+    whatever fixed latency the producer added) is at or before `now`; messages that are late are applied at once, so
+    nothing is lost if the renderer falls behind. Messages are taken in queue order.
+
+    @param queue the queue to drain
+    @param now the sample clock of the next sample to render
+    @param maxLen the samples left in the block
+    @param mode Standard or Strange Mode for note-ons
+    @param applied optional callback for every message after it is applied (e.g. for logging)
+    @return samples to render before the next message is due, `1 <= return <= maxLen` (`maxLen` if none is pending)
+*/
+template <uint8_t N>
+template <uint16_t Q>
+size_t DsfSynth<N>::applyDue(DsfMidiQueue<Q> &queue, uint32_t now, size_t maxLen, const dsf_note_mode_t &mode,
+                             void (*applied)(const dsf_midi_event_t &e))
+{
+    dsf_midi_event_t e;
+    while (queue.peek(e)) {
+        int32_t wait = (int32_t)(e.time - now); // wraps with the clock
+        if (wait > 0) return ((size_t)wait < maxLen) ? (size_t)wait : maxLen;
+        queue.pop(e);
+        midi(e, mode);
+        if (applied) applied(e);
+    }
+    return maxLen;
+}
+
+/*!
+    @brief stops the released voices once the envelope's release has finished and services the voices' waveform cache, if one
+    is set; call once per rendered block, between blocks
+
+    @return `true` if the release finished on this call
+*/
+template <uint8_t N>
+bool DsfSynth<N>::service()
+{
+    voices.serviceCache();
+    if (!inRelease || env.active()) return false;
+    voices.allNotesOff();
+    inRelease = false;
+    return true;
+}
+
+/*!
+    @brief renders `n` samples
+
+    Unlike `nextSample()`, which sets `a` every sample, `a` is updated once per pool pass of `DSF_POOL_BLOCK` samples
+    (the envelope's own control rate at the default period), so the voices render whole passes. Identical to
+    `prepareBlock()` followed by `renderPart()` for every part and `finishBlock()`.
+
+    @param out caller-supplied buffer of at least `n` samples
+    @param n the number of samples to render
+*/
+template <uint8_t N>
+void DsfSynth<N>::renderBlock(uint16_t *out, size_t n)
+{
+    int32_t acc[DSF_POOL_BLOCK];
+
+    while (n > 0) {
+        size_t len = (n < DSF_POOL_BLOCK) ? n : DSF_POOL_BLOCK;
+        prepareBlock(len);
+        renderPart(acc, len, 0, 1);
+        finishBlock(out, len, acc);
+        out += len;
+        n -= len;
+    }
+}
+
+/*!
+    @brief advances the envelope over the next `n` samples and stores the `a` each pool pass will use
+
+    The first step of a split render: call it on one core, then `renderPart()` on each core, then `finishBlock()`.
+    Nothing else may change the synth until every part has finished.
+
+    @param n the number of samples in the block, at most `DSF_SYNTH_BLOCK`
+*/
+template <uint8_t N>
+void DsfSynth<N>::prepareBlock(size_t n)
+{
+    if (n > DSF_SYNTH_BLOCK) n = DSF_SYNTH_BLOCK;
+
+    size_t pass = 0;
+    for (size_t done = 0; done < n; done += DSF_POOL_BLOCK) {
+        size_t len = (n - done < DSF_POOL_BLOCK) ? n - done : DSF_POOL_BLOCK;
+        // the pass plays at the level halfway through it
+        fix15 level = 0;
+        for (size_t i = 0; i < len; i++) {
+            fix15 l = env.next();
+            if (i == len / 2) level = l;
+        }
+        fix15 swing = multfix15(level, param_a_range);
+        passA[pass++] = envInvert ? param_a_min15 + swing : param_a_max15 - swing;
+    }
+}
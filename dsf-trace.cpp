@@ -0,0 +1,236 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Input Trace
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-trace.h"
+
+#include <cstring>
+
+/*!
+    @brief appends `v` as a LEB128 varint
+
+    @return bytes written, at most 5
+*/
+static size_t putVarint(uint8_t *p, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/*!
+    @brief Constructor. Nothing is recorded until `begin()`.
+
+    @param buffer where the trace goes
+    @param size bytes available
+*/
+DsfTraceWriter::DsfTraceWriter(uint8_t *buffer, size_t size)
+{
+    buf = buffer;
+    cap = size;
+}
+
+/*!
+    @brief starts a new trace at block 0: writes the header and resets the checksum
+
+    @return `false` if the buffer can't hold the header
+*/
+bool DsfTraceWriter::begin(const dsf_trace_info_t &info)
+{
+    len = 0;
+    lastBlock = 0;
+    sum.reset();
+    stopped = (cap < DSF_TRACE_HEADER_SIZE);
+    if (stopped) return false;
+
+    memcpy(buf, DSF_TRACE_MAGIC, 4);
+    buf[4] = DSF_TRACE_VERSION;
+    buf[5] = info.voices;
+    buf[6] = info.dacBits;
+    buf[7] = 0;
+    buf[8] = (uint8_t)info.blockSize;
+    buf[9] = (uint8_t)(info.blockSize >> 8);
+    buf[10] = buf[11] = 0;
+    for (int i = 0; i < 4; i++) buf[12 + i] = (uint8_t)(info.sampleRate >> (8 * i));
+    len = DSF_TRACE_HEADER_SIZE;
+    return true;
+}
+
+/*!
+    @brief writes one record, or stops the writer if it doesn't fit
+*/
+bool DsfTraceWriter::put(uint8_t kind, uint32_t block, const uint8_t *payload, size_t n, const uint8_t *data,
+                         size_t dataLen)
+{
+    if (stopped) return false;
+    uint8_t head[6];
+    size_t h = 0;
+    head[h++] = kind;
+    h += putVarint(head + h, block - lastBlock);
+    if (len + h + n + dataLen > cap) {
+        stopped = true;
+        return false;
+    }
+    memcpy(buf + len, head, h);
+    memcpy(buf + len + h, payload, n);
+    if (dataLen) memcpy(buf + len + h + n, data, dataLen);
+    len += h + n + dataLen;
+    lastBlock = block;
+    return true;
+}
+
+/*!
+    @brief records an input applied before block `block` is rendered; blocks never go backwards
+
+    @return `false` if the writer has stopped
+*/
+bool DsfTraceWriter::input(uint32_t block, const dsf_input_t &in)
+{
+    uint8_t p[DSF_TRACE_RECORD_MAX];
+    size_t n = 0;
+    switch (in.type) {
+    case input_control:
+        p[n++] = (uint8_t)in.value;
+        p[n++] = (uint8_t)((uint16_t)in.value >> 8);
+        break;
+
+    case input_button:
+    case input_encoder:
+        p[n++] = (uint8_t)(int8_t)in.value;
+        break;
+
+    case input_midi:
+        n += putVarint(p, in.offset);
+        memcpy(p + n, in.midi, 3);
+        n += 3;
+        break;
+
+    case input_sysex:
+        n += putVarint(p, in.len);
+        return put((uint8_t)(input_sysex << 4), block, p, n, in.data, in.len);
+
+    default:
+        return false;
+    }
+    return put((uint8_t)((in.type << 4) | (in.id & 0x0F)), block, p, n);
+}
+
+/*!
+    @brief records the checksum of the codes passed to `samples()` since the last check, after block `block`
+
+    @return `false` if the writer has stopped
+*/
+bool DsfTraceWriter::check(uint32_t block)
+{
+    uint32_t v = sum.value();
+    uint8_t p[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    sum.reset();
+    return put(DSF_TRACE_CHECK << 4, block, p, sizeof(p));
+}
+
+/*!
+    @brief records that block `block` plays at sample `clock` instead of right after the previous block
+
+    @return `false` if the writer has stopped
+*/
+bool DsfTraceWriter::position(uint32_t block, uint32_t clock)
+{
+    uint8_t p[4] = { (uint8_t)clock, (uint8_t)(clock >> 8), (uint8_t)(clock >> 16), (uint8_t)(clock >> 24) };
+    return put(DSF_TRACE_POSITION << 4, block, p, sizeof(p));
+}
+
+/*!
+    @brief Constructor. Checks the header; see `ok()`.
+
+    @param data the trace, which must stay valid while records are read (SysEx inputs point into it)
+    @param len its length in bytes
+*/
+DsfTraceReader::DsfTraceReader(const uint8_t *data, size_t len) : buf(data), len(len)
+{
+    if (len < DSF_TRACE_HEADER_SIZE || memcmp(data, DSF_TRACE_MAGIC, 4) != 0 || data[4] != DSF_TRACE_VERSION) return;
+    header.voices = data[5];
+    header.dacBits = data[6];
+    header.blockSize = (uint16_t)(data[8] | (data[9] << 8));
+    header.sampleRate = (uint32_t)data[12] | ((uint32_t)data[13] << 8) | ((uint32_t)data[14] << 16) |
+                        ((uint32_t)data[15] << 24);
+    valid = true;
+}
+
+bool DsfTraceReader::varint(uint32_t &v)
+{
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= len) return false;
+        uint8_t b = buf[pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+/*!
+    @brief reads the next record
+
+    @return `false` at the end of the trace, or at a malformed record (`malformed()`)
+*/
+bool DsfTraceReader::next(dsf_trace_record_t &r)
+{
+    if (!valid || bad || pos >= len) return false;
+    uint8_t kind = buf[pos++];
+    uint32_t delta;
+    if (!varint(delta)) return (bad = true, false);
+    block += delta;
+
+    r = {};
+    r.block = block;
+    r.in.type = kind >> 4;
+    r.in.id = kind & 0x0F;
+    uint32_t v;
+    switch (r.in.type) {
+    case input_control:
+        if (len - pos < 2) return (bad = true, false);
+        r.in.value = (int16_t)(buf[pos] | (buf[pos + 1] << 8));
+        pos += 2;
+        return true;
+
+    case input_button:
+    case input_encoder:
+        if (len - pos < 1) return (bad = true, false);
+        r.in.value = (int8_t)buf[pos++];
+        return true;
+
+    case input_midi:
+        if (!varint(v) || len - pos < 3) return (bad = true, false);
+        r.in.offset = (uint16_t)v;
+        memcpy(r.in.midi, buf + pos, 3);
+        pos += 3;
+        return true;
+
+    case input_sysex:
+        if (!varint(v) || v > 0xFFFF || len - pos < v) return (bad = true, false);
+        r.in.len = (uint16_t)v;
+        r.in.data = buf + pos;
+        pos += v;
+        return true;
+
+    case DSF_TRACE_CHECK:
+    case DSF_TRACE_POSITION:
+        if (len - pos < 4) return (bad = true, false);
+        r.kind = (r.in.type == DSF_TRACE_CHECK) ? trace_check : trace_position;
+        r.value = (uint32_t)buf[pos] | ((uint32_t)buf[pos + 1] << 8) | ((uint32_t)buf[pos + 2] << 16) |
+                  ((uint32_t)buf[pos + 3] << 24);
+        r.in = {};
+        pos += 4;
+        return true;
+
+    default:
+        return (bad = true, false);
+    }
+}
@@ -0,0 +1,182 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Input Trace
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * A compact binary record of everything that changes what the
+ * application loop renders: the inputs it applied between
+ * blocks (`dsf_input_t`), each stamped with its block, plus a
+ * checksum of the DAC codes every few blocks. The firmware
+ * writes one into a RAM buffer; the host replays it through
+ * the same loop and checks that it renders the same codes.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-hal.h"
+
+/*
+ * TRACE FORMAT
+ */
+#define DSF_TRACE_MAGIC "DSFR" // first four bytes of a trace
+#define DSF_TRACE_VERSION 1
+#define DSF_TRACE_HEADER_SIZE 16 // magic, version, voices, DAC bits, 0, block size (16 bit), 0 (16 bit), sample rate
+#define DSF_TRACE_CHECK 0x0F // record kind of a DAC checksum; inputs use their dsf_input_type_t
+#define DSF_TRACE_POSITION 0x0E // record kind of a jump in the sink's sample clock
+#define DSF_TRACE_RECORD_MAX 12 // longest record apart from SysEx data: kind, block delta, offset, payload
+
+/*!
+    @brief the settings a trace was recorded with; a replay must render with the same ones
+
+    @param sampleRate samples per second
+    @param blockSize samples per sink block
+    @param dacBits DAC bit depth
+    @param voices polyphony
+*/
+typedef struct {
+    uint32_t sampleRate;
+    uint16_t blockSize;
+    uint8_t dacBits, voices;
+} dsf_trace_info_t;
+
+/*!
+    @brief what a trace record holds
+
+    @param trace_input an input applied before the block is rendered
+    @param trace_check the checksum of every DAC code since the previous check, after the block (see `DsfTraceSum`)
+    @param trace_position the sample clock of the block, where it isn't the previous block's plus the block size (the
+           first block, and after an underrun)
+*/
+enum dsf_trace_kind_t : uint8_t
+{
+    trace_input,
+    trace_check,
+    trace_position
+};
+
+/*!
+    @brief one record read back by `DsfTraceReader`
+
+    @param block the sink block, counted from the start of the trace, the record belongs to
+    @param kind a `dsf_trace_kind_t`
+    @param value the checksum or the sample clock
+    @param in the input; SysEx data points into the trace
+*/
+typedef struct {
+    uint32_t block;
+    uint8_t kind;
+    uint32_t value;
+    dsf_input_t in;
+} dsf_trace_record_t;
+
+/*!
+    @brief Fletcher-style checksum of DAC codes: two 16-bit running sums, so a changed, missing or reordered code
+    changes it. Two adds per sample.
+*/
+class DsfTraceSum {
+
+    public:
+        void reset() { lo = hi = 0; }
+
+        inline void add(const uint16_t *codes, size_t n)
+        {
+            for (size_t i = 0; i < n; i++) {
+                lo += codes[i];
+                hi += lo;
+            }
+        }
+
+        uint32_t value() const { return ((hi & 0xFFFF) << 16) | (lo & 0xFFFF); }
+
+    private:
+        uint32_t lo = 0, hi = 0;
+};
+
+/*!
+    @brief Writes a trace into a caller-owned buffer.
+
+    Records are a kind byte (the input type, `DSF_TRACE_CHECK` or `DSF_TRACE_POSITION` in the high nibble, the input
+    `id` in the low), the number of blocks since the previous record as a LEB128 varint, and a payload: controls a
+    16-bit value, buttons and encoders one signed byte, MIDI the sample offset (varint) and three bytes, SysEx its
+    length (varint) and data, checks the 32-bit sum and positions the 32-bit sample clock. Numbers are little-endian.
+    A control change takes 4 bytes, a MIDI message 6.
+
+    When a record doesn't fit, the writer stops for good: nothing is written after a gap, so a trace is always a
+    complete prefix of the session. Single context only (the application loop).
+*/
+class DsfTraceWriter {
+
+    public:
+        DsfTraceWriter(uint8_t *buffer, size_t size);
+        bool begin(const dsf_trace_info_t &info);
+        bool input(uint32_t block, const dsf_input_t &in);
+        bool check(uint32_t block);
+        bool position(uint32_t block, uint32_t clock);
+
+        /*!
+            @brief adds rendered DAC codes to the checksum of the next `check()`
+        */
+        inline void samples(const uint16_t *codes, size_t n) { sum.add(codes, n); }
+
+        /*!
+            @return the trace written so far
+        */
+        const uint8_t *data() const { return buf; }
+        size_t size() const { return len; }
+
+        /*!
+            @return `true` once a record didn't fit and the writer has stopped
+        */
+        bool full() const { return stopped; }
+
+    private:
+        bool put(uint8_t kind, uint32_t block, const uint8_t *payload, size_t n, const uint8_t *data = nullptr,
+                 size_t dataLen = 0);
+
+        uint8_t *buf;
+        size_t cap, len = 0;
+        uint32_t lastBlock = 0;
+        DsfTraceSum sum;
+        bool stopped = true;
+};
+
+/*!
+    @brief Reads a trace written by `DsfTraceWriter`, one record at a time.
+*/
+class DsfTraceReader {
+
+    public:
+        DsfTraceReader(const uint8_t *data, size_t len);
+        bool next(dsf_trace_record_t &r);
+
+        /*!
+            @return `true` if the header is valid
+        */
+        bool ok() const { return valid; }
+
+        /*!
+            @return `true` if reading stopped at a record that is cut short or of an unknown kind
+        */
+        bool malformed() const { return bad; }
+
+        const dsf_trace_info_t &info() const { return header; }
+
+    private:
+        bool varint(uint32_t &v);
+
+        const uint8_t *buf;
+        size_t len, pos = DSF_TRACE_HEADER_SIZE;
+        uint32_t block = 0;
+        dsf_trace_info_t header = {};
+        bool valid = false, bad = false;
+};
@@ -0,0 +1,133 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Tuning Tables
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-tuning.h"
+
+/*!
+    @brief the Standard Mode modulator ratios in Q30, indexed by `DsfTuning::ratio()`: 1/2, 2, sqrt(2)/2, 2 sqrt(2)
+*/
+static constexpr uint32_t ratio30[DSF_TUNING_RATIOS] = { 1u << 29, 1u << 31, 759250125u, 3037000500u };
+
+/*!
+    @brief Constructor. Starts in equal temperament.
+
+    @param sample_rate the output sample rate, in Hz
+*/
+DsfTuning::DsfTuning(uint16_t sample_rate)
+{
+    stepScale = DsfOsc::phaseScale(sample_rate);
+    setEqual();
+}
+
+/*!
+    @brief back to 12-tone equal temperament with A4 (note 69) at 440 Hz
+*/
+void DsfTuning::setEqual()
+{
+    setFreqs(midiFreq16.v);
+}
+
+/*!
+    @brief sets every note's frequency and rebuilds the increment and pitch tables
+
+    @param freq16 128 frequencies in Q16.16 Hz, indexed by MIDI note; 0 leaves a note silent
+*/
+void DsfTuning::setFreqs(const uint32_t freq16[128])
+{
+    for (int n = 0; n < 128; n++) {
+        freq[n] = freq16[n];
+        // freq * 2^32 / fs with 16 fraction bits, like phaseStep() with 15
+        carrier[n] = (uint32_t)(((uint64_t)freq16[n] * stepScale) >> 25);
+        for (int r = 0; r < DSF_TUNING_RATIOS; r++) {
+            modulator[r][n] = (uint32_t)(((uint64_t)carrier[n] * ratio30[r]) >> 30);
+        }
+        pitch[n] = stepToOct16(freq16[n], midiFreq16[0]);
+    }
+}
+
+/*!
+    @brief loads a tuning blob as written by `writeBlob()` (or `dsf-render --write-tuning`)
+
+    @param blob the blob, `DSF_TUNING_BLOB_SIZE` bytes
+    @param len its length
+    @return `false`, with the tuning unchanged, if it isn't a version 1 blob
+*/
+bool DsfTuning::loadBlob(const uint8_t *blob, size_t len)
+{
+    if (len < DSF_TUNING_BLOB_SIZE) return false;
+    for (int i = 0; i < 4; i++) {
+        if (blob[i] != (uint8_t)DSF_TUNING_MAGIC[i]) return false;
+    }
+    if (blob[4] != DSF_TUNING_VERSION) return false;
+
+    uint32_t f[128];
+    const uint8_t *p = blob + 8;
+    for (int n = 0; n < 128; n++, p += 4) {
+        f[n] = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    setFreqs(f);
+    return true;
+}
+
+/*!
+    @brief encodes 128 frequencies as a tuning blob
+
+    @param freq16 frequencies in Q16.16 Hz, indexed by MIDI note
+    @param blob receives `DSF_TUNING_BLOB_SIZE` bytes
+    @return `DSF_TUNING_BLOB_SIZE`
+*/
+size_t DsfTuning::writeBlob(const uint32_t freq16[128], uint8_t *blob)
+{
+    for (int i = 0; i < 4; i++) blob[i] = (uint8_t)DSF_TUNING_MAGIC[i];
+    blob[4] = DSF_TUNING_VERSION;
+    blob[5] = blob[6] = blob[7] = 0;
+    uint8_t *p = blob + 8;
+    for (int n = 0; n < 128; n++, p += 4) {
+        p[0] = (uint8_t)freq16[n];
+        p[1] = (uint8_t)(freq16[n] >> 8);
+        p[2] = (uint8_t)(freq16[n] >> 16);
+        p[3] = (uint8_t)(freq16[n] >> 24);
+    }
+    return DSF_TUNING_BLOB_SIZE;
+}
+
+/*!
+    @brief applies a MIDI Tuning Standard bulk tuning dump
+
+    The message is `F0 7E <device> 08 01 <program> <16-byte name> <xx yy zz> * 128 <checksum> F7`, where each note is
+    semitone `xx` of equal temperament plus `yyzz / 16384` of a semitone, and `7F 7F 7F` keeps the note as it is. The
+    checksum (XOR of the bytes from `7E` to the last data byte) must match; device ID and program are not checked.
+    The semitone is read from `midiFreq16` and the fraction applied with `pitchStep()`, so integer only.
+
+    @param msg the complete SysEx message, `F0` to `F7`
+    @param len its length, `DSF_MTS_DUMP_SIZE`
+    @return `false`, with the tuning unchanged, if it isn't a valid bulk dump
+*/
+bool DsfTuning::loadMts(const uint8_t *msg, size_t len)
+{
+    if (len != DSF_MTS_DUMP_SIZE || msg[0] != 0xF0 || msg[1] != 0x7E || msg[3] != 0x08 || msg[4] != 0x01 ||
+        msg[len - 1] != 0xF7) {
+        return false;
+    }
+    uint8_t sum = 0;
+    for (size_t i = 1; i < len - 2; i++) sum ^= msg[i];
+    if ((sum & 0x7F) != msg[len - 2]) return false;
+
+    uint32_t f[128];
+    const uint8_t *p = msg + 22;
+    for (int n = 0; n < 128; n++, p += 3) {
+        if (p[0] == 0x7F && p[1] == 0x7F && p[2] == 0x7F) {
+            f[n] = freq[n];
+            continue;
+        }
+        // 1/16384 semitone is 65536 / (12 * 16384) = 1/3 of a Q16 octave unit
+        uint32_t frac = ((uint32_t)(p[1] & 0x7F) << 7) | (p[2] & 0x7F);
+        f[n] = pitchStep(midiFreq16[p[0] & 0x7F], (int32_t)((frac + 1) / 3));
+    }
+    setFreqs(f);
+    return true;
+}
@@ -0,0 +1,98 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Tuning Tables
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Microtuning: a frequency for each of the 128 MIDI notes,
+ * equal temperament by default, or loaded from a compact
+ * binary blob (written on the host from Scala files) or a
+ * MIDI Tuning Standard bulk dump. Loading precomputes the
+ * carrier and modulator phase increments of every note, so
+ * a note-on is a table load.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-oscillator-pico.h"
+#include "dsf-notes.h"
+#include "dsf-pitch.h"
+
+/*
+ * TUNING FORMATS
+ */
+#define DSF_TUNING_MAGIC "DSFT" // first four bytes of a tuning blob
+#define DSF_TUNING_VERSION 1
+#define DSF_TUNING_BLOB_SIZE (8 + 4 * 128) // magic, version, 3 reserved bytes, 128 little-endian Q16.16 frequencies
+#define DSF_MTS_DUMP_SIZE 408 // MIDI Tuning Standard bulk tuning dump, F0 7E <dev> 08 01 ... F7
+#define DSF_TUNING_RATIOS 4 // Standard Mode modulator ratios, see DsfTuning::ratio()
+
+/*!
+    @brief The frequency of every MIDI note and the phase increments derived from it.
+
+    The source is a table of 128 frequencies in Q16.16 Hz (`setFreqs()`): equal temperament from `midiFreq16` after
+    construction, a blob from `loadBlob()` or an MTS bulk dump from `loadMts()`. Loading converts every note into its
+    carrier increment, its modulator increment for each of the four Standard Mode ratios (`modFactor15` times 1 or
+    `root2`, held exactly in Q30 here) and its pitch in Q16 octaves (for glide), with integer math only. `steps()` then
+    reads two table entries. About 3.5 KB of tables; loading does a few 64-bit multiplies and one 64-bit divide per note
+    (estimated at around a millisecond on the RP2040), so do it between blocks, not per note.
+*/
+class DsfTuning {
+
+    public:
+        DsfTuning(uint16_t sample_rate);
+        void setEqual();
+        void setFreqs(const uint32_t freq16[128]);
+        bool loadBlob(const uint8_t *blob, size_t len);
+        bool loadMts(const uint8_t *msg, size_t len);
+        static size_t writeBlob(const uint32_t freq16[128], uint8_t *blob);
+
+        /*!
+            @brief carrier and modulator increments for `note`, as `noteFreqs()` chooses them, from the tables
+
+            @param note MIDI note number
+            @param mode Standard or Strange Mode settings
+            @param stepNote receives the carrier phase increment
+            @param stepMod receives the modulator phase increment
+        */
+        inline void steps(uint8_t note, const dsf_note_mode_t &mode, uint32_t &stepNote, uint32_t &stepMod) const
+        {
+            note &= 0x7F;
+            if (mode.strange) {
+                stepNote = carrier[strangeModeRoots[mode.strangeKey & 0x07]];
+                stepMod = carrier[note];
+            } else {
+                stepNote = carrier[note];
+                stepMod = modulator[ratio(mode)][note];
+            }
+        }
+
+        /*!
+            @return the pitch of `note` in Q16 octaves above equal-tempered MIDI note 0; differences give glide offsets
+        */
+        inline int32_t pitch16(uint8_t note) const { return pitch[note & 0x7F]; }
+
+        /*!
+            @return the frequency of `note` in Q16.16 Hz
+        */
+        inline uint32_t freq16(uint8_t note) const { return freq[note & 0x7F]; }
+
+        /*!
+            @return the Standard Mode modulator ratio index of `mode`: bit 0 double (else half), bit 1 inharmonic
+        */
+        static inline uint8_t ratio(const dsf_note_mode_t &mode) { return (mode.mult ? 1 : 0) | (mode.harmonic ? 0 : 2); }
+
+    private:
+        uint32_t freq[128], carrier[128], modulator[DSF_TUNING_RATIOS][128];
+        int32_t pitch[128];
+        uint32_t stepScale;
+};
@@ -0,0 +1,695 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Polyphonic Voice Pool
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * N DSF voices with O(1) note lookup, oldest/quietest voice
+ * stealing, integer pitch bend/glide and a fixed-point mix
+ * that always stays inside the DAC range. Voice state is kept structure-of-arrays so
+ * the render loop walks contiguous memory. Voices at a 2:1 or
+ * 1:2 ratio can play from a single-cycle waveform cache.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-oscillator-pico.h"
+#include "dsf-wave-cache.h"
+
+/*
+ * POOL SETTINGS
+ */
+#define DSF_POOL_BLOCK 32 // samples mixed per pass of the render loop
+#define DSF_NO_VOICE -1
+
+/*!
+    @brief Polyphonic voice pool built on the `DsfOsc` formula.
+
+    Each voice is normalised to a peak of 1 before mixing: `(1 - a^2) / (1 + a)` folds into the numerator as `(1 - a)^2`, so
+    the normalisation costs nothing per sample. The voices are then summed and scaled by the mix gain, which defaults to
+    `1 / N` so that N full-scale voices can never leave the DAC range that `halfDac` assumes. A louder gain can be set with
+    `setMixGain()`; the mix saturates instead of wrapping.
+
+    @tparam N number of voices (at most 127)
+*/
+template <uint8_t N>
+class DsfVoicePool {
+
+    static_assert(N > 0 && N < 128, "DsfVoicePool supports 1 to 127 voices");
+
+    public:
+        DsfVoicePool(uint16_t sample_rate, uint8_t dac_bit_depth);
+        int8_t noteOn(uint8_t note, fix15 freqNote, fix15 freqMod, fix15 gain = one15, int32_t glideFrom16 = 0);
+        int8_t noteOnStep(uint8_t note, uint32_t carrierStep, uint32_t modStep, fix15 gain = one15, int32_t glideFrom16 = 0);
+        void noteOff(uint8_t note);
+        void noteRelease(uint8_t note);
+        void noteFade(uint8_t note, uint32_t samples);
+        void allNotesOff();
+        void setA(fix15 param_a);
+        void setA(uint8_t voice, fix15 param_a);
+        void setMixGain(fix15 gain);
+        void setKernel(dsf_kernel_t k);
+        void setBandLimited(bool on);
+        void pitch(int32_t octaves16);
+        void setGlideTime(uint32_t samples);
+        void setWaveCache(DsfWaveCache *cache);
+        void serviceCache();
+        uint16_t getNextSample();
+        void renderBlock(uint16_t *out, size_t n);
+        void renderVoices(int32_t *acc, size_t n, uint8_t part = 0, uint8_t parts = 1, const fix15 *passA = nullptr);
+        void mixDown(uint16_t *out, const int32_t *acc, size_t n, const int32_t *acc2 = nullptr) const;
+        uint8_t activeVoices() const;
+        uint8_t heldVoices() const;
+        bool isPlaying(uint8_t note) const { return noteVoice[note & 0x7F] != DSF_NO_VOICE; }
+
+        /*!
+            @return `true` if `note` is sounding and hasn't been released with `noteRelease()` or `noteFade()`
+        */
+        bool isHeld(uint8_t note) const { return isPlaying(note) && !released[noteVoice[note & 0x7F]]; }
+
+    private:
+        uint8_t allocate();
+        void coefficients(uint8_t v);
+        void bandPowers(uint8_t v);
+        void modulate(uint8_t v, size_t n);
+        bool fade(uint8_t v, size_t n);
+        void mixVoice(uint8_t v, int32_t *acc, size_t n);
+        bool playCached(uint8_t v, int32_t *acc, size_t n);
+        template <dsf_kernel_t K, bool BAND> void mix(uint8_t v, int32_t *acc, size_t n);
+
+        // carrier/modulator phase accumulators and increments
+        uint32_t countNote[N], countMod[N], stepNote[N], stepMod[N];
+        // unmodulated increments; glide offset (Q24 octaves, heading to 0) and its change per sample
+        uint32_t baseNote[N], baseMod[N];
+        int32_t glide[N], glideRate[N];
+        // a and everything derived from it, recalculated only when a or gain changes
+        fix15 paramA[N], numScale[N], denBase[N], twoA[N], gain[N];
+        // band-limited mode: sideband count and a^(N+1), a^(N+2) scaled like numScale
+        uint32_t bands[N];
+        fix15 bandN1[N], bandN2[N];
+        // allocation bookkeeping
+        uint32_t started[N], noteCounter = 0;
+        uint8_t voiceNote[N];
+        bool active[N], released[N];
+        // noteFade(): gain in Q16.16 of fix15 while fading out, and its drop per sample (0 when not fading)
+        uint32_t fadeLevel[N], fadeRate[N];
+        int8_t noteVoice[128];
+        // waveform cache: each voice's carrier/modulator relationship, see DsfWaveCache::ratio()
+        uint8_t waveRatio[N];
+        DsfWaveCache *waveCache = nullptr;
+
+        fix15 halfDac, mixGain;
+        int32_t pitchOffset = 0; // Q16 octaves, shared by all voices
+        uint32_t stepScale, glideSamples = 0;
+        uint16_t fs, dacMax;
+        dsf_kernel_t kernel = kernel_divide;
+        bool bandLimited = false;
+};
+
+/*!
+    @brief Constructor.
+
+    Silences every voice; all voices read the sine table shared with `DsfOsc`.
+
+    @param sample_rate the sample rate of the calling timer, in Hz.
+    @param dac_bit_depth the number of bits (e.g., 12) in the DAC used by the calling program.
+*/
+template <uint8_t N>
+DsfVoicePool<N>::DsfVoicePool(uint16_t sample_rate, uint8_t dac_bit_depth)
+{
+    fs = sample_rate;
+    stepScale = DsfOsc::phaseScale(fs);
+    dacMax = (1 << dac_bit_depth) - 1;
+    halfDac = float2fix15(((float)dacMax / 2.0));
+    mixGain = one15 / N;
+
+    for (int n = 0; n < 128; n++) noteVoice[n] = DSF_NO_VOICE;
+
+    for (uint8_t v = 0; v < N; v++) {
+        countNote[v] = countMod[v] = stepNote[v] = stepMod[v] = 0;
+        baseNote[v] = baseMod[v] = 0;
+        glide[v] = glideRate[v] = 0;
+        started[v] = 0;
+        voiceNote[v] = 0;
+        active[v] = released[v] = false;
+        fadeLevel[v] = fadeRate[v] = 0;
+        gain[v] = 0;
+        bands[v] = 0;
+        bandN1[v] = bandN2[v] = 0;
+        waveRatio[v] = wave_direct;
+        paramA[v] = param_a_min15;
+        coefficients(v);
+    }
+}
+
+/*!
+    @brief starts a note, stealing a voice if all N are busy
+
+    A note that is already sounding retriggers its own voice. Otherwise a free voice is used; if there is none, the
+    quietest voice (lowest gain) is stolen, and among equally quiet voices the oldest one.
+
+    @param note MIDI note number, used for note-off lookup
+    @param freqNote the fixed-point frequency for the carrier
+    @param freqMod the fixed-point frequency for the modulator
+    @param gain fixed-point voice level, `0 < gain <= one15` (e.g., from velocity)
+    @param glideFrom16 start the note this many Q16 octaves away from its pitch and glide to it over the time set with 
+           `setGlideTime()` (portamento); 0 starts on pitch
+    @return the voice index that plays the note
+*/
+template <uint8_t N>
+int8_t DsfVoicePool<N>::noteOn(uint8_t note, fix15 freqNote, fix15 freqMod, fix15 gain, int32_t glideFrom16)
+{
+    return noteOnStep(note, DsfOsc::phaseStep(freqNote, stepScale), DsfOsc::phaseStep(freqMod, stepScale), gain,
+                      glideFrom16);
+}
+
+/*!
+    @brief starts a note from phase increments, e.g. precomputed by `DsfTuning`; otherwise the same as `noteOn()`
+
+    @param note MIDI note number, used for note-off lookup
+    @param carrierStep the carrier phase increment per sample
+    @param modStep the modulator phase increment per sample
+    @param gain fixed-point voice level, `0 < gain <= one15`
+    @param glideFrom16 start this many Q16 octaves away from the pitch and glide to it, see `noteOn()`
+    @return the voice index that plays the note
+*/
+template <uint8_t N>
+int8_t DsfVoicePool<N>::noteOnStep(uint8_t note, uint32_t carrierStep, uint32_t modStep, fix15 gain, int32_t glideFrom16)
+{
+    note &= 0x7F;
+    uint8_t v = (noteVoice[note] != DSF_NO_VOICE) ? (uint8_t)noteVoice[note] : allocate();
+
+    if (active[v] && noteVoice[voiceNote[v]] == (int8_t)v) noteVoice[voiceNote[v]] = DSF_NO_VOICE;
+
+    baseNote[v] = stepNote[v] = carrierStep;
+    baseMod[v] = stepMod[v] = modStep;
+    countNote[v] = 0;
+    countMod[v] = 0;
+
+    glide[v] = (glideSamples > 0) ? glideFrom16 * 256 : 0;
+    glideRate[v] = -glide[v] / (int32_t)(glideSamples > 0 ? glideSamples : 1);
+    if (glide[v] != 0 && glideRate[v] == 0) glideRate[v] = (glide[v] > 0) ? -1 : 1;
+
+    this->gain[v] = gain;
+    waveRatio[v] = DsfWaveCache::ratio(carrierStep, modStep);
+    if (bandLimited) bands[v] = DsfOsc::harmonics(stepNote[v], stepMod[v]);
+    coefficients(v);
+
+    voiceNote[v] = note;
+    noteVoice[note] = v;
+    started[v] = ++noteCounter;
+    active[v] = true;
+    released[v] = false;
+    fadeRate[v] = 0;
+
+    return v;
+}
+
+/*!
+    @brief releases the voice playing `note`, if any (O(1) via the note map)
+
+    @param note MIDI note number
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::noteOff(uint8_t note)
+{
+    note &= 0x7F;
+    int8_t v = noteVoice[note];
+    if (v == DSF_NO_VOICE) return;
+    active[v] = false;
+    noteVoice[note] = DSF_NO_VOICE;
+}
+
+/*!
+    @brief marks the voice playing `note` as released without silencing it
+
+    The voice keeps sounding and stays mapped to the note, for a caller that fades it out itself (such as `DsfSynth`
+    with its shared envelope) and stops it later with `noteOff()` or `allNotesOff()`. A new note takes a released voice
+    before it steals a held one; playing the note again holds it again.
+
+    @param note MIDI note number
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::noteRelease(uint8_t note)
+{
+    int8_t v = noteVoice[note & 0x7F];
+    if (v != DSF_NO_VOICE) released[v] = true;
+}
+
+/*!
+    @brief releases the voice playing `note` with its own fade: its gain falls linearly to 0 over `samples`, in steps at
+    the start of each render pass, and the voice stops when it gets there
+
+    Until then it counts as released (see `noteRelease()`) and stays mapped, so playing the note again retriggers it.
+
+    @param note MIDI note number
+    @param samples fade duration in samples (at least 1)
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::noteFade(uint8_t note, uint32_t samples)
+{
+    int8_t v = noteVoice[note & 0x7F];
+    if (v == DSF_NO_VOICE) return;
+    released[v] = true;
+    fadeLevel[v] = (uint32_t)gain[v] << 16;
+    fadeRate[v] = fadeLevel[v] / (samples ? samples : 1);
+    if (fadeRate[v] == 0) fadeRate[v] = 1;
+}
+
+/*!
+    @brief silences every voice
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::allNotesOff()
+{
+    for (uint8_t v = 0; v < N; v++) {
+        if (active[v]) noteVoice[voiceNote[v]] = DSF_NO_VOICE;
+        active[v] = released[v] = false;
+        fadeRate[v] = 0;
+    }
+}
+
+/*!
+    @brief sets `a` for every voice
+
+    @param param_a the `a` term from Moorer's equation, clamped to `param_a_min15 <= a <= param_a_max15`
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::setA(fix15 param_a)
+{
+    for (uint8_t v = 0; v < N; v++) setA(v, param_a);
+}
+
+/*!
+    @brief sets `a` for one voice
+
+    @param voice voice index as returned by `noteOn()`
+    @param param_a the `a` term from Moorer's equation, clamped to `param_a_min15 <= a <= param_a_max15`
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::setA(uint8_t voice, fix15 param_a)
+{
+    if (voice >= N) return;
+    if (param_a > param_a_max15) param_a = param_a_max15;
+    if (param_a < param_a_min15) param_a = param_a_min15;
+    if (param_a == paramA[voice]) return;
+    paramA[voice] = param_a;
+    coefficients(voice);
+}
+
+/*!
+    @brief sets the gain applied to the sum of all voices
+
+    @param gain fixed-point mix gain; `one15 / N` (the default) can never clip, larger values saturate at the DAC limits
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::setMixGain(fix15 gain)
+{
+    mixGain = gain;
+}
+
+/*!
+    @brief selects the sample kernel for every voice, see `DsfOsc::setKernel()`
+
+    @param k `kernel_divide` or `kernel_reciprocal`
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::setKernel(dsf_kernel_t k)
+{
+    kernel = k;
+}
+
+/*!
+    @brief switches every voice between the infinite and the band-limited finite sum, see `DsfOsc::setBandLimited()`
+
+    Each voice's sideband count follows its pitch (including bend and glide) and is updated at the start of every render
+    pass; `a^(N+1)` is recalculated when `a`, gain or the count changes.
+
+    @param on `true` for the band-limited finite sum
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::setBandLimited(bool on)
+{
+    bandLimited = on;
+    if (!on) return;
+    for (uint8_t v = 0; v < N; v++) {
+        bands[v] = DsfOsc::harmonics(stepNote[v], stepMod[v]);
+        bandPowers(v);
+    }
+}
+
+/*!
+    @brief shifts the pitch of every voice (pitch bend, vibrato)
+
+    Applied together with any glide at the start of each render pass (at most `DSF_POOL_BLOCK` samples), integer only.
+
+    @param octaves16 pitch offset in Q16 octaves, e.g. from `bendToOct16()`
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::pitch(int32_t octaves16)
+{
+    pitchOffset = octaves16;
+}
+
+/*!
+    @brief sets the portamento time used by `noteOn()` when `glideFrom16` is not 0
+
+    @param samples glide duration in samples; 0 disables glide
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::setGlideTime(uint32_t samples)
+{
+    glideSamples = samples;
+}
+
+/*!
+    @brief plays voices whose modulator is exactly twice or half the carrier from `cache` instead of the formula
+
+    Only the infinite sum is cached: in band-limited mode, and for every other ratio (inharmonic, Strange Mode), voices
+    render directly. `serviceCache()` fills the cache.
+
+    @param cache the cache, shared by every voice; `nullptr` renders every voice directly
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::setWaveCache(DsfWaveCache *cache)
+{
+    waveCache = cache;
+}
+
+/*!
+    @brief marks the cached cycles the sounding voices need and builds at most one that is missing
+
+    Call once per block, between blocks (never while a part is rendering): building a cycle costs about as much as
+    rendering `DSF_WAVE_LEN` samples of one voice directly. A voice plays from the cache once both slices either side of
+    its `a` are cached, and directly until then.
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::serviceCache()
+{
+    if (!waveCache || bandLimited) return;
+    waveCache->tick();
+
+    uint8_t missRatio = wave_direct, missLevel = 0;
+    for (uint8_t v = 0; v < N; v++) {
+        if (!active[v] || waveRatio[v] == wave_direct) continue;
+        uint32_t frac;
+        uint8_t level = DsfWaveCache::level(paramA[v], frac);
+        for (uint8_t l = level; l <= level + (frac != 0); l++) {
+            if (!waveCache->touch(waveRatio[v], l) && missRatio == wave_direct) {
+                missRatio = waveRatio[v];
+                missLevel = l;
+            }
+        }
+    }
+    if (missRatio != wave_direct) waveCache->build(missRatio, missLevel);
+}
+
+/*!
+    @return the number of voices currently sounding
+*/
+template <uint8_t N>
+uint8_t DsfVoicePool<N>::activeVoices() const
+{
+    uint8_t count = 0;
+    for (uint8_t v = 0; v < N; v++) count += active[v];
+    return count;
+}
+
+/*!
+    @return the number of voices sounding that haven't been released with `noteRelease()` or `noteFade()`
+*/
+template <uint8_t N>
+uint8_t DsfVoicePool<N>::heldVoices() const
+{
+    uint8_t count = 0;
+    for (uint8_t v = 0; v < N; v++) count += active[v] && !released[v];
+    return count;
+}
+
+/*!
+    @brief generates the next mixed sample
+
+    @return a 16-bit integer value that can be passed directly to the DAC
+*/
+template <uint8_t N>
+uint16_t DsfVoicePool<N>::getNextSample()
+{
+    uint16_t sample;
+    renderBlock(&sample, 1);
+    return sample;
+}
+
+/*!
+    @brief renders `n` mixed samples into a caller-supplied buffer
+
+    Voices are rendered one at a time into a fixed-point accumulator (voice-major, so each voice's state stays in
+    registers), then the sum is scaled by the mix gain, saturated and mapped to the DAC range.
+
+    @param out caller-supplied buffer of at least `n` samples
+    @param n the number of samples to render
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::renderBlock(uint16_t *out, size_t n)
+{
+    int32_t acc[DSF_POOL_BLOCK];
+
+    while (n > 0) {
+        size_t len = (n < DSF_POOL_BLOCK) ? n : DSF_POOL_BLOCK;
+        renderVoices(acc, len);
+        mixDown(out, acc, len);
+        out += len;
+        n -= len;
+    }
+}
+
+/*!
+    @brief renders the voices of one part of the pool into an accumulator, without mixing down
+
+    The first half of `renderBlock()`, for splitting the voices across cores or threads: part `p` of `parts` owns every
+    voice `v` with `v % parts == p`, so the parts share no voice state and can render at the same time. Interleaving
+    keeps the load even, because free voices are taken from the lowest index. Settings shared by all voices (pitch
+    offset, kernel, band limiting) must not change until every part has finished. Each voice is advanced in passes of
+    `DSF_POOL_BLOCK` samples with pitch and glide applied at the start of each pass, exactly as `renderBlock()` does,
+    so adding up the parts' accumulators in `mixDown()` gives the same samples.
+
+    @param acc receives `n` samples, the sum of this part's voices (overwritten, not added to)
+    @param n the number of samples to render
+    @param part which part to render, `0 <= part < parts`
+    @param parts the number of parts the pool is split into
+    @param passA optional `a` for each pass (`(n + DSF_POOL_BLOCK - 1) / DSF_POOL_BLOCK` values), set on each voice
+           with `setA(voice, a)` before its pass; `nullptr` keeps the current `a`
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::renderVoices(int32_t *acc, size_t n, uint8_t part, uint8_t parts, const fix15 *passA)
+{
+    for (size_t i = 0; i < n; i++) acc[i] = 0;
+
+    for (uint8_t v = part; v < N; v += parts) {
+        if (!active[v]) continue;
+
+        size_t pass = 0;
+        for (size_t done = 0; done < n; done += DSF_POOL_BLOCK, pass++) {
+            size_t len = (n - done < DSF_POOL_BLOCK) ? n - done : DSF_POOL_BLOCK;
+            if (passA) setA(v, passA[pass]);
+            modulate(v, len);
+            if (fadeRate[v] && !fade(v, len)) break;
+            if (!playCached(v, acc + done, len)) mixVoice(v, acc + done, len);
+        }
+    }
+}
+
+/*!
+    @brief the second half of `renderBlock()`: scales the accumulated voices by the mix gain, saturates and maps them to
+    the DAC range
+
+    @param out caller-supplied buffer of at least `n` samples
+    @param acc voices accumulated by `renderVoices()`
+    @param n the number of samples
+    @param acc2 optional second accumulator, added to `acc` (e.g. the other core's part)
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::mixDown(uint16_t *out, const int32_t *acc, size_t n, const int32_t *acc2) const
+{
+    for (size_t i = 0; i < n; i++) {
+        fix15 sample = multfix15(acc2 ? acc[i] + acc2[i] : acc[i], mixGain);
+        if (sample > one15) sample = one15;
+        if (sample < -one15) sample = -one15;
+        fix15 dacValue = multfix15(sample, halfDac) + halfDac;
+        out[i] = (uint16_t)fix2int15(dacValue);
+    }
+}
+
+/*!
+    @brief adds `n` samples of voice `v` into `acc` with the selected kernel
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::mixVoice(uint8_t v, int32_t *acc, size_t n)
+{
+    if (kernel == kernel_reciprocal) {
+        if (bandLimited) mix<kernel_reciprocal, true>(v, acc, n);
+        else mix<kernel_reciprocal, false>(v, acc, n);
+    } else {
+        if (bandLimited) mix<kernel_divide, true>(v, acc, n);
+        else mix<kernel_divide, false>(v, acc, n);
+    }
+}
+
+/*!
+    @brief adds `n` samples of voice `v` into `acc` from the waveform cache, if it can
+
+    The slower phase counter indexes the cycle (linear interpolation between its samples) and the voice's `a` crossfades
+    between the slices either side of it: three 32-bit multiplies per sample and no division. Both counters advance as
+    they would rendering directly, so the voice can switch between the two at any pass.
+
+    @return `false`, having done nothing, if the voice isn't eligible or its slices aren't cached
+*/
+template <uint8_t N>
+bool DsfVoicePool<N>::playCached(uint8_t v, int32_t *acc, size_t n)
+{
+    if (!waveCache || bandLimited || waveRatio[v] == wave_direct) return false;
+    uint32_t aFrac;
+    uint8_t level = DsfWaveCache::level(paramA[v], aFrac);
+    const int16_t *lo = waveCache->slice(waveRatio[v], level);
+    const int16_t *hi = aFrac ? waveCache->slice(waveRatio[v], level + 1) : lo;
+    if (!lo || !hi) return false;
+
+    const bool slowNote = (waveRatio[v] == wave_double);
+    uint32_t phase = slowNote ? countNote[v] : countMod[v];
+    const uint32_t step = slowNote ? stepNote[v] : stepMod[v];
+    const int32_t g = gain[v], af = (int32_t)aFrac;
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t idx = phase >> (32 - DSF_WAVE_BITS);
+        int32_t f = (int32_t)((phase >> (32 - DSF_WAVE_BITS - 15)) & 0x7FFF);
+        int32_t y0 = lo[idx] + (((lo[idx + 1] - lo[idx]) * f) >> 15);
+        int32_t y1 = hi[idx] + (((hi[idx + 1] - hi[idx]) * f) >> 15);
+        acc[i] += ((y0 + (((y1 - y0) * af) >> 15)) * g) >> 15;
+        phase += step;
+    }
+
+    countNote[v] += stepNote[v] * (uint32_t)n;
+    countMod[v] += stepMod[v] * (uint32_t)n;
+    return true;
+}
+
+/*!
+    @brief adds `n` samples of voice `v` into `acc`
+*/
+template <uint8_t N>
+template <dsf_kernel_t K, bool BAND>
+void DsfVoicePool<N>::mix(uint8_t v, int32_t *acc, size_t n)
+{
+    uint32_t cNote = countNote[v], cMod = countMod[v];
+    const uint32_t sNote = stepNote[v], sMod = stepMod[v], nBands = bands[v];
+    const fix15 num = numScale[v], den = denBase[v], twoAv = twoA[v], aN1 = bandN1[v], aN2 = bandN2[v];
+
+    for (size_t i = 0; i < n; i++) {
+        fix15 numerator = multfix15(BAND ? num - DsfOsc::bandTail(cMod, nBands, aN1, aN2) : num, DsfOsc::sine(cNote));
+        fix15 denominator = den - multfix15(twoAv, DsfOsc::cosine(cMod));
+        acc[i] += (K == kernel_reciprocal) ? recipdivfix15(numerator, denominator) : divfix15(numerator, denominator);
+        cNote += sNote;
+        cMod += sMod;
+    }
+
+    countNote[v] = cNote;
+    countMod[v] = cMod;
+}
+
+/*!
+    @brief applies the pitch offset and glide to the increments of voice `v`, then advances its glide by `n`
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::modulate(uint8_t v, size_t n)
+{
+    int32_t offset = pitchOffset + (glide[v] >> 8);
+    stepNote[v] = offset ? pitchStep(baseNote[v], offset) : baseNote[v];
+    stepMod[v] = offset ? pitchStep(baseMod[v], offset) : baseMod[v];
+
+    if (bandLimited) {
+        uint32_t b = DsfOsc::harmonics(stepNote[v], stepMod[v]);
+        if (b != bands[v]) {
+            bands[v] = b;
+            bandPowers(v);
+        }
+    }
+
+    if (glide[v] != 0) {
+        int32_t next = glide[v] + glideRate[v] * (int32_t)n;
+        glide[v] = ((next ^ glide[v]) < 0) ? 0 : next; // stop at the note's own pitch
+    }
+}
+
+/*!
+    @brief lowers the gain of a fading voice for a pass of `n` samples, and stops the voice when it reaches 0
+
+    @return `false` if the voice has stopped
+*/
+template <uint8_t N>
+bool DsfVoicePool<N>::fade(uint8_t v, size_t n)
+{
+    uint32_t drop = fadeRate[v] * (uint32_t)n;
+    fadeLevel[v] = (fadeLevel[v] > drop) ? fadeLevel[v] - drop : 0;
+    gain[v] = (fix15)(fadeLevel[v] >> 16);
+    if (gain[v] == 0) {
+        if (noteVoice[voiceNote[v]] == (int8_t)v) noteVoice[voiceNote[v]] = DSF_NO_VOICE;
+        active[v] = released[v] = false;
+        fadeRate[v] = 0;
+        return false;
+    }
+    coefficients(v);
+    return true;
+}
+
+/*!
+    @brief picks the voice for a new note: a free voice, otherwise the oldest released one, otherwise the quietest,
+    otherwise the oldest
+
+    @return voice index
+*/
+template <uint8_t N>
+uint8_t DsfVoicePool<N>::allocate()
+{
+    uint8_t best = 0;
+    for (uint8_t v = 0; v < N; v++) {
+        if (!active[v]) return v;
+        bool older = (int32_t)(started[v] - started[best]) < 0;
+        if (released[v] != released[best]) {
+            if (released[v]) best = v;
+        } else if (released[v] ? older : gain[v] < gain[best] || (gain[v] == gain[best] && older)) {
+            best = v;
+        }
+    }
+    return best;
+}
+
+/*!
+    @brief recalculates the per-voice terms that depend on `a` and gain
+
+    The numerator scale is `gain * (1 - a)^2`, i.e. `(1 - a^2)` from Moorer's formula times the peak normalisation
+    `(1 - a) / (1 + a)`.
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::coefficients(uint8_t v)
+{
+    fix15 a = paramA[v];
+    fix15 oneMinusA = one15 - a;
+    numScale[v] = multfix15(multfix15(oneMinusA, oneMinusA), gain[v]);
+    denBase[v] = one15 + multfix15(a, a);
+    twoA[v] = multfix15(two15, a);
+    if (bandLimited) bandPowers(v);
+}
+
+/*!
+    @brief recalculates `a^(N+1)` and `a^(N+2)` of a voice, scaled by the same `gain * (1 - a) / (1 + a)` as `numScale`
+*/
+template <uint8_t N>
+void DsfVoicePool<N>::bandPowers(uint8_t v)
+{
+    fix15 a = paramA[v];
+    fix15 norm = divfix15(multfix15(one15 - a, gain[v]), one15 + a);
+    bandN1[v] = multfix15(DsfOsc::powA(a, bands[v] + 1), norm);
+    bandN2[v] = multfix15(bandN1[v], a);
+}
@@ -0,0 +1,121 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Single-Cycle Waveform Cache
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-wave-cache.h"
+
+/*!
+    @brief the sine used to build cycles: 4096 entries, interpolated, so a cached cycle is more accurate than the 256-entry
+    table the voices read when rendering directly
+*/
+typedef DsfOscT<dsf_arith_fix15, 12, lookup_linear> dsf_wave_osc_t;
+
+/*!
+    @brief Constructor, for `DsfWaveCacheN`. Starts empty.
+
+    @param storage `slots` slots, owned by the derived class
+    @param slots number of slots
+*/
+DsfWaveCache::DsfWaveCache(dsf_wave_slot_t *storage, uint16_t slots)
+{
+    slot = storage;
+    slotCount = slots;
+    clear();
+}
+
+/*!
+    @brief empties every slot; only between blocks, like `build()`
+*/
+void DsfWaveCache::clear()
+{
+    for (uint16_t s = 0; s < slotCount; s++) {
+        slot[s].key = DSF_WAVE_NONE;
+        slot[s].used = 0;
+    }
+    for (uint8_t r = 0; r < wave_ratios - wave_double; r++) {
+        for (uint8_t l = 0; l <= DSF_WAVE_A_STEPS; l++) slotOf[r][l] = DSF_WAVE_NONE;
+    }
+}
+
+/*!
+    @brief starts a new round: slices `touch()`ed from here on are the ones in use
+*/
+void DsfWaveCache::tick()
+{
+    round++;
+}
+
+/*!
+    @brief marks a slice as needed in this round
+
+    @param ratio `wave_double` or `wave_half`
+    @param level slice on the `a` grid, 0 to `DSF_WAVE_A_STEPS`
+    @return `false`, counted in `misses()`, if it isn't cached
+*/
+bool DsfWaveCache::touch(uint8_t ratio, uint8_t level)
+{
+    uint16_t s = slotOf[ratio - wave_double][level];
+    if (s == DSF_WAVE_NONE) {
+        missCount++;
+        return false;
+    }
+    slot[s].used = round;
+    return true;
+}
+
+/*!
+    @brief renders one cycle into the least recently used slot
+
+    Costs `DSF_WAVE_LEN` samples of direct rendering (a division each), so call it between blocks, at most once per
+    block. The slot is taken from the slices not needed in this round; if every slot is, nothing is built.
+
+    @param ratio `wave_double` or `wave_half`
+    @param level slice on the `a` grid, 0 to `DSF_WAVE_A_STEPS`
+    @return `true` if the slice is cached now
+*/
+bool DsfWaveCache::build(uint8_t ratio, uint8_t level)
+{
+    if (slotOf[ratio - wave_double][level] != DSF_WAVE_NONE) return true;
+
+    uint16_t victim = DSF_WAVE_NONE;
+    for (uint16_t s = 0; s < slotCount; s++) {
+        if (slot[s].used == round) continue;
+        if (victim == DSF_WAVE_NONE || (int32_t)(slot[s].used - slot[victim].used) < 0) victim = s;
+    }
+    if (victim == DSF_WAVE_NONE) return false;
+
+    dsf_wave_slot_t &w = slot[victim];
+    if (w.key != DSF_WAVE_NONE) slotOf[w.key >> 8][w.key & 0xFF] = DSF_WAVE_NONE;
+
+    // the same terms as a DsfVoicePool voice at gain 1
+    fix15 a = levelA(level), oneMinusA = one15 - a;
+    fix15 num = multfix15(oneMinusA, oneMinusA), den = one15 + multfix15(a, a), twoA = multfix15(two15, a);
+    for (uint32_t i = 0; i < DSF_WAVE_LEN; i++) {
+        uint32_t phase = i << (32 - DSF_WAVE_BITS);
+        // the cycle follows the slower of the two: θ = p, β = 2p for wave_double, θ = 2p, β = p for wave_half
+        uint32_t phaseNote = (ratio == wave_double) ? phase : phase * 2, phaseMod = (ratio == wave_double) ? phase * 2 : phase;
+        fix15 y = divfix15(multfix15(num, dsf_wave_osc_t::sine(phaseNote)),
+                           den - multfix15(twoA, dsf_wave_osc_t::cosine(phaseMod)));
+        w.v[i] = (int16_t)((y > INT16_MAX) ? INT16_MAX : (y < -INT16_MAX) ? -INT16_MAX : y);
+    }
+    w.v[DSF_WAVE_LEN] = w.v[0];
+
+    w.key = (uint16_t)(((ratio - wave_double) << 8) | level);
+    w.used = round;
+    slotOf[ratio - wave_double][level] = victim;
+    buildCount++;
+    return true;
+}
+
+/*!
+    @return the number of slots holding a cycle
+*/
+uint16_t DsfWaveCache::cached() const
+{
+    uint16_t n = 0;
+    for (uint16_t s = 0; s < slotCount; s++) n += (slot[s].key != DSF_WAVE_NONE);
+    return n;
+}
@@ -0,0 +1,166 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Single-Cycle Waveform Cache
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * When the modulator is exactly twice or half the carrier the
+ * DSF output is periodic, so one cycle can be rendered into a
+ * wavetable once and played back with a phase accumulator:
+ * no division per sample. Cycles are cached per ratio and per
+ * quantised `a` in a fixed number of slots, least recently
+ * used first out; playback crossfades between the two slices
+ * either side of the voice's `a`.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-oscillator-pico.h"
+
+/*
+ * CACHE SETTINGS
+ */
+#define DSF_WAVE_BITS 9 // samples per cached cycle: 2^9 = 512, linearly interpolated
+#define DSF_WAVE_LEN (1 << DSF_WAVE_BITS)
+#define DSF_WAVE_A_STEPS 32 // param_a_min15..param_a_max15 in 32 steps: 33 slices per ratio
+#define DSF_WAVE_NONE 0xFFFF // slotOf value of a slice that isn't cached
+#define DSF_WAVE_SLACK 16 // phase increment LSB a 2:1 ratio may be off by from rounding (drifts < 0.001 cycle/s)
+
+/*!
+    @brief the carrier/modulator relationships the cache can play
+
+    @param wave_direct anything else (inharmonic, Strange Mode): rendered with the formula
+    @param wave_double modulator twice the carrier (the cycle is one carrier period)
+    @param wave_half modulator half the carrier (the cycle is one modulator period)
+*/
+enum dsf_wave_ratio_t : uint8_t
+{
+    wave_direct,
+    wave_double,
+    wave_half,
+    wave_ratios
+};
+
+/*!
+    @brief one cached cycle: `DSF_WAVE_LEN` samples plus a copy of the first, so interpolation never wraps
+
+    @param v the samples, `(1 - a)^2 sin θ / (1 + a^2 - 2a cos β)` in Q15 at gain 1 (as a `DsfVoicePool` voice before
+           its gain), saturated to the int16 range
+    @param used `DsfWaveCache` round it was last needed in
+    @param key ratio and level it holds, `DSF_WAVE_NONE` if empty
+*/
+typedef struct {
+    int16_t v[DSF_WAVE_LEN + 1];
+    uint32_t used;
+    uint16_t key;
+} dsf_wave_slot_t;
+
+/*!
+    @brief Cache of single-cycle DSF waveforms, shared by the voices of a `DsfVoicePool` (see `setWaveCache()`).
+
+    Rendering reads the cache only (`slice()`), so several cores can play from it at once. Everything that changes it
+    (`tick()`, `touch()`, `build()`) runs between blocks, from `DsfVoicePool::serviceCache()`: each round marks the
+    slices the sounding voices need and builds at most one missing slice, evicting the slice that has gone unused the
+    longest; a slice needed in the current round is never evicted. A voice whose slices are not cached (yet) renders
+    directly, so the cache changes how much a sample costs but never whether it is produced.
+
+    The storage is provided by `DsfWaveCacheN<SLOTS>`; about 1 KB per slot.
+*/
+class DsfWaveCache {
+
+    public:
+        void clear();
+        void tick();
+        bool touch(uint8_t ratio, uint8_t level);
+        bool build(uint8_t ratio, uint8_t level);
+
+        /*!
+            @return the cached cycle for `ratio` and `level`, `nullptr` if it isn't cached
+        */
+        inline const int16_t *slice(uint8_t ratio, uint8_t level) const
+        {
+            uint16_t s = slotOf[ratio - wave_double][level];
+            return (s == DSF_WAVE_NONE) ? nullptr : slot[s].v;
+        }
+
+        /*!
+            @brief which relationship a pair of phase increments has
+
+            Increments converted from fix15 frequencies are off from an exact 2:1 by a few LSB (`DsfTuning`'s are
+            exact), so up to `DSF_WAVE_SLACK` is accepted: playing such a voice from the cache locks the relative
+            phase that direct rendering would let drift by less than a thousandth of a cycle per second.
+
+            @param stepNote carrier increment
+            @param stepMod modulator increment
+            @return `wave_double`, `wave_half` or `wave_direct`
+        */
+        static inline uint8_t ratio(uint32_t stepNote, uint32_t stepMod)
+        {
+            int64_t twiceNote = 2 * (int64_t)stepNote, twiceMod = 2 * (int64_t)stepMod;
+            if (stepMod - twiceNote >= -DSF_WAVE_SLACK && stepMod - twiceNote <= DSF_WAVE_SLACK) return wave_double;
+            if (stepNote - twiceMod >= -DSF_WAVE_SLACK && stepNote - twiceMod <= DSF_WAVE_SLACK) return wave_half;
+            return wave_direct;
+        }
+
+        /*!
+            @brief where `a` falls on the slice grid
+
+            @param a `param_a_min15 <= a <= param_a_max15`
+            @param frac receives the position between `level` and `level + 1`, 0 to 32767
+            @return the slice at or below `a`, 0 to `DSF_WAVE_A_STEPS`
+        */
+        static inline uint8_t level(fix15 a, uint32_t &frac)
+        {
+            uint32_t pos = (uint32_t)(a - param_a_min15) * DSF_WAVE_A_STEPS;
+            uint32_t l = pos / (uint32_t)param_a_range;
+            frac = ((pos - l * (uint32_t)param_a_range) << 15) / (uint32_t)param_a_range;
+            return (uint8_t)l;
+        }
+
+        /*!
+            @return the `a` of slice `level`
+        */
+        static inline fix15 levelA(uint8_t level) { return param_a_min15 + param_a_range * level / DSF_WAVE_A_STEPS; }
+
+        uint16_t slots() const { return slotCount; }
+        uint16_t cached() const;
+        uint32_t builds() const { return buildCount; }
+        uint32_t misses() const { return missCount; }
+
+    protected:
+        DsfWaveCache(dsf_wave_slot_t *storage, uint16_t slots);
+
+    private:
+        dsf_wave_slot_t *slot;
+        uint16_t slotCount;
+        uint16_t slotOf[wave_ratios - wave_double][DSF_WAVE_A_STEPS + 1];
+        uint32_t round = 1, buildCount = 0, missCount = 0;
+};
+
+/*!
+    @brief a `DsfWaveCache` with room for `SLOTS` cycles
+
+    33 slots cover every `a` of one ratio, 66 both.
+
+    @tparam SLOTS number of cached cycles
+*/
+template <uint16_t SLOTS>
+class DsfWaveCacheN : public DsfWaveCache {
+
+    static_assert(SLOTS > 0 && SLOTS < DSF_WAVE_NONE, "DsfWaveCacheN needs at least one slot");
+
+    public:
+        DsfWaveCacheN() : DsfWaveCache(storage, SLOTS) {}
+
+    private:
+        dsf_wave_slot_t storage[SLOTS];
+};
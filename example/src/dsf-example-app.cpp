@@ -0,0 +1,370 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Example Implementation: Application Loop
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-example-app.h"
+
+#include <cstring>
+
+const char *const deadlineStageNames[deadline_stages] = { "adc", "envelope", "midi", "kernel", "dac" };
+
+DsfExampleApp *DsfExampleApp::rendering = nullptr;
+
+/*!
+    @brief Constructor. Touches no hardware; see `setup()`.
+
+    @param hal the hardware to run on
+*/
+DsfExampleApp::DsfExampleApp(DsfHal &hal)
+    : synth(SAMPLE_RATE, DAC_BIT_DEPTH, ENV_PERIOD_BITS), hal(hal)
+{
+}
+
+/*!
+    @brief glide, waveform cache, bend range, MIDI channel and SysEx capture, envelope; shows the button states on the
+    status LEDs
+*/
+void DsfExampleApp::setup()
+{
+    hal.gpioPut(pinStatusHarmonic, isHarmonic);
+    hal.gpioPut(pinStatusEnvInvert, envInvert);
+    hal.gpioPut(pinStatusMult, multState);
+
+    synth.voices.setGlideTime(GLIDE_MS * SAMPLE_RATE / 1000);
+    if (WAVE_CACHE) synth.voices.setWaveCache(&waveCache);
+    synth.setBendRange(BEND_RANGE);
+    midiParser.setChannel(MIDI_CHANNEL);
+    midiParser.captureSysEx(sysExBuf, sizeof(sysExBuf));
+    synth.setEnvInvert(envInvert);
+    synth.env.setShape(ENV_SHAPE);
+}
+
+/*!
+    @brief starts the audio clock (call right after the sink starts) and, with `trace`, records from here on
+
+    @param writer where to record, or `nullptr`
+    @param rate16 the rate the sink really plays, in Q16.16 Hz, so `audioClock()` keeps pace with `sink.position()`
+*/
+void DsfExampleApp::start(DsfTraceWriter *writer, uint32_t rate16)
+{
+    audioStartUs = hal.timeUs();
+    audioRate16 = rate16;
+    trace = writer;
+    if (trace) trace->begin({ SAMPLE_RATE, SINK_BLOCK, DAC_BIT_DEPTH, VOICES });
+}
+
+/*!
+    @brief one pass of the main loop: brings the inputs up to date, then renders every block the sink will take
+
+    The sink plays at `SAMPLE_RATE` on its own; the loop only has to stay up to `SINK_BLOCKS - 1` blocks ahead.
+*/
+void DsfExampleApp::loop()
+{
+    hal.stageStart();
+    hal.poll();
+    hal.stageEnd(stage_adc);
+
+    DsfAudioSink &sink = hal.dac();
+    while (uint16_t *block = sink.acquire()) {
+        uint32_t due = sink.position();
+        blockIndex = sink.blocks();
+        hal.blockStart();
+        renderBlock(block, due);
+        sink.commit();
+        hal.stageEnd(stage_dac);
+        hal.blockEnd((int32_t)(due - audioClock()));
+    }
+
+    if (VERBOSE && sink.underruns() != lastUnderruns) {
+        lastUnderruns = sink.underruns();
+        verboseLog.log(log_main, "Output underruns: %u", lastUnderruns);
+    }
+    if (VERBOSE && midiQueue.overflows() != lastMidiOverflows) {
+        lastMidiOverflows = midiQueue.overflows();
+        verboseLog.log(log_main, "MIDI queue overflows: %u", lastMidiOverflows);
+    }
+}
+
+/*!
+    @brief renders one sink block: applies the inputs that have arrived, then renders in spans that end where the next
+    MIDI message is due
+
+    The spans come from `synth.applyDue()`, so a note starts at a fixed `MIDI_LATENCY` after it arrived instead of at
+    the next block boundary. Inputs and MIDI only change the synth between spans, never while one is rendering.
+
+    @param block the sink block to fill
+    @param position the sample clock of the block's first sample, `sink.position()`
+*/
+void DsfExampleApp::renderBlock(uint16_t *block, uint32_t position)
+{
+    blockPosition = position;
+    if (trace && position != nextPosition) trace->position(blockIndex, position);
+    nextPosition = position + SINK_BLOCK;
+
+    serviceTuning();
+    dsf_input_t in;
+    while (hal.pollInput(in)) apply(in);
+    readEnvelopeControls();
+    // the last note's release has finished and its voice has stopped
+    if (synth.service()) hal.gpioPut(pinLED, false);
+    hal.stageEnd(stage_envelope);
+
+    dsf_note_mode_t mode = { strangeMode, (uint8_t)strangeKeyIndex, isHarmonic, multState };
+    rendering = this;
+    size_t done = 0;
+    while (done < SINK_BLOCK) {
+        spanOffset = done;
+        size_t len = synth.applyDue(midiQueue, position + done, SINK_BLOCK - done, mode, midiApplied);
+        hal.stageEnd(stage_midi);
+        renderSpan(block + done, len);
+        done += len;
+    }
+
+    if (trace) {
+        trace->samples(block, SINK_BLOCK);
+        if ((blockIndex + 1) % TRACE_CHECK_BLOCKS == 0) trace->check(blockIndex);
+    }
+}
+
+/*!
+    @brief applies one input between blocks, and records it
+
+    MIDI messages come from the trace only on a replay (on the device they arrive through `midiQueue`); they go into the
+    queue stamped with the sample they were applied at, so `applyDue()` splits the spans where it did on the device.
+*/
+void DsfExampleApp::apply(const dsf_input_t &in)
+{
+    if (trace && in.type != input_midi) trace->input(blockIndex, in);
+
+    switch (in.type) {
+    case input_control:
+        if (in.id < ADC_CHANNELS) controlValue[in.id] = (uint16_t)in.value;
+        break;
+
+    case input_button:
+        pressButton(in.id, in.value);
+        break;
+
+    case input_encoder:
+        turnEncoder(in.value);
+        break;
+
+    case input_midi:
+        midiQueue.push({ in.midi[0], in.midi[1], in.midi[2], blockPosition + in.offset });
+        break;
+
+    case input_sysex: {
+        bool loaded = synth.tuning.loadMts(in.data, in.len);
+        if (VERBOSE) verboseLog.log(log_main, loaded ? "Tuning dump loaded" : "SysEx ignored (%d bytes, not a tuning dump)", (int32_t)in.len);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+/*!
+    @brief hands the envelope pots to the envelope; it only recalculates its increments when a time actually changes
+*/
+void DsfExampleApp::readEnvelopeControls()
+{
+    uint32_t decayMs = uscale(controlValue[adc_in_EnvDecay], 0, DSF_CTRL_MAX, ENV_TIME_MIN, ENV_TIME_MAX);
+    synth.env.setAttack(uscale(controlValue[adc_in_EnvAttack], 0, DSF_CTRL_MAX, ENV_TIME_MIN, ENV_TIME_MAX));
+    synth.env.setDecay(decayMs);
+    synth.env.setRelease(decayMs);
+    synth.env.setSustain((fix15)uscale(controlValue[adc_in_EnvSustain], 0, DSF_CTRL_MAX, 0, one15));
+}
+
+/*!
+    @brief a button interrupt, applied between blocks: the panel buttons toggle their mode and status LED, the encoder
+    switch toggles Strange Mode
+*/
+void DsfExampleApp::pressButton(uint8_t button, int16_t value)
+{
+    switch (button)
+    {
+    case button_harmonic:
+        isHarmonic = !isHarmonic;
+        hal.gpioPut(pinStatusHarmonic, isHarmonic);
+        break;
+
+    case button_env_invert:
+        envInvert = !envInvert;
+        synth.setEnvInvert(envInvert);
+        hal.gpioPut(pinStatusEnvInvert, envInvert);
+        break;
+
+    case button_mult:
+        multState = !multState;
+        hal.gpioPut(pinStatusMult, multState);
+        break;
+
+    case button_encoder:
+        if (value) strangeMode = !strangeMode;
+        if (strangeMode) {
+            showStrangeKey();
+            if (VERBOSE) verboseLog.log(log_main, "strangeMode engaged (%d)", strangeMode);
+        } else {
+            hal.gpioMask(0xF << pinBarGraphStart, false);
+            if (VERBOSE) verboseLog.log(log_main, "strangeMode disengaged (%d)", strangeMode);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/*!
+    @brief encoder steps, applied between blocks: in Strange Mode they pick the carrier root, wrapping 0-7
+*/
+void DsfExampleApp::turnEncoder(int16_t steps)
+{
+    if (!strangeMode) return;
+    if (VERBOSE) verboseLog.log(log_main, "Encoder turned, value %d", steps);
+    if (steps == 0) return;
+    strangeKeyIndex += steps;
+    if (strangeKeyIndex > 7) strangeKeyIndex = 0;
+    if (strangeKeyIndex < 0) strangeKeyIndex = 7;
+    if (VERBOSE) verboseLog.log(log_main, "New index %d", strangeKeyIndex);
+    showStrangeKey();
+}
+
+void DsfExampleApp::showStrangeKey()
+{
+    uint32_t barGraphSetMask = 0;
+    uint32_t barGraphClearMask = (0xFF << pinBarGraphStart);
+    hal.gpioMask(barGraphClearMask, false);
+    if (VERBOSE) verboseLog.log(log_main, "barGraphClearMask = %d, clearing pins %08x", barGraphClearMask, barGraphClearMask);
+    for (int8_t pos = 0; pos <= strangeKeyIndex; pos++) barGraphSetMask |= (1 << (pinBarGraphStart + pos));
+    if (VERBOSE) verboseLog.log(log_main, "strangeKeyIndex = %d, barGraphSetMask = %d [%08x]", strangeKeyIndex, barGraphSetMask, barGraphSetMask);
+    hal.gpioMask(barGraphSetMask, true);
+}
+
+/*!
+    @brief renders `n` samples, on both cores if `DUAL_CORE_RENDER` is set and the HAL has a second core
+
+    Core 0 prepares the span (envelope, `a` per pass), starts core 1 on the odd voices, renders the even ones, waits
+    for core 1 and mixes both parts down. The synth is only changed by core 0 between spans. On one core the same
+    three steps render all voices, which is what `synth.renderBlock()` does, but with the envelope and the voices timed
+    apart; the codes are the same either way.
+*/
+void DsfExampleApp::renderSpan(uint16_t *out, size_t n)
+{
+    synth.prepareBlock(n);
+    hal.stageEnd(stage_envelope);
+
+    if (DUAL_CORE_RENDER && hal.core1Start(n)) {
+        synth.renderPart(renderAcc[0], n, 0, 2);
+        hal.core1Wait(); // core 1 is done with renderAcc[1]
+        synth.finishBlock(out, n, renderAcc[0], renderAcc[1]);
+    } else {
+        synth.renderPart(renderAcc[0], n, 0, 1);
+        synth.finishBlock(out, n, renderAcc[0]);
+    }
+    hal.stageEnd(stage_kernel);
+}
+
+/*!
+    @brief core 1's half of `renderSpan()`: the odd voices of the span core 0 has started
+*/
+void DsfExampleApp::renderCore1Part(size_t n)
+{
+    synth.renderPart(renderAcc[1], n, 1, 2);
+}
+
+/*!
+    @brief core 1: decodes a chunk of the USB MIDI stream and queues its messages for core 0, stamped `due`; a full
+    queue drops the message and counts it
+*/
+void DsfExampleApp::receiveMidi(const uint8_t *bytes, size_t n, uint32_t due)
+{
+    midiParser.parse(bytes, n, due, [this](const dsf_midi_event_t &e) { midiQueue.push(e); });
+}
+
+/*!
+    @brief core 1: passes a SysEx message `midiParser` has captured to core 0, once core 0 has taken the last one
+*/
+void DsfExampleApp::handOffTuning()
+{
+    size_t len = midiParser.sysEx();
+    if (len == 0 || tuningDumpLen.load(std::memory_order_acquire) != 0) return;
+    memcpy(tuningDump, sysExBuf, len);
+    tuningDumpLen.store(len, std::memory_order_release);
+    midiParser.releaseSysEx();
+}
+
+/*!
+    @brief applies a tuning dump handed over by core 1 as an `input_sysex`, between blocks so rebuilding the tables
+    never lands inside a render
+*/
+void DsfExampleApp::serviceTuning()
+{
+    size_t len = tuningDumpLen.load(std::memory_order_acquire);
+    if (len == 0) return;
+    dsf_input_t in = {};
+    in.type = input_sysex;
+    in.len = (uint16_t)len;
+    in.data = tuningDump;
+    apply(in);
+    tuningDumpLen.store(0, std::memory_order_release);
+}
+
+/*!
+    @return the audio sample clock: samples played since `start()` at the sink's rate, from the HAL's timer; safe on
+    either core
+*/
+uint32_t DsfExampleApp::audioClock()
+{
+    uint64_t us = hal.timeUs() - audioStartUs;
+    // whole seconds and the rest apart, so the Q16 product can't overflow
+    uint64_t samples16 = (us / 1000000) * audioRate16 + (us % 1000000) * audioRate16 / 1000000;
+    return (uint32_t)(samples16 >> 16);
+}
+
+/*!
+    @brief called by `synth.applyDue()` after each MIDI message is applied: records it with the sample it was applied
+    at, lights the LED on a note-on and prints notes with `VERBOSE`
+
+    Runs between render spans, so the printout goes to `verboseLog` rather than straight to the UART.
+*/
+void DsfExampleApp::midiApplied(const dsf_midi_event_t &e)
+{
+    DsfExampleApp &app = *rendering;
+    if (app.trace) {
+        dsf_input_t in = {};
+        in.type = input_midi;
+        in.offset = (uint16_t)app.spanOffset;
+        in.midi[0] = e.status;
+        in.midi[1] = e.data1;
+        in.midi[2] = e.data2;
+        app.trace->input(app.blockIndex, in);
+    }
+
+    if ((e.status & 0xF0) == 0x90 && e.data2 > 0) {
+        if (VERBOSE) {
+            uint32_t stepNote, stepMod;
+            dsf_note_mode_t mode = { app.strangeMode, (uint8_t)app.strangeKeyIndex, app.isHarmonic, app.multState };
+            app.synth.tuning.steps(e.data1, mode, stepNote, stepMod);
+            fix15 fNote = STEP_HZ(stepNote), fMod = STEP_HZ(stepMod);
+            if (app.strangeMode) {
+                app.verboseLog.log(log_main, "Note On: Strange Mode Carrier = %d.%02d, Modulator = %d.%02d (MIDI %d)", LOG_HZ(fNote), LOG_HZ(fMod), e.data1);
+            } else {
+                app.verboseLog.log(log_main, "Note On: %d (%d.%02d Hz)", e.data1, LOG_HZ((fix15)(app.synth.tuning.freq16(e.data1) >> 1)));
+                app.verboseLog.log(log_main, "      >>> Carrier = %d.%02d, Modulator = %d.%02d", LOG_HZ(fNote), LOG_HZ(fMod));
+            }
+        }
+        app.hal.gpioPut(pinLED, true);
+    } else if (VERBOSE && ((e.status & 0xF0) == 0x80 || (e.status & 0xF0) == 0x90)) {
+        app.verboseLog.log(log_main, ">>>>>Note Off: %d", e.data1);
+    }
+}
+
+uint32_t uscale(uint32_t x, uint32_t in_min, uint32_t in_max, uint32_t out_min, uint32_t out_max)
+{
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
@@ -0,0 +1,179 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Example Implementation: Application Loop
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Everything the example does between its inputs and the
+ * DAC: applying pots, buttons, encoder, MIDI and tuning dumps
+ * between blocks, the envelope, and rendering each sink block
+ * on one or both cores. It talks to the hardware only through
+ * `DsfHal`, so the firmware (`dsf-oscillator-example.cpp`)
+ * and the host replay (`host/dsf-replay.cpp`) run the same
+ * code and render the same DAC codes from the same inputs.
+ ************************************************************/
+
+#pragma once
+
+/********************
+ * C++ HEADERS
+ ********************/
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/********************
+ * LIBRARIES
+ ********************/
+#include "../../dsf-oscillator-pico.h"
+#include "../../dsf-synth.h"
+#include "../../dsf-wave-cache.h"
+#include "../../dsf-tuning.h"
+#include "../../dsf-controls.h"
+#include "../../dsf-midi-queue.h"
+#include "../../dsf-midi-parser.h"
+#include "../../dsf-log.h"
+#include "../../dsf-hal.h"
+#include "../../dsf-trace.h"
+#include "dsf-example-config.h"
+
+/*!
+    @brief the contexts that write to `verboseLog`, one channel each: core 0's main loop (and the render path it runs),
+    core 0's GPIO interrupt and core 1's USB host callbacks
+*/
+enum log_channel_t : uint8_t
+{
+    log_main,
+    log_irq,
+    log_usb,
+    log_channels
+};
+
+/*!
+    @brief the stages of the main loop that the deadline monitor times: control input filtering, envelope (inputs, pots
+    and the per-block envelope), MIDI applied between spans, the voices (`DsfSynth` render and mix-down) and handing the
+    block to the DAC sink
+*/
+enum deadline_stage_t : uint8_t
+{
+    stage_adc,
+    stage_envelope,
+    stage_midi,
+    stage_kernel,
+    stage_dac,
+    deadline_stages
+};
+extern const char *const deadlineStageNames[deadline_stages];
+
+/*!
+    @brief the `id` of an `input_button`: the three panel buttons toggle on a falling edge, the encoder switch toggles
+    Strange Mode when its `value` is 1 (pressed)
+*/
+enum example_button_t : uint8_t
+{
+    button_harmonic,
+    button_env_invert,
+    button_mult,
+    button_encoder
+};
+
+// a fix15 frequency as two log arguments for "%d.%02d": whole Hz and hundredths
+#define LOG_HZ(f) fix2int15((f)), (int32_t)((((f) & 0x7FFF) * 100) >> 15)
+// a phase increment back to a fix15 frequency, as `synth.tuning` plays it: step * fs / 2^32
+#define STEP_HZ(step) ((fix15)(((uint64_t)(step) * SAMPLE_RATE) >> 17))
+
+uint32_t uscale(uint32_t x, uint32_t in_min, uint32_t in_max, uint32_t out_min, uint32_t out_max);
+
+/*!
+    @brief The example's application loop on top of a `DsfHal`.
+
+    `loop()` is one pass of the main loop. For every block the sink takes, `renderBlock()` first applies the inputs
+    that have arrived (`DsfHal::pollInput()` and tuning dumps from core 1), then renders the block in spans split at
+    the MIDI messages' timestamps. Nothing else changes the synth, so the DAC codes depend only on the inputs and the
+    block each one was applied before. With a `DsfTraceWriter` set, exactly those are recorded, together with a
+    checksum of the codes every `TRACE_CHECK_BLOCKS` blocks.
+
+    Core 1 (USB host) only calls `receiveMidi()`, `handOffTuning()`, `renderCore1Part()` and `audioClock()`.
+*/
+class DsfExampleApp {
+
+    public:
+        explicit DsfExampleApp(DsfHal &hal);
+        void setup();
+        void start(DsfTraceWriter *trace = nullptr, uint32_t rate16 = (uint32_t)SAMPLE_RATE << 16);
+        void loop();
+        void renderBlock(uint16_t *block, uint32_t position);
+        void renderCore1Part(size_t n);
+        void receiveMidi(const uint8_t *bytes, size_t n, uint32_t due);
+        void handOffTuning();
+        uint32_t audioClock();
+
+        /*!
+            @brief the voices and the one ADSR envelope they share; its level sweeps `param_a` across
+            `param_a_min15..param_a_max15`, and the decay pot also sets the release time
+        */
+        DsfSynth<VOICES> synth;
+
+        /*!
+            @brief single cycles for `WAVE_CACHE`; `synth.service()` fills it between blocks, the render reads it on
+            both cores
+        */
+        DsfWaveCacheN<WAVE_CACHE_SLOTS> waveCache;
+
+        /*!
+            @brief MIDI messages decoded by `midiParser` in `receiveMidi()` on core 1, stamped with their due sample;
+            core 0 applies each one to `synth` at that sample
+        */
+        DsfMidiParser midiParser;
+        DsfMidiQueue<MIDI_QUEUE_SIZE> midiQueue;
+
+        /*!
+            @brief `VERBOSE` messages from time-critical code; core 1 formats them and feeds them to the UART between
+            its other work
+        */
+        DsfLog<log_channels, LOG_SIZE> verboseLog;
+
+        bool isHarmonic = true, multState = true, strangeMode = false, envInvert = true;
+        int8_t strangeKeyIndex = 0;
+
+    private:
+        void apply(const dsf_input_t &in);
+        void pressButton(uint8_t button, int16_t value);
+        void turnEncoder(int16_t steps);
+        void readEnvelopeControls();
+        void serviceTuning();
+        void renderSpan(uint16_t *out, size_t n);
+        void showStrangeKey();
+        static void midiApplied(const dsf_midi_event_t &e);
+
+        DsfHal &hal;
+        DsfTraceWriter *trace = nullptr;
+
+        /*!
+            @brief the latest pot readings, from `input_control`
+        */
+        uint16_t controlValue[ADC_CHANNELS] = {};
+
+        /*!
+            @brief per-core voice accumulators for `DUAL_CORE_RENDER`: core 0 renders the even voices into
+            `renderAcc[0]`, core 1 the odd ones into `renderAcc[1]`
+        */
+        int32_t renderAcc[2][SINK_BLOCK];
+
+        /*!
+            @brief MIDI Tuning Standard dumps: `midiParser` captures SysEx into `sysExBuf` on core 1,
+            `handOffTuning()` copies a complete message to `tuningDump` and publishes its length in `tuningDumpLen`,
+            and core 0 applies it between blocks (`serviceTuning()`) and sets the length back to 0
+        */
+        uint8_t sysExBuf[DSF_MTS_DUMP_SIZE], tuningDump[DSF_MTS_DUMP_SIZE];
+        std::atomic<size_t> tuningDumpLen{ 0 };
+
+        volatile uint64_t audioStartUs = 0; // when `start()` ran; sample 0 of `audioClock()`
+        uint32_t audioRate16 = (uint32_t)SAMPLE_RATE << 16; // the sink's real rate, Q16.16 Hz
+        uint32_t blockIndex = 0, blockPosition = 0, spanOffset = 0, nextPosition = 0;
+        uint32_t lastUnderruns = 0, lastMidiOverflows = 0;
+
+        static DsfExampleApp *rendering; // the app inside `synth.applyDue()`, for `midiApplied()`
+};
+
+static_assert(SINK_BLOCK <= DSF_SYNTH_BLOCK, "a sink block must fit in one prepared synth block");
@@ -0,0 +1,93 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Example Implementation: Settings
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * The example's settings and pin assignments, without any
+ * Pico SDK dependency, so the application loop
+ * (`dsf-example-app.h`) builds for the firmware and for the
+ * host replay alike.
+ ************************************************************/
+
+#pragma once
+
+/********************
+ * C++ HEADERS
+ ********************/
+#include <cstdint>
+
+/********************
+ * PROJECT DEFINES
+ ********************/
+#define VERBOSE true // print note status and debugging messages (deferred, see verboseLog)
+#define LOG_SIZE 32 // records per verboseLog channel (a power of two)
+
+#define I2C_OVERCLOCK false // run the MCP4725 at 1 MHz, beyond its 400 kHz rating, for 40 kHz audio (out of spec, see README)
+#if I2C_OVERCLOCK
+#define SAMPLE_RATE 40000 // audio sample rate in Hz
+#define I2C_SPEED 1000 // i2c bus speed in kHz; the DAC stream needs SAMPLE_RATE * 18 bits per second
+#else
+#define SAMPLE_RATE 20000 // audio sample rate in Hz; 360 kbit/s, 90% of a 400 kHz bus
+#define I2C_SPEED 400 // i2c bus speed in kHz (Fast-mode, the fastest the MCP4725 and the RP2040 share)
+#endif
+#define DAC_BIT_DEPTH 12
+#define VOICES 4 // polyphony; see dsf-bench for the cost per voice
+#define DUAL_CORE_RENDER true // core 1 renders every other voice between USB host tasks
+#define WAVE_CACHE true // play 2:1 and 1:2 voices from cached single cycles (see DsfWaveCache)
+#define WAVE_CACHE_SLOTS 24 // cached cycles, about 1 KB each
+#define ENV_TIME_MIN 100 //ms
+#define ENV_TIME_MAX 1000 //ms
+#define ENV_PERIOD_BITS 5 // envelope control rate: every 32 samples, interpolated in between
+#define ENV_SHAPE env_linear // or env_exponential
+#define BEND_RANGE 2 // pitch bend range in semitones
+#define GLIDE_MS 60 // legato portamento time, 0 = off
+#define MIDI_QUEUE_SIZE 64 // messages in flight from core 1 to core 0 (a power of two)
+#define MIDI_CHANNEL DSF_MIDI_OMNI // 0-15 to listen to one channel only
+#define MIDI_LATENCY (SINK_BLOCKS * SINK_BLOCK) // samples from a message's arrival to its sample; covers the render-ahead
+#define ADC_CHANNELS 4 // round-robin ADC0-ADC3; ADC3 is not a control but keeps frames a power of two
+#define ADC_RING_BITS 8 // DMA ring of 2^8 bytes = 128 conversions
+#define ADC_RATE 8000 // total conversions per second (2 kHz per channel)
+#define CTRL_DECIMATE 8 // conversions averaged per control value (250 Hz control rate)
+#define CTRL_SMOOTH 2 // one-pole smoothing shift applied to the averages
+#define DEADLINE_DUMP_KEY 'd' // type on the serial console to print the render deadline statistics
+#define DEADLINE_RESET_KEY 'r' // ... and this to clear them
+#define TRACE true // record the inputs into traceBuf from power-up, for dsf-replay on the host
+#define TRACE_SIZE 65536 // bytes of RAM for the trace
+#define TRACE_CHECK_BLOCKS 16 // a DAC checksum every 16 blocks (51 ms)
+#define TRACE_DUMP_KEY 't' // type on the serial console to print the trace as hex
+
+/********************
+ * AUDIO OUTPUT
+ ********************/
+#define SINK_BLOCK 64 // samples per block
+#define SINK_BLOCKS 4 // blocks in the ring; keep SINK_BLOCKS * SINK_BLOCK * 8 bytes a power of two
+
+/********************
+ * GPIO PINS
+ ********************/
+constexpr uint8_t   pinEnvAttack = 26,
+                    pinEnvDecay = 27,
+                    pinEnvSustain = 28,
+                    pinEnvInvert = 21,
+
+                    adc_in_EnvAttack = 0,
+                    adc_in_EnvDecay = 1,
+                    adc_in_EnvSustain = 2,
+
+                    pinSDA = 4,
+                    pinSCL = 5,
+
+                    pinEncSW = 15,
+                    pinEncCW = 18,
+                    pinEncCCW = 19,
+
+                    pinMult = 20,
+                    pinHarmonic = 22,
+
+                    pinStatusHarmonic = 2,
+                    pinStatusEnvInvert = 3,
+                    pinStatusMult = 6,
+                    pinBarGraphStart = 7,
+
+                    pinLED = 25; // PICO_DEFAULT_LED_PIN on the Pico
@@ -36,134 +36,184 @@ int main()
     printf(">>> both cores running\n");
 
     printf("\n\n\n\n\nDiscrete Summation Formula Oscillator v2.5 (2024-08-08)\n=======================================================\n\n");
-    if (VERBOSE) printf("Clock Speed %d MHz\nStarting timer at %dµs, %d Hz\n\n", clock_get_hz(clk_sys) / 1000000, SAMPLE_INTERVAL, SAMPLE_RATE);
+    if (VERBOSE) printf("Clock Speed %d MHz\nStarting output at %d Hz, %d-sample blocks\n\n", clock_get_hz(clk_sys) / 1000000, SAMPLE_RATE, SINK_BLOCK);
 
-    // negative SAMPLE_INTERVAL results in evenly-spaced timer calls
-    add_repeating_timer_us((-1 * SAMPLE_INTERVAL), &timerSample_cb, NULL, &timerSample); 
+    deadline.start((uint32_t)((uint64_t)dsf_systick_clock_t::hz() * SINK_BLOCK / SAMPLE_RATE));
+    sink.start();
+    app.start(TRACE ? &traceWriter : nullptr, sink.rate16());
 
-    while (true) tight_loop_contents();
+    while (true) {
+        app.loop();
+        serviceConsole();
+    }
 
 }
 
-bool timerSample_cb(repeating_timer_t *rt)
+/*!
+    @return the DAC sink
+*/
+DsfAudioSink &DsfPicoHal::dac()
 {
-    uint16_t dacValue;
-    fix15 param_A; 
-    if (thisNote.active) {
-
-        adc_select_input(adc_in_EnvSustain);
-        envSustain = (fix15)(uscale(adc_read(), 0, 4095, param_a_min15, param_a_max15));
-
-        switch (envMode)
-        {
-        case attack:
-            adc_select_input(adc_in_EnvAttack);
-            envAttack = uscale(adc_read(), 0, 4095, envRangeMin, envRangeMax);
-            if (envCounter % envAttack == 0) envelope += envStep;
-            envCounter++;
-            if (envelope >= param_a_max15) {
-                envMode = decay;
-                envCounter = 0;
-                if (VERBOSE) printf("\nAttack -> Decay\n\n");
-            } 
-            param_A = envInvert ? envelope : one15 - envelope;
-            break;
-        
-        case decay:
-            adc_select_input(adc_in_EnvDecay);
-            envDecay = uscale(adc_read(), 0, 4095, envRangeMin, envRangeMax);
-            if (envCounter % envDecay == 0) envelope -= envStep;
-            envCounter++;
-            if (envelope <= envSustain) {
-                envMode = sustain;
-                envCounter = 0;
-                if (VERBOSE) printf("\nDecay -> Sustain\n\n");
-            } 
-            param_A = envInvert ? envelope : one15 - envelope;
-            break;
-        
-        case sustain:
-            param_A = envInvert ? envSustain : one15 - envSustain;
-            break;
-        
-        default:
-            break;
-        }
+    return sink;
+}
+
+/*!
+    @brief filters the ADC conversions the DMA has written since the last pass
+*/
+void DsfPicoHal::poll()
+{
+    // the DMA channel stops after 2^32 transfers; re-arm it, the write address keeps wrapping in the ring
+    if (!dma_channel_is_busy(adcDma)) dma_channel_set_trans_count(adcDma, UINT32_MAX, true);
+    uint16_t writePos = (dma_hw->ch[adcDma].write_addr - (uintptr_t)adcRing) / sizeof(uint16_t);
+    controls.update(adcRing, writePos);
+}
 
-        dacValue = osc.getNextSample(param_A);
-        if (dacValue > 4095) return true;
-        dac.setInputCode(dacValue);
+/*!
+    @brief the pots whose filtered value has changed, then the button and encoder interrupts in the order they came
+*/
+bool DsfPicoHal::pollInput(dsf_input_t &in)
+{
+    for (uint8_t ch = 0; ch <= adc_in_EnvSustain; ch++) {
+        uint16_t v = controls.value(ch);
+        if (v == lastControl[ch]) continue;
+        lastControl[ch] = v;
+        in = {};
+        in.type = input_control;
+        in.id = ch;
+        in.value = (int16_t)v;
+        return true;
     }
 
+    if (irqTail == irqHead) return false;
+    in = irqRing[irqTail];
+    irqTail = (irqTail + 1) & (IRQ_INPUTS - 1);
     return true;
 }
 
-void inline showStrangeKey()
+/*!
+    @brief queues an interrupt for `pollInput()`; drops it if the main loop has fallen `IRQ_INPUTS` behind
+*/
+void DsfPicoHal::irqInput(uint8_t type, uint8_t id, int16_t value)
 {
-    uint32_t barGraphSetMask = 0;
-    uint32_t barGraphClearMask = (0xFF << pinBarGraphStart);
-    gpio_clr_mask(barGraphClearMask);
-    if (VERBOSE) {
-        printf("barGraphClearMask = %d, clearing pins ", barGraphClearMask);
-        for (int8_t b = 31; b >= 0; b--) printf("%d", ((barGraphClearMask >> b) & 1));
-        printf("\n");
-    }
-    for (uint pos = 0; pos <= strangeKeyIndex; pos++) barGraphSetMask |= (1 << (pinBarGraphStart + pos));
-    if (VERBOSE) {
-        printf("strangeKeyIndex = %d, barGraphSetMask = %d [", strangeKeyIndex, barGraphSetMask);
-        for (int8_t b = 31; b >= 0; b--) printf("%d", ((barGraphSetMask >> b) & 1));
-        printf("]\n");
+    uint8_t next = (irqHead + 1) & (IRQ_INPUTS - 1);
+    if (next == irqTail) return;
+    irqRing[irqHead] = {};
+    irqRing[irqHead].type = type;
+    irqRing[irqHead].id = id;
+    irqRing[irqHead].value = value;
+    irqHead = next;
+}
+
+/*!
+    @brief sends the span length to core 1 through the inter-core FIFO; core 1 picks it up between `tuh_task()` runs
+*/
+bool DsfPicoHal::core1Start(size_t n)
+{
+    __dmb(); // the FIFO is a device register: make the synth's writes visible to core 1 first
+    multicore_fifo_push_blocking(n);
+    return true;
+}
+
+/*!
+    @brief waits for core 1's reply
+*/
+void DsfPicoHal::core1Wait()
+{
+    multicore_fifo_pop_blocking();
+}
+
+void DsfPicoHal::stageStart()
+{
+    deadline.stageStart();
+}
+
+void DsfPicoHal::stageEnd(uint8_t stage)
+{
+    deadline.stageEnd(stage);
+}
+
+void DsfPicoHal::blockStart()
+{
+    deadline.blockStart();
+}
+
+void DsfPicoHal::blockEnd(int32_t slack)
+{
+    deadline.blockEnd(slack);
+}
+
+/*!
+    @brief core 1's half of a dual-core span: if core 0 has posted one, renders the odd voices and replies
+
+    Called between `tuh_task()` runs, so USB host servicing is delayed by at most one half block of rendering.
+*/
+static void renderCore1()
+{
+    if (!multicore_fifo_rvalid()) return;
+    uint32_t n = multicore_fifo_pop_blocking();
+    app.renderCore1Part(n);
+    __dmb();
+    multicore_fifo_push_blocking(n);
+}
+
+/*!
+    @brief reads the serial console without waiting: `DEADLINE_DUMP_KEY` prints the deadline statistics,
+    `DEADLINE_RESET_KEY` clears them, `TRACE_DUMP_KEY` prints the trace
+*/
+void serviceConsole()
+{
+    int c = getchar_timeout_us(0);
+    if (c == DEADLINE_DUMP_KEY) deadline.print(deadlineStageNames);
+    else if (c == DEADLINE_RESET_KEY) deadline.reset();
+    else if (TRACE && c == TRACE_DUMP_KEY) dumpTrace();
+}
+
+/*!
+    @brief prints the trace recorded so far as a `DSFTRACE <bytes>` line, lines of hex and an `END` line, which
+    `dsf-replay` reads from a saved console log
+
+    Blocks on the UART like the deadline printout, so the sink underruns while it prints; a trace that is still
+    recording shows the gap as a sample clock jump and replays fine.
+*/
+void dumpTrace()
+{
+    printf("\nDSFTRACE %u%s\n", (unsigned)traceWriter.size(), traceWriter.full() ? " full" : "");
+    const uint8_t *p = traceWriter.data();
+    for (size_t i = 0; i < traceWriter.size(); i++) {
+        printf("%02x", p[i]);
+        if ((i & 31) == 31 || i + 1 == traceWriter.size()) printf("\n");
     }
-    gpio_set_mask(barGraphSetMask);
+    printf("END\n");
 }
 
+/*!
+    @brief the button and encoder interrupts: reads the pin or the encoder and queues the event for the main loop,
+    which applies it before its next block
+*/
 void buttons_cb(uint gpio, uint32_t event_mask)
 {
-    if (VERBOSE) printf("GPIO interrupt %d = %d\n", gpio, gpio_get(gpio));
-    int8_t val;
-    button_state_t btn;
+    if (VERBOSE) app.verboseLog.log(log_irq, "GPIO interrupt %d = %d", gpio, gpio_get(gpio));
     switch (gpio)
     {
     case pinHarmonic:
-        isHarmonic = !isHarmonic;
-        gpio_put(pinStatusHarmonic, isHarmonic);
+        hal.irqInput(input_button, button_harmonic, 0);
         break;
         
     case pinEnvInvert:
-        envInvert = !envInvert;
-        gpio_put(pinStatusEnvInvert, envInvert);
+        hal.irqInput(input_button, button_env_invert, 0);
         break;
         
     case pinMult:
-        multState = !multState;
-        gpio_put(pinStatusMult, multState);
+        hal.irqInput(input_button, button_mult, 0);
         break;
 
     case pinEncCW:
     case pinEncCCW:
-        if (strangeMode) {
-            val = strangeControl.read();
-            if (VERBOSE) printf("Encoder turned, value %d\n", val);
-            if (val != 0) {
-                strangeKeyIndex += val;
-                if (strangeKeyIndex > 7) strangeKeyIndex = 0;
-                if (strangeKeyIndex < 0) strangeKeyIndex = 7;
-                if (VERBOSE) printf("New index %d\n", strangeKeyIndex);
-                showStrangeKey();
-            }
-        }
+        hal.irqInput(input_encoder, 0, strangeControl.read());
         break;
 
     case pinEncSW:
-        btn = strangeControl.buttonPress(event_mask);
-        if (btn == BTN_DOWN) strangeMode = !strangeMode;
-        if (strangeMode) {
-            showStrangeKey();
-            if (VERBOSE) printf("strangeMode engaged (%d)\n", strangeMode);
-        } else {
-            gpio_clr_mask(0xF << pinBarGraphStart);
-            if (VERBOSE) printf("strangeMode disengaged (%d)\n", strangeMode);
-        }
+        hal.irqInput(input_button, button_encoder, strangeControl.buttonPress(event_mask) == BTN_DOWN);
         break;
     
     default:
@@ -190,14 +240,7 @@ void setup()
     gpio_set_irq_enabled(pinEnvInvert, GPIO_IRQ_EDGE_FALL, true);
     gpio_set_irq_enabled(pinMult, GPIO_IRQ_EDGE_FALL, true);
 
-    gpio_put(pinStatusHarmonic, isHarmonic);
-    gpio_put(pinStatusEnvInvert, envInvert);
-    gpio_put(pinStatusMult, multState);
-
-    adc_init();
-    adc_gpio_init(pinEnvAttack);
-    adc_gpio_init(pinEnvDecay);
-    adc_gpio_init(pinEnvSustain);
+    startControls();
 
     bool dac_valid = dac.begin(MCP4725A0_Addr_A00, i2c0, I2C_SPEED, pinSDA, pinSCL);
     if (dac_valid) {
@@ -206,11 +249,42 @@ void setup()
         blinkLED(0);
     }
 
-    for (uint m = 0; m < 128; m++) midiFreq15[m] = float2fix15(midiFreq_Hz[m]);
+    app.setup();
     printf("\n\n\n\n\n\n\n\n\n\n");
     
 }
 
+/*!
+    @brief starts the free-running ADC in round-robin mode, streaming into `adcRing` by DMA
+
+    From here on nothing reads the ADC directly: `hal.poll()` filters the ring with `controls.update()` and hands the
+    changed values to the app as `input_control`.
+*/
+void startControls()
+{
+    adc_init();
+    adc_gpio_init(pinEnvAttack);
+    adc_gpio_init(pinEnvDecay);
+    adc_gpio_init(pinEnvSustain);
+
+    // ring entry i is channel i % ADC_CHANNELS: start the sequence at ADC0 together with the ring
+    adc_select_input(0);
+    adc_set_round_robin((1 << ADC_CHANNELS) - 1);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv((48000000 / ADC_RATE) - 1);
+
+    adcDma = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(adcDma);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_ring(&cfg, true, ADC_RING_BITS);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    dma_channel_configure(adcDma, &cfg, adcRing, &adc_hw->fifo, UINT32_MAX, true);
+
+    adc_run(true);
+}
+
 void blinkLED(uint8_t count)
 {
     if (count == 0) {
@@ -227,11 +301,6 @@ void blinkLED(uint8_t count)
     }    
 }
 
-uint32_t uscale(uint32_t x, uint32_t in_min, uint32_t in_max, uint32_t out_min, uint32_t out_max)
-{
-  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
-}
-
 /**************************************************
  * Code below adapted from usb_midi_host_pio_example.c 
  * included with the usb_midi_host library: 
@@ -263,19 +332,48 @@ void core1_main()
     }
     while (true) {
         tuh_task(); // tinyusb host task
+        if (DUAL_CORE_RENDER) renderCore1();
+        serviceLog();
+    }
+}
+
+/*!
+    @brief core 1's lowest-priority task: formats `verboseLog` records and feeds the text to the UART
+
+    Only writes while the UART's TX FIFO has room and never waits for it, so a long line is spread over many calls and
+    neither rendering nor USB host servicing is held up by the serial port.
+*/
+void serviceLog()
+{
+    static char line[DSF_LOG_LINE + 2];
+    static size_t pos = 0, len = 0;
+
+    while (true) {
+        if (pos == len) {
+            len = app.verboseLog.format(line, DSF_LOG_LINE + 1);
+            pos = 0;
+            if (len == 0) return;
+            line[len++] = '\r';
+            line[len++] = '\n';
+        }
+        if (!uart_is_writable(uart_default)) return;
+        uart_putc_raw(uart_default, line[pos++]);
     }
 }
 
 void tuh_midi_mount_cb(uint8_t dev_addr, uint8_t in_ep, uint8_t out_ep, uint8_t num_cables_rx, uint16_t num_cables_tx)
 {
-  printf("MIDI device address = %u, IN endpoint %u has %u cables, OUT endpoint %u has %u cables\r\n",
+  app.verboseLog.log(log_usb, "MIDI device address = %u, IN endpoint %u has %u cables, OUT endpoint %u has %u cables",
       dev_addr, in_ep & 0xf, num_cables_rx, out_ep & 0xf, num_cables_tx);
 
   if (midi_dev_addr == 0) {
     // then no MIDI device is currently connected
     midi_dev_addr = dev_addr;
+    app.midiParser.reset(); // don't carry running status over from the last device
   } else {
-    printf("A different USB MIDI Device is already connected.\r\nOnly one device at a time is supported in this program\r\nDevice is disabled\r\n");
+    app.verboseLog.log(log_usb, "A different USB MIDI Device is already connected.");
+    app.verboseLog.log(log_usb, "Only one device at a time is supported in this program");
+    app.verboseLog.log(log_usb, "Device is disabled");
   }
 }
 
@@ -284,9 +382,9 @@ void tuh_midi_umount_cb(uint8_t dev_addr, uint8_t instance)
 {
   if (dev_addr == midi_dev_addr) {
     midi_dev_addr = 0;
-    printf("MIDI device address = %d, instance = %d is unmounted\r\n", dev_addr, instance);
+    app.verboseLog.log(log_usb, "MIDI device address = %d, instance = %d is unmounted", dev_addr, instance);
   } else {
-    printf("Unused MIDI device address = %d, instance = %d is unmounted\r\n", dev_addr, instance);
+    app.verboseLog.log(log_usb, "Unused MIDI device address = %d, instance = %d is unmounted", dev_addr, instance);
   }
 }
 
@@ -295,47 +393,16 @@ void tuh_midi_rx_cb(uint8_t dev_addr, uint32_t num_packets)
     if (midi_dev_addr == dev_addr) {
         
         if (num_packets != 0) {
-            fix15 fNote, fMod, modFreq, modFactor, modBase, modHarm;
             uint8_t cable_num;
             uint8_t buffer[48];
+            // every message in this batch arrived now; core 0 plays it MIDI_LATENCY samples later
+            uint32_t due = app.audioClock() + MIDI_LATENCY;
             while (true) {
                 uint32_t bytes_read = tuh_midi_stream_read(dev_addr, &cable_num, buffer, sizeof(buffer));
                 if (bytes_read == 0) break;
-                thisNote.command = buffer[0] & 0xF0; // ignore MIDI channel
-                thisNote.note = buffer[1];
-                thisNote.velocity = buffer[2];
-            }
-
-            switch (thisNote.command)
-            {
-            case 0x90:
-                lastNote = thisNote;
-                thisNote.active = true;
-                if (strangeMode) {
-                    osc.freqs(midiFreq15[strangeModeRoots[strangeKeyIndex]], midiFreq15[thisNote.note], false);
-                    if (VERBOSE) printf("Note On: Strange Mode Carrier = %f, Modulator = %f (MIDI %d)\n", fix2float15(midiFreq15[strangeModeRoots[strangeKeyIndex]]), fix2float15(midiFreq15[thisNote.note]), thisNote.note);
-                } else {
-                    fMod = multfix15(midiFreq15[thisNote.note], multfix15(modFactor15[multState], (isHarmonic ? one15 : root2)));
-                    osc.freqs(midiFreq15[thisNote.note], fMod, false);
-                    if (VERBOSE) printf("Note On: %d (%f Hz)\n      >>> Carrier = %f, Modulator = %f\n", thisNote.note, midiFreq_Hz[thisNote.note], fix2float15(midiFreq15[thisNote.note]), fix2float15(fMod));
-                }
-                envMode = attack;
-                envelope = 0;
-                envCounter = 0;
-                gpio_put(PICO_DEFAULT_LED_PIN, true);
-                break;
-            
-            case 0x80:
-                if (thisNote.note == lastNote.note) {
-                    thisNote.active = false;
-                    gpio_put(PICO_DEFAULT_LED_PIN, false);
-                    if (VERBOSE) printf(">>>>>Note Off: %d\n", thisNote.note);
-                }
-                break;
-            
-            default:
-                break;
+                app.receiveMidi(buffer, bytes_read, due);
             }
+            app.handOffTuning();
         }
         
     }
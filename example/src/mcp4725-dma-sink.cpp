@@ -0,0 +1,158 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * MCP4725 DMA Audio Sink
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "mcp4725-dma-sink.h"
+#include "hardware/clocks.h"
+
+/*!
+    @brief the words the DMA plays between re-arms: as many whole rings as fit in the 32-bit transfer count
+*/
+static constexpr uint32_t armWords = (UINT32_MAX / SINK_RING_WORDS) * SINK_RING_WORDS;
+static constexpr uint32_t blockWords = SINK_BLOCK * SINK_WORDS_PER_SAMPLE;
+
+/*!
+    @brief MCP4725 fast-write `data_cmd` words for one DAC code (power-down bits 0, no STOP)
+*/
+static inline void packSample(uint32_t *words, uint16_t code)
+{
+    words[0] = (code >> 8) & 0x0F;
+    words[1] = code & 0xFF;
+}
+
+/*!
+    @brief the DMA timer fraction `num / den` (both at most 0xFFFF, `num <= den`) closest to `rate / clock`
+
+    Tries every denominator with its nearest numerator and keeps the one with the smallest `|num / den - rate / clock|`,
+    stopping early on an exact match. Runs once, in `start()`.
+
+    @param rate wanted timer rate in Hz
+    @param clock the system clock in Hz
+    @param bestNum set to the numerator
+    @param bestDen set to the denominator
+*/
+static void timerFraction(uint32_t rate, uint32_t clock, uint16_t &bestNum, uint16_t &bestDen)
+{
+    uint64_t bestErr = UINT64_MAX; // |num * clock - rate * den|, compared as a fraction of den
+    bestNum = 0;
+    bestDen = 1;
+    for (uint32_t den = 1; den <= 0xFFFF; den++) {
+        uint64_t target = (uint64_t)rate * den;
+        uint64_t num = (target + clock / 2) / clock;
+        if (num == 0 || num > den || num > 0xFFFF) continue;
+        uint64_t product = num * clock, err = (product > target) ? product - target : target - product;
+        if (bestErr == UINT64_MAX || err * bestDen < bestErr * den) {
+            bestErr = err;
+            bestNum = (uint16_t)num;
+            bestDen = (uint16_t)den;
+            if (err == 0) break;
+        }
+    }
+}
+
+/*!
+    @brief Constructor. Nothing touches the hardware until `start()`.
+
+    @param i2c the I2C instance the DAC is on, already initialised (e.g. by `MCP4725_PICO::begin()`)
+    @param address 7-bit I2C address of the DAC
+    @param sample_rate playback rate in Hz
+    @param dac_bit_depth the DAC bit depth, used for the mid-scale silence the ring starts with
+*/
+Mcp4725DmaSink::Mcp4725DmaSink(i2c_inst_t *i2c, uint8_t address, uint32_t sample_rate, uint8_t dac_bit_depth)
+{
+    bus = i2c;
+    addr = address;
+    fs = sample_rate;
+    silence = (1 << (dac_bit_depth - 1));
+}
+
+/*!
+    @brief fills the ring with silence and starts the paced DMA stream
+
+    Block 0 starts playing immediately; the renderer's first block goes into block 1.
+*/
+void Mcp4725DmaSink::start()
+{
+    for (uint32_t i = 0; i < SINK_RING_WORDS; i += SINK_WORDS_PER_SAMPLE) packSample(&ring[i], silence);
+    produced = 1;
+
+    // DMA timer at 2 * fs words per second: clk_sys * X / Y with 16-bit X and Y
+    uint32_t clock = clock_get_hz(clk_sys);
+    uint16_t num, den;
+    timerFraction(SINK_WORDS_PER_SAMPLE * fs, clock, num, den);
+    playRate16 = (uint32_t)(((uint64_t)clock * num << 16) / ((uint64_t)den * SINK_WORDS_PER_SAMPLE));
+    uint64_t wanted16 = (uint64_t)fs << 16, off16 = (playRate16 > wanted16) ? playRate16 - wanted16 : wanted16 - playRate16;
+    if (off16 * 1000000 > wanted16 * SINK_RATE_TOLERANCE_PPM) {
+        panic("DAC sink: %u Hz can't be paced from %u Hz (closest %u/%u plays %u Hz)", (unsigned)fs, (unsigned)clock,
+              num, den, (unsigned)(playRate16 >> 16));
+    }
+    if ((uint64_t)playRate16 * SINK_I2C_BITS_PER_SAMPLE * 100 > ((uint64_t)I2C_SPEED * 1000 * SINK_BUS_LOAD_PCT) << 16) {
+        panic("DAC sink: %u Hz needs more than %u%% of the %u kHz bus", (unsigned)(playRate16 >> 16), SINK_BUS_LOAD_PCT,
+              I2C_SPEED);
+    }
+
+    // target the DAC; the first word written to data_cmd opens the transaction
+    i2c_hw_t *hw = i2c_get_hw(bus);
+    hw->enable = 0;
+    hw->tar = addr;
+    hw->enable = 1;
+
+    dmaTimer = dma_claim_unused_timer(true);
+    dma_timer_set_fraction(dmaTimer, num, den);
+
+    dmaChannel = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(dmaChannel);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_ring(&cfg, false, __builtin_ctz(sizeof(ring)));
+    channel_config_set_dreq(&cfg, dma_get_timer_dreq(dmaTimer));
+    dma_channel_configure(dmaChannel, &cfg, &hw->data_cmd, ring, armWords, true);
+}
+
+/*!
+    @return index of the block the DMA is playing now, counted from `start()`
+
+    The RP2040 DMA has no endless mode, so the channel is re-armed here when its transfer count runs out (about every 15
+    hours at 40 kHz); the read address keeps wrapping in the ring, so playback continues from where it stopped.
+*/
+uint32_t Mcp4725DmaSink::played()
+{
+    if (!dma_channel_is_busy(dmaChannel)) {
+        armBase += armWords / blockWords;
+        dma_channel_set_trans_count(dmaChannel, armWords, true);
+    }
+    return armBase + (armWords - dma_hw->ch[dmaChannel].transfer_count) / blockWords;
+}
+
+/*!
+    @return the staging buffer if the next ring block is free, otherwise `nullptr` (the renderer is far enough ahead)
+*/
+uint16_t *Mcp4725DmaSink::acquire()
+{
+    uint32_t playing = played();
+    // underrun: the DMA is already in (or past) the block we were about to fill; count the stale blocks and skip ahead
+    if ((int32_t)(produced - playing) <= 0) {
+        underrunCount += playing + 1 - produced;
+        produced = playing + 1;
+    }
+    return (produced - playing < SINK_BLOCKS) ? staging : nullptr;
+}
+
+/*!
+    @brief packs the staging buffer into the ring block after the last committed one
+
+    If the DMA reached that block while it was being rendered, part of it has already played stale and it counts as an 
+    underrun; the next `acquire()` skips ahead.
+*/
+void Mcp4725DmaSink::commit()
+{
+    if ((int32_t)(produced - played()) <= 0) underrunCount++;
+    uint32_t *words = &ring[(produced % SINK_BLOCKS) * blockWords];
+    for (uint32_t i = 0; i < SINK_BLOCK; i++) packSample(&words[i * SINK_WORDS_PER_SAMPLE], staging[i]);
+    produced++;
+    blockCount++;
+}
@@ -0,0 +1,79 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * MCP4725 DMA Audio Sink
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Streams rendered blocks to an MCP4725 DAC without the CPU:
+ * one endless I2C "fast write" transaction fed by a DMA
+ * channel that a DMA pacing timer triggers twice per sample.
+ ************************************************************/
+
+#pragma once
+
+/********************
+ * PICO HEADERS
+ ********************/
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/i2c.h"
+
+/********************
+ * PROJECT HEADERS
+ ********************/
+#include "../../dsf-audio-sink.h"
+#include "dsf-example-config.h" // SINK_BLOCK, SINK_BLOCKS
+
+/********************
+ * SINK SETTINGS
+ ********************/
+#define SINK_WORDS_PER_SAMPLE 2 // MCP4725 fast write: [0 0 PD1 PD0 D11..D8] [D7..D0]
+#define SINK_RING_WORDS (SINK_BLOCKS * SINK_BLOCK * SINK_WORDS_PER_SAMPLE)
+#define SINK_I2C_BITS_PER_SAMPLE 18 // two bytes plus their ACK bits
+#define SINK_BUS_LOAD_PCT 90 // most of the nominal bus rate the stream may use; the real SCL rate comes out lower
+#define SINK_RATE_TOLERANCE_PPM 100 // furthest the paced rate may be from sample_rate
+
+/*!
+    @brief `DsfAudioSink` that plays a ring of blocks on an MCP4725 at the sample rate.
+
+    The ring holds I2C `data_cmd` words (two per sample). A DMA channel reads it in a loop (DMA ring wrap) and writes the
+    I2C TX FIFO, paced by a DMA timer at twice the sample rate. Since no word carries a STOP, the I2C master holds the bus
+    whenever the FIFO is empty and the transaction never ends, so the DAC sees a continuous fast-write stream. Nothing
+    stops the timer from overfilling the FIFO, so the stream may use at most `SINK_BUS_LOAD_PCT` of the bus, and the
+    timer fraction must play `sample_rate` to within `SINK_RATE_TOLERANCE_PPM`; `start()` panics otherwise. Rates that
+    divide the system clock evenly (20 kHz and 40 kHz at 125 or 150 MHz) are exact.
+
+    The block the DMA is currently playing is derived from its transfer count. `acquire()` hands out the staging buffer
+    only while the renderer is less than `SINK_BLOCKS - 1` blocks ahead; if the DMA reaches a block that has not been
+    committed it replays old audio, which `commit()` counts as underruns before catching up.
+*/
+class Mcp4725DmaSink : public DsfAudioSink {
+
+    public:
+        Mcp4725DmaSink(i2c_inst_t *i2c, uint8_t address, uint32_t sample_rate, uint8_t dac_bit_depth);
+        void start();
+        uint16_t *acquire() override;
+        void commit() override;
+        size_t blockSize() const override { return SINK_BLOCK; }
+
+        /*!
+            @return the sample, counted from `start()`, at which the block from the next `acquire()` will play
+        */
+        uint32_t position() const override { return produced * SINK_BLOCK; }
+
+        /*!
+            @return the rate the DMA timer actually plays, in Q16.16 Hz; valid after `start()`
+        */
+        uint32_t rate16() const { return playRate16; }
+
+    private:
+        uint32_t played();
+
+        uint32_t ring[SINK_RING_WORDS] __attribute__((aligned(SINK_RING_WORDS * sizeof(uint32_t))));
+        uint16_t staging[SINK_BLOCK];
+        i2c_inst_t *bus;
+        uint32_t fs, produced = 0, armBase = 0, playRate16 = 0;
+        int dmaChannel = -1, dmaTimer = -1;
+        uint16_t silence;
+        uint8_t addr;
+};
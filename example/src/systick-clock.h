@@ -0,0 +1,45 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * SysTick Deadline Clock
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Cycle counter for `DsfDeadlineMonitor` on the RP2040. The
+ * Cortex-M0+ has no DWT cycle counter, so the core's 24-bit
+ * SysTick timer is run free at the system clock instead.
+ ************************************************************/
+
+#pragma once
+
+/********************
+ * PICO HEADERS
+ ********************/
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+
+/********************
+ * PROJECT HEADERS
+ ********************/
+#include "../../dsf-deadline.h"
+
+/*!
+    @brief `DsfDeadlineMonitor` clock counting system clock cycles on the calling core
+
+    SysTick counts down from its reload value; `now()` inverts it so the monitor sees a counter that counts up. It wraps
+    every 2^24 cycles (126 ms at 133 MHz). Its interrupt stays disabled, and SysTick is per core, so start and read it
+    on the same core.
+*/
+struct dsf_systick_clock_t {
+    static constexpr uint32_t mask = 0x00FFFFFFu;
+
+    static void start()
+    {
+        systick_hw->csr = 0; // stop while reconfiguring
+        systick_hw->rvr = mask;
+        systick_hw->cvr = 0; // any write clears the counter
+        systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS; // processor clock, no interrupt
+    }
+    static inline uint32_t now() { return ~systick_hw->cvr; }
+    static uint32_t hz() { return clock_get_hz(clk_sys); }
+};
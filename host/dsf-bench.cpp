@@ -0,0 +1,2732 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Host Microbenchmark Suite
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Measures ns/sample and samples/sec for every registered
+ * kernel across a grid of carrier/modulator frequencies and
+ * `a` values. Single-oscillator kernels are also compared with
+ * a double-precision model of Moorer's formula (SNR, max
+ * error, THD+N). Results are printed as a table and can also
+ * be written as CSV so runs from different releases can be
+ * compared, or checked against a stored baseline.
+ *
+ * Usage: dsf-bench [--samples N] [--repeat N] [--filter NAME] [--csv FILE]
+ *                  [--baseline FILE] [--write-baseline FILE] [--slowdown PCT]
+ ************************************************************/
+
+/*
+ * C++ HEADERS
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-oscillator-pico.h"
+#include "dsf-voice-pool.h"
+#include "dsf-wave-cache.h"
+#include "dsf-simd.h"
+#include "dsf-sim-adc.h"
+#include "dsf-host-sinks.h"
+#include "dsf-envelope.h"
+#include "dsf-reference.h"
+#include "dsf-midi-queue.h"
+#include "dsf-midi-parser.h"
+#include "dsf-synth.h"
+#include "dsf-dual-render.h"
+#include "dsf-host-clock.h"
+#include "dsf-log.h"
+#include "dsf-tuning.h"
+#include "dsf-scala.h"
+#include "dsf-sim-hal.h"
+#include "dsf-example-app.h"
+#include "dsf-spectrum.h"
+#include "dsf-probe.h"
+#include "dsf-steal-pool.h"
+
+/*
+ * BENCHMARK SETTINGS
+ */
+#define BENCH_SAMPLE_RATE 40000
+#define BENCH_DAC_BITS 12
+#define BENCH_BLOCK 64
+#define BENCH_BUDGET_NS (1e9 / BENCH_SAMPLE_RATE) // time available per sample at the firmware sample rate
+#define BENCH_ACCURACY_SAMPLES (1 << 16) // samples compared with the reference at every grid point
+#define BENCH_TOLERANCE_DB 0.05 // SNR / THD+N change accepted against the baseline
+#define BENCH_TOLERANCE_LSB 0.5 // max error change accepted against the baseline
+#define BENCH_MIDI_QUEUE 64 // as MIDI_QUEUE_SIZE in the example
+#define BENCH_MIDI_MESSAGES (1 << 21) // messages per stress-test pass; the sequence number fills 21 data bits
+#define BENCH_SYNTH_VOICES 16
+#define BENCH_MIDI_FUZZ_MESSAGES 200000 // random messages in the parser round trip
+#define BENCH_MIDI_FUZZ_BYTES (1 << 20) // random bytes fed to the parser
+#define BENCH_ARITH_TOLERANCE 1 // DAC LSB a wide policy may differ from the table model by (rounding at the DAC)
+#define BENCH_LOG_SIZE 16 // records per log channel; small, so the stress test overflows it
+#define BENCH_LOG_RECORDS 100000 // records per producer in the log stress test
+#define BENCH_TUNING_CENTS 0.05 // pitch error accepted in the tuning tables, about twice dsf_exp2_table's
+#define BENCH_WAVE_SLOTS (2 * (DSF_WAVE_A_STEPS + 1)) // every slice of both ratios
+#define BENCH_WAVE_DB 6.0 // SNR a cached voice may lose against the same voice rendered directly
+#define BENCH_SINK_BLOCKS 4 // blocks the simulated sink lets the renderer run ahead, as SINK_BLOCKS in the example
+#define BENCH_SESSION_BLOCKS 480 // length of the scripted session the trace replay is checked with (1.5 s)
+#define BENCH_TRACE_SHORT 512 // bytes of the trace that fills up during the session
+#define BENCH_SURVEY_BURST 1024 // samples per probe burst, as dsf-survey's default
+#define BENCH_SURVEY_ALIAS_DB 0.01 // probe aliasing error accepted against the partials summed one by one
+#define BENCH_SURVEY_CENTROID 0.05 // probe centroid error accepted against the partial sum, relative (table noise)
+
+/*!
+    @brief one point of the benchmark grid
+
+    @param fn carrier frequency in Hz
+    @param fm modulator frequency in Hz
+    @param a the `a` term from Moorer's equation
+*/
+typedef struct {
+    float fn, fm, a;
+} bench_point_t;
+
+/*!
+    @brief result of one kernel run
+
+    @param ns wall-clock time spent rendering, in nanoseconds
+    @param checksum sum of all rendered samples, so runs can be compared and the work can't be optimised away
+*/
+typedef struct {
+    double ns;
+    uint64_t checksum;
+} bench_result_t;
+
+/*!
+    @brief a benchmarked kernel variant. `run` sets up its own state for `pt` and renders `samples` samples; only the
+    render loop is timed. `voices` is the number of voices mixed into each sample, used to report the cost per voice.
+    `verify`, if set, checks the kernel's output against the reference before it is timed; a kernel that fails is not
+    benchmarked and the run exits with an error. `capture`, if set, renders one oscillator at `pt` from a fresh state
+    into `out`, for the accuracy columns; `band` compares it with the finite sum instead of the infinite one.
+*/
+typedef struct {
+    const char *name;
+    bench_result_t (*run)(const bench_point_t &pt, size_t samples);
+    uint8_t voices;
+    bool (*verify)();
+    void (*capture)(const bench_point_t &pt, uint16_t *out, size_t n);
+    bool band;
+} bench_kernel_t;
+
+/*!
+    @brief one row of a baseline file: the accuracy and speed a kernel had at one grid point
+*/
+typedef struct {
+    dsf_accuracy_t acc;
+    double nsPerSample;
+} bench_baseline_t;
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsedNs(bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+}
+
+static uint64_t checksum(const uint16_t *buf, size_t n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += buf[i];
+    return sum;
+}
+
+/********************
+ * GRID
+ ********************/
+static constexpr float gridFn[] = { 55.0f, 440.0f, 3520.0f };
+static constexpr float gridRatio[] = { 0.5f, 1.4142135624f, 2.0f };
+static constexpr float gridA[] = { 0.1f, 0.5f, 0.9f, 0.95f }; // 0.95 is outside the clamp, to show what it costs
+
+/********************
+ * KERNELS
+ ********************/
+
+template <dsf_kernel_t K, bool BAND = false, class OSC = DsfOsc>
+static bench_result_t runGetNextSample(const bench_point_t &pt, size_t samples)
+{
+    OSC osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    osc.setKernel(K);
+    osc.setBandLimited(BAND);
+    osc.freqs(float2fix15(pt.fn), float2fix15(pt.fm));
+    fix15 a = float2fix15(pt.a);
+    uint16_t buf[BENCH_BLOCK];
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        for (size_t i = 0; i < BENCH_BLOCK; i++) buf[i] = osc.getNextSample(a);
+        r.checksum += checksum(buf, BENCH_BLOCK);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+template <dsf_kernel_t K, bool BAND = false, class OSC = DsfOsc>
+static bench_result_t runRenderBlock(const bench_point_t &pt, size_t samples)
+{
+    OSC osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    osc.setKernel(K);
+    osc.setBandLimited(BAND);
+    osc.freqs(float2fix15(pt.fn), float2fix15(pt.fm));
+    fix15 a = float2fix15(pt.a);
+    uint16_t buf[BENCH_BLOCK];
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        osc.renderBlock(buf, BENCH_BLOCK, a);
+        r.checksum += checksum(buf, BENCH_BLOCK);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+template <dsf_kernel_t K, bool BAND = false, class OSC = DsfOsc>
+static void captureGetNextSample(const bench_point_t &pt, uint16_t *out, size_t n)
+{
+    OSC osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    osc.setKernel(K);
+    osc.setBandLimited(BAND);
+    osc.freqs(float2fix15(pt.fn), float2fix15(pt.fm));
+    fix15 a = float2fix15(pt.a);
+    for (size_t i = 0; i < n; i++) out[i] = osc.getNextSample(a);
+}
+
+template <dsf_kernel_t K, bool BAND = false, class OSC = DsfOsc>
+static void captureRenderBlock(const bench_point_t &pt, uint16_t *out, size_t n)
+{
+    OSC osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    osc.setKernel(K);
+    osc.setBandLimited(BAND);
+    osc.freqs(float2fix15(pt.fn), float2fix15(pt.fm));
+    osc.renderBlock(out, n, float2fix15(pt.a));
+}
+
+/*!
+    @brief checks that `renderBlock()` with a constant `a` renders exactly what as many `getNextSample()` calls do, at
+    every grid point (0.95 included, so the clamp is covered) and across blocks of many lengths
+*/
+template <dsf_kernel_t K, bool BAND = false, class OSC = DsfOsc>
+static bool verifyRenderBlock()
+{
+    constexpr size_t n = 4096;
+    static uint16_t perSample[n], block[n];
+
+    for (float fn : gridFn) {
+        for (float ratio : gridRatio) {
+            for (float a : gridA) {
+                bench_point_t pt = { fn, fn * ratio, a };
+                captureGetNextSample<K, BAND, OSC>(pt, perSample, n);
+
+                OSC osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+                osc.setKernel(K);
+                osc.setBandLimited(BAND);
+                osc.freqs(float2fix15(pt.fn), float2fix15(pt.fm));
+                // 1, 3, 7, ... samples, so blocks of odd and even length start at every kind of offset
+                size_t done = 0;
+                for (size_t len = 1; done < n; len = 2 * len + 1) {
+                    size_t m = std::min(len, n - done);
+                    osc.renderBlock(block + done, m, float2fix15(pt.a));
+                    done += m;
+                }
+
+                for (size_t i = 0; i < n; i++) {
+                    if (block[i] != perSample[i]) {
+                        fprintf(stderr, "renderBlock: %u, getNextSample %u at sample %zu (fn %.0f, fm %.2f, a %.2f)\n",
+                                block[i], perSample[i], i, pt.fn, pt.fm, pt.a);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/*!
+    @brief checks the error bound of `recipdivfix15()`: within 1 LSB of `divfix15()` over the numerators and
+    denominators `DsfOsc` produces
+
+    Infinite sum: every `a` from `param_a_min15` to `param_a_max15` with every denominator it reaches (one per table
+    entry) and the largest numerators `±(1 - a^2)` times the table's peak, where the quotient's error is largest; every
+    256th `a` also with every table entry as the sine. The fix15 ramp squares `a` exactly, so it reaches no other values.
+    Band-limited: the numerator `1 - a^2 - 2 a^(N+1) (cos((N+1)β) - a cos(Nβ))` depends on β, so the loop of
+    `renderRamp()` is replayed for constant and ramped `a` (its `a^(N+1)` and `a^(N+2)` interpolated the same way) over
+    a range of N and modulator increments, times `±` the peak. The worst difference and how many quotients differ at all
+    are printed.
+*/
+static bool verifyReciprocal()
+{
+    const fix15 *table = DsfOsc::table_sine.v;
+    constexpr size_t size = DsfOsc::table_size;
+    fix15 peak = 0;
+    for (size_t i = 0; i < size; i++) peak = std::max(peak, (fix15)abs(table[i]));
+    uint64_t checked = 0, differ = 0;
+    fix15 worst = 0;
+    bool ok = true;
+
+    auto check = [&](fix15 num, fix15 den, fix15 a) {
+        for (fix15 signedNum : { num, -num }) {
+            fix15 d = abs(recipdivfix15(signedNum, den) - divfix15(signedNum, den));
+            checked++;
+            differ += (d != 0);
+            if (d > worst) worst = d;
+            if (d > 1 && ok) {
+                fprintf(stderr, "recip: %d / %d is %d LSB from divfix15 (a %.4f)\n", signedNum, den, d, fix2float15(a));
+                ok = false;
+            }
+        }
+    };
+
+    for (fix15 a = param_a_min15; a <= param_a_max15; a++) {
+        fix15 aSquared = multfix15(a, a), numScale = int2fix15(1) - aSquared;
+        for (size_t c = 0; c < size; c++) {
+            fix15 den = (int2fix15(1) + aSquared) - multfix15(a + a, table[c]);
+            check(multfix15(numScale, peak), den, a);
+            if (((a - param_a_min15) & 0xFF) != 0) continue;
+            for (size_t i = 0; i < size; i++) check(multfix15(numScale, table[i]), den, a);
+        }
+    }
+
+    const fix15 levels[] = { param_a_min15, float2fix15(0.3f), float2fix15(0.5f), float2fix15(0.7f), param_a_max15 };
+    const uint32_t scale = DsfOsc::phaseScale(BENCH_SAMPLE_RATE);
+    for (uint32_t bands : { 0u, 1u, 2u, 3u, 4u, 6u, 8u, 12u, 16u, 32u, 64u, (uint32_t)DSF_MAX_HARMONICS }) {
+        for (float fm : { 20.0f, 110.0f, 440.0f, 1000.0f, 3000.0f, 9000.0f }) {
+            const uint32_t stepMod = DsfOsc::phaseStep(float2fix15(fm), scale);
+            for (fix15 from : levels) {
+                for (fix15 to : levels) {
+                    // a ramps from -> to and back in blocks of BENCH_BLOCK, as in renderBlock-ramp
+                    uint32_t cMod = 0;
+                    for (int blk = 0; blk < 16; blk++) {
+                        fix15 a = (blk & 1) ? to : from, end = (blk & 1) ? from : to;
+                        fix15 step = (end - a) / (fix15)BENCH_BLOCK;
+                        dsf_square_ramp_t<dsf_arith_fix15> square(a, step);
+                        fix15 aN1 = DsfOsc::powA(a, bands + 1), aN2 = multfix15(aN1, a), aN1Step = 0, aN2Step = 0;
+                        if (step != 0) {
+                            fix15 aLast = a + step * (BENCH_BLOCK - 1), aN1Last = DsfOsc::powA(aLast, bands + 1);
+                            aN1Step = (aN1Last - aN1) / (BENCH_BLOCK - 1);
+                            aN2Step = (multfix15(aN1Last, aLast) - aN2) / (BENCH_BLOCK - 1);
+                        }
+                        for (size_t i = 0; i < BENCH_BLOCK; i++) {
+                            fix15 aSquared = square.value();
+                            fix15 num = int2fix15(1) - aSquared - DsfOsc::bandTail(cMod, bands, aN1, aN2);
+                            check(multfix15(num, peak), (int2fix15(1) + aSquared) - multfix15(a + a, DsfOsc::cosine(cMod)), a);
+                            aN1 += aN1Step;
+                            aN2 += aN2Step;
+                            cMod += stepMod;
+                            a += step;
+                            square.next();
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    printf("%-24s recip: %llu quotients, %llu differ from divfix15, worst %d LSB\n", "",
+           (unsigned long long)checked, (unsigned long long)differ, worst);
+    return ok;
+}
+
+template <dsf_kernel_t K, bool BAND = false, class OSC = DsfOsc>
+static bench_result_t runRenderBlockRamp(const bench_point_t &pt, size_t samples)
+{
+    OSC osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    osc.setKernel(K);
+    osc.setBandLimited(BAND);
+    osc.freqs(float2fix15(pt.fn), float2fix15(pt.fm));
+    // sweep a over +/-0.05 around the grid value so the ramp path is always taken
+    fix15 lo = float2fix15(pt.a - 0.05f), hi = float2fix15(pt.a + 0.05f);
+    uint16_t buf[BENCH_BLOCK];
+    bench_result_t r = { 0, 0 };
+    bool up = true;
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        osc.renderBlock(buf, BENCH_BLOCK, up ? lo : hi, up ? hi : lo);
+        up = !up;
+        r.checksum += checksum(buf, BENCH_BLOCK);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+template <dsf_kernel_t K>
+static bench_result_t runRenderBlockPitch(const bench_point_t &pt, size_t samples)
+{
+    DsfOsc osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    osc.setKernel(K);
+    osc.freqs(float2fix15(pt.fn), float2fix15(pt.fm));
+    fix15 a = float2fix15(pt.a);
+    // triangle vibrato of +/-1 semitone, a new pitch every sample (exponential FM path)
+    int32_t pitch16[BENCH_BLOCK];
+    for (size_t i = 0; i < BENCH_BLOCK; i++) {
+        int32_t tri = (i < BENCH_BLOCK / 2) ? (int32_t)i : (int32_t)(BENCH_BLOCK - i);
+        pitch16[i] = semisToOct16(2 * tri - BENCH_BLOCK / 2) / (BENCH_BLOCK / 2);
+    }
+    uint16_t buf[BENCH_BLOCK];
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        osc.renderBlock(buf, BENCH_BLOCK, a, pitch16);
+        r.checksum += checksum(buf, BENCH_BLOCK);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief the waveform cache of the `-cache` kernels, big enough for every slice; static, it is about 68 KB
+*/
+static DsfWaveCacheN<BENCH_WAVE_SLOTS> benchWaveCache;
+
+template <uint8_t N, dsf_kernel_t K, bool BAND = false, bool CACHE = false>
+static bench_result_t runVoicePool(const bench_point_t &pt, size_t samples)
+{
+    DsfVoicePool<N> pool(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    pool.setKernel(K);
+    pool.setBandLimited(BAND);
+    // spread the voices over a chord-like range above the grid carrier
+    for (uint8_t v = 0; v < N; v++) {
+        float detune = 1.0f + 0.0625f * v;
+        pool.noteOn(v, float2fix15(pt.fn * detune), float2fix15(pt.fm * detune));
+    }
+    pool.setA(float2fix15(pt.a));
+    if (CACHE) {
+        // warm: every voice needs the same two slices
+        benchWaveCache.clear();
+        pool.setWaveCache(&benchWaveCache);
+        for (int i = 0; i < 2; i++) pool.serviceCache();
+    }
+    uint16_t buf[BENCH_BLOCK];
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        pool.renderBlock(buf, BENCH_BLOCK);
+        r.checksum += checksum(buf, BENCH_BLOCK);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief the normalised voice `DsfVoicePool` renders at gain 1 and mix gain 1, in DAC codes, with exact phases
+*/
+static void poolReference(uint32_t stepNote, uint32_t stepMod, double a, uint8_t dacBits, double *out, size_t n)
+{
+    const double halfDac = ((1 << dacBits) - 1) / 2.0, turn = 2.0 * M_PI / 4294967296.0;
+    uint32_t cNote = 0, cMod = 0;
+    for (size_t i = 0; i < n; i++) {
+        double y = (1 - a) * (1 - a) * sin(cNote * turn) / (1 + a * a - 2 * a * cos(cMod * turn));
+        out[i] = halfDac + halfDac * y;
+        cNote += stepNote;
+        cMod += stepMod;
+    }
+}
+
+/*!
+    @brief checks the waveform cache: voices it can't play (inharmonic, band-limited, or before their slices are built)
+    render bit-identically to a pool without one; a voice at 2:1 or 1:2 played from it stays within `BENCH_WAVE_DB` of
+    the SNR the same voice has rendered directly, against the exact formula, for `a` on and between the slices; and a
+    cache too small for what the voices need keeps the slices in use instead of evicting them
+*/
+static bool verifyWaveCache()
+{
+    constexpr uint8_t dacBits = 15;
+    constexpr size_t n = 8192;
+    const uint32_t scale = DsfOsc::phaseScale(BENCH_SAMPLE_RATE);
+    std::vector<uint16_t> direct(n), cached(n);
+    std::vector<double> ref(n);
+
+    // fallback: identical output, and nothing built for voices that can't use it
+    const struct {
+        const char *name;
+        float ratio;
+        bool band;
+    } fallback[] = { { "inharmonic", 1.4142135624f, false }, { "band-limited", 2.0f, true }, { "cold", 2.0f, false } };
+    for (const auto &f : fallback) {
+        DsfVoicePool<4> plain(BENCH_SAMPLE_RATE, dacBits), pool(BENCH_SAMPLE_RATE, dacBits);
+        benchWaveCache.clear();
+        pool.setWaveCache(&benchWaveCache);
+        for (DsfVoicePool<4> *p : { &plain, &pool }) {
+            p->setBandLimited(f.band);
+            p->setA(float2fix15(0.6f));
+            for (uint8_t v = 0; v < 3; v++) p->noteOn(v, float2fix15(220.0f * (v + 1)), float2fix15(220.0f * (v + 1) * f.ratio));
+        }
+        for (size_t done = 0; done < n; done += BENCH_BLOCK) {
+            if (strcmp(f.name, "cold")) pool.serviceCache();
+            plain.renderBlock(direct.data() + done, BENCH_BLOCK);
+            pool.renderBlock(cached.data() + done, BENCH_BLOCK);
+        }
+        if (direct != cached || (strcmp(f.name, "cold") && benchWaveCache.builds() != 0)) {
+            fprintf(stderr, "wave cache (%s): output differs from direct rendering, %u cycles built\n", f.name,
+                    benchWaveCache.builds());
+            return false;
+        }
+    }
+
+    // accuracy: the cached voice against the exact formula, next to the same voice rendered directly
+    double worstLoss = -1e9, sumCached = 0, sumDirect = 0;
+    int points = 0;
+    for (float fn : { 110.0f, 440.0f, 1760.0f }) {
+        for (float ratio : { 2.0f, 0.5f }) {
+            for (float a : { 0.1f, 0.37f, 0.5f, 0.8123f, 0.9f }) {
+                DsfVoicePool<1> plain(BENCH_SAMPLE_RATE, dacBits), pool(BENCH_SAMPLE_RATE, dacBits);
+                benchWaveCache.clear();
+                pool.setWaveCache(&benchWaveCache);
+                for (DsfVoicePool<1> *p : { &plain, &pool }) {
+                    p->setMixGain(one15);
+                    p->setA(float2fix15(a));
+                    p->noteOn(60, float2fix15(fn), float2fix15(fn * ratio));
+                }
+                for (int i = 0; i < 2; i++) pool.serviceCache();
+                plain.renderBlock(direct.data(), n);
+                pool.renderBlock(cached.data(), n);
+                poolReference(DsfOsc::phaseStep(float2fix15(fn), scale), DsfOsc::phaseStep(float2fix15(fn * ratio), scale),
+                              fix2float15(float2fix15(a)), dacBits, ref.data(), n);
+                double snrDirect = dsfAccuracy(direct.data(), ref.data(), n).snr_db;
+                double snrCached = dsfAccuracy(cached.data(), ref.data(), n).snr_db;
+                worstLoss = std::max(worstLoss, snrDirect - snrCached);
+                sumCached += snrCached;
+                sumDirect += snrDirect;
+                points++;
+                if (snrDirect - snrCached > BENCH_WAVE_DB) {
+                    fprintf(stderr, "wave cache: fn %.0f ratio %.1f a %.4f: SNR %.1f dB cached, %.1f dB direct\n", fn,
+                            ratio, a, snrCached, snrDirect);
+                    return false;
+                }
+            }
+        }
+    }
+    printf("%-24s cached SNR %.1f dB mean vs %.1f dB direct, at worst %+.1f dB against direct\n", "wave cache",
+           sumCached / points, sumDirect / points, -worstLoss);
+
+    // a 3-slot cache and two voices needing four slices: the three built stay, nothing thrashes; once the second
+    // voice needs one slice, an unused one makes room for it
+    DsfWaveCacheN<3> small;
+    DsfVoicePool<2> pool(BENCH_SAMPLE_RATE, dacBits);
+    pool.setWaveCache(&small);
+    pool.noteOn(60, float2fix15(220.0f), float2fix15(440.0f));
+    pool.noteOn(62, float2fix15(330.0f), float2fix15(165.0f));
+    pool.setA(0, DsfWaveCache::levelA(4) + 100);
+    pool.setA(1, DsfWaveCache::levelA(9) + 100);
+    for (int i = 0; i < 20; i++) pool.serviceCache();
+    bool kept = small.cached() == 3 && small.builds() == 3;
+    pool.setA(1, param_a_max15); // on the top slice: needs only that one
+    for (int i = 0; i < 20; i++) pool.serviceCache();
+    kept = kept && small.builds() == 4 && small.slice(wave_double, 4) && small.slice(wave_double, 5) &&
+           small.slice(wave_half, DSF_WAVE_A_STEPS);
+    if (!kept) {
+        fprintf(stderr, "wave cache: LRU kept %u slices after %u builds\n", small.cached(), small.builds());
+        return false;
+    }
+    return true;
+}
+
+#define BENCH_SIMD_VOICES 16
+
+template <dsf_simd_isa_t ISA>
+static bench_result_t runSimd(const bench_point_t &pt, size_t samples)
+{
+    DsfSimdVoices bank(BENCH_SAMPLE_RATE, BENCH_DAC_BITS, BENCH_SIMD_VOICES);
+    bench_result_t r = { 0, 0 };
+    if (!bank.setIsa(ISA)) return r;
+    for (size_t v = 0; v < BENCH_SIMD_VOICES; v++) {
+        float detune = 1.0f + 0.0625f * v;
+        bank.freqs(v, float2fix15(pt.fn * detune), float2fix15(pt.fm * detune));
+        bank.setA(v, float2fix15(pt.a));
+    }
+    uint16_t buf[BENCH_BLOCK * BENCH_SIMD_VOICES];
+
+    // each frame renders every voice, so ns/sample divides by `voices` the same way as for the pool kernels
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        bank.render(buf, BENCH_BLOCK);
+        r.checksum += checksum(buf, BENCH_BLOCK * BENCH_SIMD_VOICES);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief checks that every voice of the SIMD bank is sample-exact with its own `DsfOsc`
+
+    Uses a voice count that is not a multiple of any lane width, frequencies and `a` values across the whole range
+    (including values outside the clamp) and changes `a` between blocks.
+*/
+template <dsf_simd_isa_t ISA>
+static bool verifySimd()
+{
+    constexpr size_t voices = 2 * BENCH_SIMD_VOICES + 3;
+    constexpr size_t frames = 4096;
+    DsfSimdVoices bank(BENCH_SAMPLE_RATE, BENCH_DAC_BITS, voices);
+    if (!bank.setIsa(ISA)) return true; // not supported on this CPU: nothing to check
+    std::vector<DsfOsc> ref(voices, DsfOsc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS));
+    std::vector<uint16_t> buf(frames * voices);
+    std::vector<fix15> a(voices);
+
+    for (size_t v = 0; v < voices; v++) {
+        fix15 fn = float2fix15(20.0f + 12000.0f * v / voices);
+        fix15 fm = float2fix15(13.0f + 9000.0f * ((v * 7) % voices) / voices);
+        bank.freqs(v, fn, fm);
+        ref[v].freqs(fn, fm);
+    }
+
+    for (int pass = 0; pass < 8; pass++) {
+        for (size_t v = 0; v < voices; v++) {
+            a[v] = (fix15)(((v * 2654435761u + pass * 40503u) >> 8) % one15);
+            bank.setA(v, a[v]);
+        }
+        bank.render(buf.data(), frames);
+        for (size_t i = 0; i < frames; i++) {
+            for (size_t v = 0; v < voices; v++) {
+                uint16_t expect = ref[v].getNextSample(a[v]);
+                if (buf[i * voices + v] != expect) {
+                    fprintf(stderr, "%s: voice %zu frame %zu pass %d: got %u, DsfOsc %u\n", DsfSimdVoices::isaName(ISA),
+                            v, i, pass, buf[i * voices + v], expect);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/*!
+    @brief the block pipeline: a 4-voice pool rendered through `DsfAudioSink::acquire()`/`commit()` into a null sink
+*/
+static bench_result_t runSinkNull(const bench_point_t &pt, size_t samples)
+{
+    DsfVoicePool<4> pool(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    for (uint8_t v = 0; v < 4; v++) {
+        float detune = 1.0f + 0.0625f * v;
+        pool.noteOn(v, float2fix15(pt.fn * detune), float2fix15(pt.fm * detune));
+    }
+    pool.setA(float2fix15(pt.a));
+    DsfNullSink sink(BENCH_BLOCK);
+    DsfAudioSink &out = sink;
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += out.blockSize()) {
+        uint16_t *block = out.acquire();
+        pool.renderBlock(block, out.blockSize());
+        out.commit();
+    }
+    r.ns = elapsedNs(start);
+    r.checksum = sink.checksum();
+    return r;
+}
+
+/*!
+    @brief writes a WAV file through `DsfFileSink` and reads it back: header fields, length and every sample must match
+    the committed DAC codes after centring and scaling to 16 bits
+*/
+static bool verifyFileSink()
+{
+    constexpr size_t blocks = 5;
+    std::string path = std::string(P_tmpdir) + "/dsf-bench-sink.wav";
+    DsfOsc osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    osc.freqs(float2fix15(440.0f), float2fix15(660.0f));
+    std::vector<uint16_t> codes;
+
+    {
+        DsfFileSink sink(path.c_str(), true, BENCH_SAMPLE_RATE, BENCH_DAC_BITS, BENCH_BLOCK);
+        for (size_t b = 0; b < blocks; b++) {
+            uint16_t *block = sink.acquire();
+            if (!block) break;
+            osc.renderBlock(block, BENCH_BLOCK, float2fix15(0.5f));
+            codes.insert(codes.end(), block, block + BENCH_BLOCK);
+            sink.commit();
+        }
+        sink.close();
+        if (!sink.ok() || sink.blocks() != blocks) {
+            fprintf(stderr, "file sink: could not write %s\n", path.c_str());
+            return false;
+        }
+    }
+
+    FILE *f = fopen(path.c_str(), "rb");
+    std::vector<uint8_t> data;
+    if (f) {
+        uint8_t buf[4096];
+        size_t got;
+        while ((got = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + got);
+        fclose(f);
+    }
+    remove(path.c_str());
+
+    auto get32 = [&](size_t at) { return (uint32_t)(data[at] | data[at + 1] << 8 | data[at + 2] << 16 | data[at + 3] << 24); };
+    size_t expectBytes = blocks * BENCH_BLOCK * 2;
+    if (data.size() != 44 + expectBytes || memcmp(data.data(), "RIFF", 4) || memcmp(&data[8], "WAVEfmt ", 8) ||
+        get32(4) != 36 + expectBytes || get32(24) != BENCH_SAMPLE_RATE || memcmp(&data[36], "data", 4) ||
+        get32(40) != expectBytes) {
+        fprintf(stderr, "file sink: bad WAV header or length (%zu bytes)\n", data.size());
+        return false;
+    }
+    for (size_t i = 0; i < codes.size(); i++) {
+        int16_t got = (int16_t)(data[44 + 2 * i] | data[45 + 2 * i] << 8);
+        int16_t expect = (int16_t)((codes[i] - (1 << (BENCH_DAC_BITS - 1))) * (1 << (16 - BENCH_DAC_BITS)));
+        if (got != expect) {
+            fprintf(stderr, "file sink: sample %zu is %d, expected %d\n", i, got, expect);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+    @brief per-sample cost of `DsfEnvelope::next()` cycling through a full ADSR; `a` sets the sustain level
+*/
+template <dsf_env_shape_t S>
+static bench_result_t runEnvelope(const bench_point_t &pt, size_t samples)
+{
+    DsfEnvelope env(BENCH_SAMPLE_RATE, 5);
+    env.setShape(S);
+    env.setAttack(5);
+    env.setDecay(20);
+    env.setRelease(20);
+    env.setSustain(float2fix15(pt.a));
+    bench_result_t r = { 0, 0 };
+    const size_t noteLength = BENCH_SAMPLE_RATE / 20;
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        // gate on for 50 ms, off for 50 ms
+        env.gate((done / noteLength) % 2 == 0);
+        for (size_t i = 0; i < BENCH_BLOCK; i++) r.checksum += env.next();
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief checks the ADSR stages and timing for both shapes: each segment must land within two control periods (plus 2%)
+    of its set time, the level must stay in range and move in the segment's direction, and release must end idle at 0;
+    then that a chord note released on `DsfSynth` while the others are held fades out and stops without touching them
+*/
+static bool verifyEnvelope()
+{
+    constexpr uint32_t attackMs = 100, decayMs = 200, releaseMs = 300;
+    constexpr fix15 sustain = int2fix15(1) / 4;
+
+    for (dsf_env_shape_t shape : { env_linear, env_exponential }) {
+        const char *name = (shape == env_linear) ? "linear" : "exponential";
+        DsfEnvelope env(BENCH_SAMPLE_RATE, 5);
+        env.setShape(shape);
+        env.setAttack(attackMs);
+        env.setDecay(decayMs);
+        env.setRelease(releaseMs);
+        env.setSustain(sustain);
+
+        auto expect = [&](uint32_t ms, fix15 from, fix15 to) {
+            // linear times are full scale; exponential ones are for the segment's own span plus the fixed overshoot
+            double span = fabs((double)(to - from)) / int2fix15(1);
+            if (shape == env_linear) return ms * span * BENCH_SAMPLE_RATE / 1000.0;
+            double overshoot = (double)DSF_ENV_OVERSHOOT / DSF_ENV_ONE;
+            return ms * BENCH_SAMPLE_RATE / 1000.0 * log((span + overshoot) / overshoot) / log(1.0 + 1.0 / overshoot);
+        };
+
+        auto run = [&](dsf_env_stage_t stage, fix15 from, fix15 to, uint32_t ms) {
+            size_t n = 0;
+            fix15 last = from;
+            while (env.stage() == stage && n < 10u * BENCH_SAMPLE_RATE) {
+                fix15 v = env.next();
+                // the stage changes at the control point; the first period still interpolates towards it
+                bool wrongWay = (n >= env.period()) && (to > from ? v < last : v > last);
+                if (v < 0 || v > int2fix15(1) || wrongWay) {
+                    fprintf(stderr, "envelope (%s): stage %d sample %zu level %d after %d\n", name, stage, n, v, last);
+                    return false;
+                }
+                last = v;
+                n++;
+            }
+            double want = expect(ms, from, to);
+            if (fabs(n - want) > 2.0 * env.period() + want * 0.02) {
+                fprintf(stderr, "envelope (%s): stage %d took %zu samples, expected %.0f\n", name, stage, n, want);
+                return false;
+            }
+            return true;
+        };
+
+        env.gate(true);
+        if (!run(env_attack, 0, int2fix15(1), attackMs)) return false;
+        if (!run(env_decay, int2fix15(1), sustain, decayMs)) return false;
+        for (int i = 0; i < 1000; i++) env.next();
+        env.gate(false);
+        if (!run(env_release, sustain, 0, releaseMs)) return false;
+        for (uint16_t i = 0; i < env.period(); i++) env.next();
+        if (env.active() || env.next() != 0) {
+            fprintf(stderr, "envelope (%s): not idle at 0 after release\n", name);
+            return false;
+        }
+    }
+
+    // C-E-G with E released: E must keep sounding through its fade and then stop, after which the synth must sound
+    // exactly like one that only ever played C and G; releasing C under G fades it the same way, and releasing G runs
+    // the shared release and ends both together
+    DsfSynth<3> chord(BENCH_SAMPLE_RATE, BENCH_DAC_BITS), ref(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    dsf_note_mode_t mode = { false, 0, true, false };
+    uint16_t bufChord[BENCH_BLOCK], bufRef[BENCH_BLOCK];
+    // the fade is stepped per pool pass and its rate rounds down, so it can take up to two passes longer
+    constexpr uint32_t fadeBlocks = (DSF_SYNTH_FADE + 2 * DSF_POOL_BLOCK + BENCH_BLOCK - 1) / BENCH_BLOCK;
+    bool ended = false;
+    for (DsfSynth<3> *s : { &chord, &ref }) {
+        s->env.setAttack(attackMs);
+        s->env.setDecay(decayMs);
+        s->env.setRelease(releaseMs);
+        s->env.setSustain(sustain);
+        s->noteOn(60, 100, mode);
+        if (s == &chord) s->noteOn(64, 100, mode);
+        s->noteOn(67, 100, mode);
+    }
+    for (uint32_t blk = 0; blk < 2u * BENCH_SAMPLE_RATE / BENCH_BLOCK; blk++) {
+        if (blk == 100) chord.noteOff(64);
+        if (blk == 200) {
+            for (DsfSynth<3> *s : { &chord, &ref }) {
+                s->noteOff(60);
+                s->noteOff(67);
+            }
+        }
+        chord.renderBlock(bufChord, BENCH_BLOCK);
+        ref.renderBlock(bufRef, BENCH_BLOCK);
+        bool endChord = chord.service(), endRef = ref.service();
+        ended = ended || endChord;
+        bool same = memcmp(bufChord, bufRef, sizeof(bufChord)) == 0;
+        if (blk <= 100 && same) {
+            fprintf(stderr, "envelope: E silent before its release (block %u)\n", blk);
+            return false;
+        }
+        if (blk < 100 + fadeBlocks) continue;
+        uint8_t want = (blk >= 200) ? ref.voices.activeVoices() : 2;
+        bool held = blk >= 200 || (chord.voices.isHeld(60) && chord.voices.isHeld(67));
+        if (!same || endChord != endRef || chord.voices.activeVoices() != want || !held) {
+            fprintf(stderr, "envelope: released E still sounding or C-G changed (block %u, %u voices)\n", blk,
+                    chord.voices.activeVoices());
+            return false;
+        }
+    }
+    if (!ended) {
+        fprintf(stderr, "envelope: chord still sounding after the release\n");
+        return false;
+    }
+    return true;
+}
+
+#define BENCH_CTRL_CHANNELS 4
+#define BENCH_CTRL_RING 128
+
+/*!
+    @brief control filter throughput: ns per ADC conversion consumed by `DsfControls::update()`
+
+    The simulated ring is filled once and the write position is then advanced by a block at a time, so only the
+    consumer is timed (on the device the producer is the DMA channel). The pots sit at `a` of full scale.
+*/
+static bench_result_t runControls(const bench_point_t &pt, size_t samples)
+{
+    DsfSimAdc<BENCH_CTRL_CHANNELS, BENCH_CTRL_RING> adc(24);
+    DsfControls<BENCH_CTRL_CHANNELS, BENCH_CTRL_RING> ctl(8, 2);
+    for (uint8_t c = 0; c < BENCH_CTRL_CHANNELS; c++) adc.set(c, (uint16_t)(pt.a * DSF_CTRL_MAX));
+    adc.produce(BENCH_CTRL_RING);
+    uint16_t writePos = 0;
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        writePos = (writePos + BENCH_BLOCK) % BENCH_CTRL_RING;
+        ctl.update(adc.ring, writePos);
+        for (uint8_t c = 0; c < BENCH_CTRL_CHANNELS; c++) r.checksum += ctl.value(c);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief checks `DsfControls` against a simulated noisy ADC: the first value lands on the pot position (no ramp from
+    zero), steady values stay within a few LSB of the pot despite +/-24 LSB of noise, and a pot move is tracked
+*/
+static bool verifyControls()
+{
+    constexpr int tolerance = 8;
+    DsfSimAdc<BENCH_CTRL_CHANNELS, BENCH_CTRL_RING> adc(24);
+    DsfControls<BENCH_CTRL_CHANNELS, BENCH_CTRL_RING> ctl(8, 2);
+    uint16_t level[BENCH_CTRL_CHANNELS] = { 40, 1000, 2048, 4050 }; // clear of the rails, where noise clips
+
+    auto check = [&](const char *stage) {
+        for (uint8_t c = 0; c < BENCH_CTRL_CHANNELS; c++) {
+            if (abs((int)ctl.value(c) - (int)level[c]) > tolerance) {
+                fprintf(stderr, "controls (%s): channel %u reads %u, pot at %u\n", stage, c, ctl.value(c), level[c]);
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (uint8_t c = 0; c < BENCH_CTRL_CHANNELS; c++) adc.set(c, level[c]);
+
+    // one decimated frame per channel, delivered in uneven chunks like a DMA position sampled at random times
+    adc.produce(5);
+    ctl.update(adc.ring, adc.position());
+    adc.produce(8 * BENCH_CTRL_CHANNELS - 5);
+    ctl.update(adc.ring, adc.position());
+    if (ctl.published() != BENCH_CTRL_CHANNELS || !check("first value")) return false;
+
+    for (int i = 0; i < 200; i++) {
+        adc.produce(37);
+        ctl.update(adc.ring, adc.position());
+        if (i > 20 && !check("steady")) return false;
+    }
+
+    for (uint8_t c = 0; c < BENCH_CTRL_CHANNELS; c++) {
+        level[c] = DSF_CTRL_MAX - level[c];
+        adc.set(c, level[c]);
+    }
+    for (int i = 0; i < 100; i++) {
+        adc.produce(37);
+        ctl.update(adc.ring, adc.position());
+    }
+    return check("after move");
+}
+
+/*!
+    @brief checks the band-limited paths against each other and against the infinite sum
+
+    Where `a^(N+1)` is below fix15 resolution the finite sum must equal the infinite one sample for sample; and
+    `renderBlock()` must match `getNextSample()` in band-limited mode, including after a pitch change that alters N.
+*/
+static bool verifyBandLimited()
+{
+    constexpr size_t n = 4096;
+    static uint16_t infinite[n], band[n], perSample[n];
+    fix15 a = float2fix15(0.5f);
+
+    DsfOsc ref(BENCH_SAMPLE_RATE, BENCH_DAC_BITS), osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    ref.freqs(float2fix15(110.0f), float2fix15(220.0f));
+    osc.setBandLimited(true);
+    osc.freqs(float2fix15(110.0f), float2fix15(220.0f));
+    ref.renderBlock(infinite, n, a);
+    osc.renderBlock(band, n, a);
+    if (memcmp(infinite, band, sizeof(band)) != 0) {
+        fprintf(stderr, "band-limited: output differs from the infinite sum where N = %u\n", DSF_MAX_HARMONICS);
+        return false;
+    }
+
+    // high note, few sidebands; then bend up an octave so N drops
+    DsfOsc blockOsc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS), sampleOsc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    for (DsfOsc *o : { &blockOsc, &sampleOsc }) {
+        o->setBandLimited(true);
+        o->freqs(float2fix15(2637.0f), float2fix15(2637.0f * 1.4142135624f));
+    }
+    blockOsc.renderBlock(band, n / 2, a);
+    blockOsc.pitch(DSF_OCTAVE16);
+    blockOsc.renderBlock(band + n / 2, n / 2, a);
+    for (size_t i = 0; i < n; i++) {
+        if (i == n / 2) sampleOsc.pitch(DSF_OCTAVE16);
+        perSample[i] = sampleOsc.getNextSample(a);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (band[i] != perSample[i]) {
+            fprintf(stderr, "band-limited: renderBlock %u, getNextSample %u at sample %zu\n", band[i], perSample[i], i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+    @brief checks the arithmetic of policy `P` in isolation: `DsfOscT<P>` must stay within `BENCH_ARITH_TOLERANCE` DAC LSB
+    of the same table-based formula evaluated in double precision (its own table entries, same phase counters, same `a`),
+    so the table's own error doesn't hide the arithmetic's; `renderBlock()` must also match `getNextSample()`, ramps
+    included. The worst error of fix15 on the same points is printed for comparison.
+*/
+template <class P>
+static bool verifyArith()
+{
+    constexpr size_t n = 8192;
+    static uint16_t perSample[n], block[n], fix[n];
+    const double halfDac = (double)((1 << BENCH_DAC_BITS) - 1) / 2.0;
+    const uint32_t scale = DsfOsc::phaseScale(BENCH_SAMPLE_RATE);
+    double worst = 0, worstFix = 0;
+
+    for (float fn : { 55.0f, 440.0f, 3520.0f }) {
+        for (float a : { 0.1f, 0.5f, 0.9f }) {
+            DsfOscT<P> osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS), blockOsc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+            DsfOsc fixOsc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+            fix15 a15 = float2fix15(a), fm15 = float2fix15(fn * 1.4142135624f);
+            osc.freqs(float2fix15(fn), fm15);
+            blockOsc.freqs(float2fix15(fn), fm15);
+            fixOsc.freqs(float2fix15(fn), fm15);
+            for (size_t i = 0; i < n; i++) {
+                perSample[i] = osc.getNextSample(a15);
+                fix[i] = fixOsc.getNextSample(a15);
+            }
+            blockOsc.renderBlock(block, n / 2, a15);
+            blockOsc.renderBlock(block + n / 2, n / 2, a15, a15); // the ramp path with a zero step must agree too
+            if (memcmp(perSample, block, sizeof(block)) != 0) {
+                fprintf(stderr, "arith %s: renderBlock differs from getNextSample at fn %.0f, a %.1f\n", P::name, fn, a);
+                return false;
+            }
+
+            const uint32_t stepNote = DsfOsc::phaseStep(float2fix15(fn), scale), stepMod = DsfOsc::phaseStep(fm15, scale);
+            const double ad = fix2float15((double)a15);
+            uint32_t cNote = 0, cMod = 0;
+            for (size_t i = 0; i < n; i++) {
+                // the DAC code wraps at 16 bits in every policy, so compare modulo 2^16
+                auto model = [&](double s, double c) {
+                    return (uint16_t)(int32_t)floor((1.0 - ad * ad) * s / (1.0 + ad * ad - 2.0 * ad * c) * halfDac + halfDac);
+                };
+                uint16_t ref = model(P::toDouble(DsfOscT<P>::sine(cNote)), P::toDouble(DsfOscT<P>::cosine(cMod)));
+                uint16_t refFix = model(fix2float15((double)DsfOsc::sine(cNote)), fix2float15((double)DsfOsc::cosine(cMod)));
+                worst = std::max(worst, (double)abs((int16_t)(perSample[i] - ref)));
+                worstFix = std::max(worstFix, (double)abs((int16_t)(fix[i] - refFix)));
+                cNote += stepNote;
+                cMod += stepMod;
+            }
+        }
+    }
+
+    printf("%-24s arith %s: worst error %.0f LSB (fix15: %.0f) against the table model\n", "", P::name, worst, worstFix);
+    if (worst > BENCH_ARITH_TOLERANCE) {
+        fprintf(stderr, "arith %s: %.0f LSB from the table model, more than %d\n", P::name, worst, BENCH_ARITH_TOLERANCE);
+        return false;
+    }
+    return true;
+}
+
+/*!
+    @brief checks `dsf_arith_q15` against fix15: both evaluate the same fixed-point formula, so every sample whose table
+    lookups read the same entries in both tables must be bit-identical, with a constant `a`, a ramp and the finite sum;
+    only samples that read the saturated +1.0 entry may differ (their count and worst difference are printed).
+    `renderBlock()` must also match `getNextSample()`.
+*/
+static bool verifyNarrow()
+{
+    typedef DsfOscT<dsf_arith_q15> Q15Osc;
+    constexpr size_t n = 8192;
+    static uint16_t narrow[n], block[n], fix[n];
+    const uint32_t scale = DsfOsc::phaseScale(BENCH_SAMPLE_RATE);
+    size_t identical = 0, saturated = 0;
+    int worst = 0;
+
+    for (int mode = 0; mode < 3; mode++) { // constant a, ramped a, finite sum
+        bool band = (mode == 2);
+        for (float fn : { 55.0f, 440.0f, 3520.0f }) {
+            for (float a : { 0.1f, 0.5f, 0.9f }) {
+                Q15Osc osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS), blockOsc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+                DsfOsc fixOsc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+                fix15 a15 = float2fix15(a), fm15 = float2fix15(fn * 1.4142135624f);
+                osc.setBandLimited(band);
+                blockOsc.setBandLimited(band);
+                fixOsc.setBandLimited(band);
+                osc.freqs(float2fix15(fn), fm15);
+                blockOsc.freqs(float2fix15(fn), fm15);
+                fixOsc.freqs(float2fix15(fn), fm15);
+                if (mode == 1) {
+                    // down from 0.9 to a across the first block, then constant
+                    blockOsc.renderBlock(block, BENCH_BLOCK, param_a_max15, a15);
+                    fixOsc.renderBlock(fix, BENCH_BLOCK, param_a_max15, a15);
+                    osc.renderBlock(narrow, BENCH_BLOCK, param_a_max15, a15);
+                    for (size_t i = BENCH_BLOCK; i < n; i++) {
+                        narrow[i] = osc.getNextSample(a15);
+                        fix[i] = fixOsc.getNextSample(a15);
+                    }
+                    blockOsc.renderBlock(block + BENCH_BLOCK, n - BENCH_BLOCK, a15);
+                } else {
+                    for (size_t i = 0; i < n; i++) {
+                        narrow[i] = osc.getNextSample(a15);
+                        fix[i] = fixOsc.getNextSample(a15);
+                    }
+                    blockOsc.renderBlock(block, n / 2, a15);
+                    blockOsc.renderBlock(block + n / 2, n / 2, a15, a15);
+                }
+                if (memcmp(narrow, block, sizeof(block)) != 0) {
+                    fprintf(stderr, "narrow q15: renderBlock differs from getNextSample at fn %.0f, a %.1f, mode %d\n", fn,
+                            a, mode);
+                    return false;
+                }
+
+                const uint32_t stepNote = DsfOsc::phaseStep(float2fix15(fn), scale), stepMod = DsfOsc::phaseStep(fm15, scale);
+                const uint32_t bands = Q15Osc::harmonics(stepNote, stepMod);
+                auto same = [](uint32_t phase) { return Q15Osc::sine(phase) == DsfOsc::sine(phase); };
+                uint32_t cNote = 0, cMod = 0;
+                for (size_t i = 0; i < n; i++) {
+                    bool exact = same(cNote) && same(cMod + DSF_QUARTER_PHASE);
+                    if (band) {
+                        uint32_t phaseN = cMod * bands;
+                        exact = exact && same(phaseN + cMod + DSF_QUARTER_PHASE) && same(phaseN + DSF_QUARTER_PHASE);
+                    }
+                    if (exact) {
+                        if (narrow[i] != fix[i]) {
+                            fprintf(stderr, "narrow q15: %u, fix15 %u at sample %zu (fn %.0f, a %.1f, mode %d)\n", narrow[i],
+                                    fix[i], i, fn, a, mode);
+                            return false;
+                        }
+                        identical++;
+                    } else {
+                        saturated++;
+                        worst = std::max(worst, abs((int16_t)(narrow[i] - fix[i])));
+                    }
+                    cNote += stepNote;
+                    cMod += stepMod;
+                }
+            }
+        }
+    }
+
+    printf("%-24s narrow q15: %zu samples identical to fix15, %zu read the saturated entry (worst %d LSB)\n", "",
+           identical, saturated, worst);
+    return true;
+}
+
+/*!
+    @brief the `seq`-th stress-test message: 21 bits of sequence number spread over all three bytes, so a message that
+    mixed bytes from two slots would decode to a number out of order
+*/
+static dsf_midi_event_t midiSeqEvent(uint32_t seq)
+{
+    return { (uint8_t)(0x80 | (seq & 0x7F)), (uint8_t)((seq >> 7) & 0x7F), (uint8_t)((seq >> 14) & 0x7F) };
+}
+
+static uint32_t midiSeqNumber(const dsf_midi_event_t &e)
+{
+    return (uint32_t)(e.status & 0x7F) | ((uint32_t)e.data1 << 7) | ((uint32_t)e.data2 << 14);
+}
+
+/*!
+    @brief stress-tests `DsfMidiQueue` with a producer and a consumer thread, like core 1 and core 0
+
+    First pass: the producer retries until every message is accepted, and the consumer must see all of them in order
+    and intact. Second pass: the producer never retries while the consumer is slowed down, and every message must be
+    either received (still in order) or counted in `overflows()`.
+*/
+static bool verifyMidiQueue()
+{
+    for (int pass = 0; pass < 2; pass++) {
+        bool lossy = (pass == 1);
+        DsfMidiQueue<BENCH_MIDI_QUEUE> queue;
+        uint32_t rejected = 0;
+
+        std::thread producer([&]() {
+            for (uint32_t seq = 0; seq < BENCH_MIDI_MESSAGES; seq++) {
+                while (!queue.push(midiSeqEvent(seq))) {
+                    rejected++;
+                    if (lossy) break;
+                    std::this_thread::yield(); // let the consumer run on a single-core host
+                }
+            }
+        });
+
+        uint32_t received = 0, expect = 0;
+        bool ordered = true, done = false;
+        while (!done) {
+            // the producer may finish between the pop and this check; one more drain then picks up the rest
+            done = (queue.pushed() + (lossy ? queue.overflows() : 0) == BENCH_MIDI_MESSAGES);
+            dsf_midi_event_t e;
+            if (!queue.pop(e)) {
+                std::this_thread::yield();
+                continue;
+            }
+            do {
+                uint32_t seq = midiSeqNumber(e);
+                if (lossy ? (seq < expect) : (seq != expect)) ordered = false;
+                expect = seq + 1;
+                received++;
+                if (lossy && (received & 0xFF) == 0) std::this_thread::yield();
+            } while (queue.pop(e));
+        }
+        producer.join();
+
+        if (!ordered) {
+            fprintf(stderr, "midi queue (pass %d): messages out of order or torn\n", pass);
+            return false;
+        }
+        if (queue.overflows() != rejected || received + (lossy ? rejected : 0) != BENCH_MIDI_MESSAGES) {
+            fprintf(stderr, "midi queue (pass %d): %u received, %u overflows, %u rejected pushes of %u messages\n", pass,
+                    received, queue.overflows(), rejected, BENCH_MIDI_MESSAGES);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+    @brief the firmware's block loop: one note message queued per block, drained into a 4-voice `DsfSynth` at the block
+    boundary, then the block rendered
+*/
+static bench_result_t runMidiQueue(const bench_point_t &pt, size_t samples)
+{
+    DsfSynth<4> synth(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    DsfMidiQueue<BENCH_MIDI_QUEUE> queue;
+    dsf_note_mode_t mode = { false, 0, true, pt.fm > pt.fn };
+    uint8_t note = (uint8_t)(69 + 12 * log2f(pt.fn / 440.0f));
+    uint16_t buf[BENCH_BLOCK];
+    uint32_t block = 0;
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK, block++) {
+        // a chord of four, released and struck again
+        uint8_t n = note + 4 * (block & 3);
+        queue.push({ (uint8_t)((block & 4) ? 0x80 : 0x90), n, 100 });
+        dsf_midi_event_t e;
+        while (queue.pop(e)) synth.midi(e, mode);
+        synth.renderBlock(buf, BENCH_BLOCK);
+        synth.service();
+        r.checksum += checksum(buf, BENCH_BLOCK);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief fixed-seed generator for the MIDI fuzz tests, same LCG as `DsfSimAdc`
+*/
+static uint32_t midiRandom(uint32_t &seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+/*!
+    @brief a random channel message, or with `garbage` random status and data bytes
+*/
+static dsf_midi_event_t midiRandomEvent(uint32_t &seed)
+{
+    dsf_midi_event_t e;
+    e.status = (uint8_t)(0x80 | (midiRandom(seed) % 0x70));
+    e.data1 = (uint8_t)(midiRandom(seed) & 0x7F);
+    e.data2 = (DsfMidiParser::dataBytes(e.status) > 1) ? (uint8_t)(midiRandom(seed) & 0x7F) : 0;
+    e.time = 0;
+    return e;
+}
+
+/*!
+    @brief serialises `events` the way a sender might: running status where allowed (mostly), real-time bytes anywhere,
+    and now and then a SysEx or system common message between two messages, after which the status must be sent again
+*/
+static std::vector<uint8_t> midiSerialise(const std::vector<dsf_midi_event_t> &events, uint32_t &seed)
+{
+    static const uint8_t common[][3] = { { 0xF1, 0x10, 0 }, { 0xF2, 0x01, 0x02 }, { 0xF3, 0x05, 0 }, { 0xF6, 0, 0 } };
+    std::vector<uint8_t> bytes;
+    uint8_t running = 0;
+
+    auto put = [&](uint8_t b) {
+        if (midiRandom(seed) % 8 == 0) bytes.push_back((uint8_t)(0xF8 + midiRandom(seed) % 8));
+        bytes.push_back(b);
+    };
+
+    for (const dsf_midi_event_t &e : events) {
+        uint32_t r = midiRandom(seed) % 32;
+        if (r == 0) {
+            put(0xF0);
+            for (uint32_t i = midiRandom(seed) % 10; i > 0; i--) put((uint8_t)(midiRandom(seed) & 0x7F));
+            put(0xF7);
+            running = 0;
+        } else if (r == 1) {
+            const uint8_t *m = common[midiRandom(seed) % 4];
+            put(m[0]);
+            for (uint8_t i = 0; i < ((m[0] == 0xF2) ? 2 : (m[0] == 0xF6) ? 0 : 1); i++) put(m[i + 1]);
+            running = 0;
+        }
+
+        if (e.status != running || midiRandom(seed) % 4 == 0) put(e.status);
+        running = e.status;
+        put(e.data1);
+        if (DsfMidiParser::dataBytes(e.status) > 1) put(e.data2);
+    }
+    return bytes;
+}
+
+/*!
+    @brief checks `DsfMidiParser` on hand-written streams, a round trip of random messages through `midiSerialise()` fed
+    in random-sized chunks, and a stream of random bytes, which must never produce a malformed message
+*/
+static bool verifyMidiParser()
+{
+    struct vector_t {
+        const char *name;
+        std::vector<uint8_t> bytes;
+        std::vector<dsf_midi_event_t> expect;
+        uint32_t errors;
+        uint8_t channel;
+    };
+    const std::vector<vector_t> vectors = {
+        { "running status", { 0x90, 60, 100, 62, 101 }, { { 0x90, 60, 100 }, { 0x90, 62, 101 } }, 0, DSF_MIDI_OMNI },
+        { "real-time inside", { 0x90, 0xF8, 60, 0xFE, 100 }, { { 0x90, 60, 100 } }, 0, DSF_MIDI_OMNI },
+        { "SysEx", { 0xF0, 1, 2, 3, 0xF7, 0x80, 60, 0 }, { { 0x80, 60, 0 } }, 0, DSF_MIDI_OMNI },
+        { "SysEx clears running status", { 0x90, 60, 1, 0xF0, 5, 0xF7, 61, 2 }, { { 0x90, 60, 1 } }, 2, DSF_MIDI_OMNI },
+        { "one data byte", { 0xC5, 3, 4, 0xD1, 99 }, { { 0xC5, 3, 0 }, { 0xC5, 4, 0 }, { 0xD1, 99, 0 } }, 0, DSF_MIDI_OMNI },
+        { "system common", { 0xF2, 1, 2, 0xF1, 3, 0xF6, 0xE0, 0, 64 }, { { 0xE0, 0, 64 } }, 0, DSF_MIDI_OMNI },
+        { "truncated", { 0x90, 60, 0x80, 61, 0 }, { { 0x80, 61, 0 } }, 1, DSF_MIDI_OMNI },
+        { "stray data", { 5, 6, 0xB0, 7, 100 }, { { 0xB0, 7, 100 } }, 2, DSF_MIDI_OMNI },
+        { "channel filter", { 0x92, 1, 1, 0x93, 1, 1, 0xB2, 64, 127 }, { { 0x92, 1, 1 }, { 0xB2, 64, 127 } }, 0, 2 },
+    };
+
+    for (const vector_t &v : vectors) {
+        DsfMidiParser parser;
+        parser.setChannel(v.channel);
+        std::vector<dsf_midi_event_t> got;
+        parser.parse(v.bytes.data(), v.bytes.size(), 7, [&](const dsf_midi_event_t &e) { got.push_back(e); });
+        bool same = (got.size() == v.expect.size()) && (parser.errors() == v.errors);
+        for (size_t i = 0; same && i < got.size(); i++) {
+            same = got[i].status == v.expect[i].status && got[i].data1 == v.expect[i].data1 &&
+                   got[i].data2 == v.expect[i].data2 && got[i].time == 7;
+        }
+        if (!same) {
+            fprintf(stderr, "midi parser (%s): %zu messages, %u errors; expected %zu and %u\n", v.name, got.size(),
+                    parser.errors(), v.expect.size(), v.errors);
+            return false;
+        }
+    }
+
+    uint32_t seed = 2024;
+    std::vector<dsf_midi_event_t> sent;
+    for (int i = 0; i < BENCH_MIDI_FUZZ_MESSAGES; i++) sent.push_back(midiRandomEvent(seed));
+    std::vector<uint8_t> stream = midiSerialise(sent, seed);
+
+    DsfMidiParser parser;
+    size_t received = 0;
+    bool intact = true;
+    for (size_t pos = 0; pos < stream.size();) {
+        size_t chunk = std::min<size_t>(1 + midiRandom(seed) % 48, stream.size() - pos);
+        parser.parse(stream.data() + pos, chunk, (uint32_t)pos, [&](const dsf_midi_event_t &e) {
+            const dsf_midi_event_t &s = sent[received++];
+            if (e.status != s.status || e.data1 != s.data1 || e.data2 != s.data2) intact = false;
+        });
+        pos += chunk;
+    }
+    if (!intact || received != sent.size() || parser.errors() != 0) {
+        fprintf(stderr, "midi parser: round trip got %zu of %zu messages, %s, %u errors\n", received, sent.size(),
+                intact ? "intact" : "altered", parser.errors());
+        return false;
+    }
+
+    DsfMidiParser garbage;
+    size_t bad = 0;
+    for (int i = 0; i < BENCH_MIDI_FUZZ_BYTES; i++) {
+        dsf_midi_event_t e;
+        if (!garbage.feed((uint8_t)midiRandom(seed), e)) continue;
+        bad += (e.status < 0x80 || e.status >= 0xF0 || e.data1 > 0x7F || e.data2 > 0x7F ||
+                (DsfMidiParser::dataBytes(e.status) == 1 && e.data2 != 0));
+    }
+    if (bad > 0) {
+        fprintf(stderr, "midi parser: %zu malformed messages from random bytes\n", bad);
+        return false;
+    }
+
+    // SysEx capture: kept whole around real-time bytes, later ones dropped until released, overflow and truncation
+    // dropped, and channel messages still decoded throughout
+    const uint8_t sx[] = { 0x90, 60, 1, 0xF0, 0x7E, 0xF8, 1, 2, 0xF7, 0xF0, 9, 0xF7, 0x80, 60, 0 };
+    uint8_t buf[8];
+    DsfMidiParser capture;
+    capture.captureSysEx(buf, sizeof(buf));
+    size_t notes = 0;
+    capture.parse(sx, sizeof(sx), 0, [&](const dsf_midi_event_t &) { notes++; });
+    bool kept = capture.sysEx() == 5 && buf[0] == 0xF0 && buf[1] == 0x7E && buf[2] == 1 && buf[3] == 2 && buf[4] == 0xF7;
+    capture.releaseSysEx();
+    const uint8_t tooLong[] = { 0xF0, 1, 2, 3, 4, 5, 6, 7, 8, 0xF7, 0xF0, 1, 0x90, 60, 1 };
+    capture.parse(tooLong, sizeof(tooLong), 0, [&](const dsf_midi_event_t &) { notes++; });
+    bool dropped = capture.sysEx() == 0;
+    if (!kept || !dropped || notes != 3) {
+        fprintf(stderr, "midi parser: SysEx capture %s, overflow %s, %zu of 3 notes\n", kept ? "ok" : "wrong",
+                dropped ? "dropped" : "kept", notes);
+        return false;
+    }
+    return true;
+}
+
+/*!
+    @brief decodes a serialised stream of random messages; one "sample" is one byte
+*/
+static bench_result_t runMidiParser(const bench_point_t &pt, size_t samples)
+{
+    static std::vector<uint8_t> stream;
+    if (stream.empty()) {
+        uint32_t seed = 99;
+        std::vector<dsf_midi_event_t> events;
+        for (int i = 0; i < 4096; i++) events.push_back(midiRandomEvent(seed));
+        stream = midiSerialise(events, seed);
+    }
+    (void)pt;
+    DsfMidiParser parser;
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += stream.size()) {
+        size_t n = std::min(stream.size(), samples - done);
+        parser.parse(stream.data(), n, 0, [&](const dsf_midi_event_t &e) { r.checksum += e.status + e.data1 + e.data2; });
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief renders `n` samples of `synth` in spans that end where the next message in `queue` is due, as the firmware's
+    `renderBlock()` does
+*/
+template <uint8_t N, uint16_t Q>
+static void renderTimed(DsfSynth<N> &synth, DsfMidiQueue<Q> &queue, uint16_t *out, size_t n, uint32_t clock,
+                        const dsf_note_mode_t &mode)
+{
+    size_t done = 0;
+    while (done < n) {
+        size_t len = synth.applyDue(queue, clock + done, n - done, mode);
+        synth.renderBlock(out + done, len);
+        done += len;
+    }
+}
+
+/*!
+    @brief checks that timestamped messages take effect exactly at their sample: blocks rendered with
+    `DsfSynth::applyDue()` must match a synth that is stopped at each message's sample by hand, across a sample clock
+    wrap and with a message that is already late
+*/
+static bool verifyMidiTiming()
+{
+    constexpr size_t blocks = 40, block = 64;
+    const uint32_t clock0 = 0xFFFFFC00u; // wraps after 16 blocks
+    struct timed_t {
+        uint32_t sample; // from clock0
+        dsf_midi_event_t e;
+    };
+    const timed_t events[] = {
+        { 5, { 0x90, 60, 100 } }, { 5, { 0x90, 64, 90 } }, { 70, { 0x90, 67, 80 } }, { 200, { 0xE0, 0, 80 } },
+        { 640, { 0x80, 64, 0 } }, { 1001, { 0x90, 72, 127 } }, { 1500, { 0xB0, 123, 0 } }, { 1800, { 0x90, 48, 64 } },
+    };
+    dsf_note_mode_t mode = { false, 0, true, true };
+    DsfSynth<4> timed(BENCH_SAMPLE_RATE, BENCH_DAC_BITS), manual(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    DsfMidiQueue<BENCH_MIDI_QUEUE> queue;
+    static uint16_t a[blocks * block], b[blocks * block];
+
+    // stamped well before rendering starts: late, so it must apply at sample 0
+    queue.push({ 0xB0, 121, 0, clock0 - 1000 });
+    for (const timed_t &t : events) {
+        dsf_midi_event_t e = t.e;
+        e.time = clock0 + t.sample;
+        queue.push(e);
+    }
+
+    size_t next = 0;
+    manual.controlChange(121, 0);
+    for (size_t blk = 0; blk < blocks; blk++) {
+        size_t start = blk * block;
+        timed.service();
+        renderTimed(timed, queue, a + start, block, clock0 + (uint32_t)start, mode);
+
+        manual.service();
+        size_t done = 0;
+        while (done < block) {
+            while (next < sizeof(events) / sizeof(events[0]) && events[next].sample == start + done) {
+                manual.midi(events[next++].e, mode);
+            }
+            size_t end = block;
+            if (next < sizeof(events) / sizeof(events[0]) && events[next].sample < start + block) {
+                end = events[next].sample - start;
+            }
+            manual.renderBlock(b + start + done, end - done);
+            done = end;
+        }
+    }
+
+    for (size_t i = 0; i < blocks * block; i++) {
+        if (a[i] != b[i]) {
+            fprintf(stderr, "midi timing: sample %zu is %u, expected %u\n", i, a[i], b[i]);
+            return false;
+        }
+    }
+    return queue.size() == 0;
+}
+
+/*!
+    @brief as `midi-queue-synth-4`, but each message is stamped at a sample inside the next block and the block is
+    rendered in spans around it
+*/
+static bench_result_t runMidiTimed(const bench_point_t &pt, size_t samples)
+{
+    DsfSynth<4> synth(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    DsfMidiQueue<BENCH_MIDI_QUEUE> queue;
+    dsf_note_mode_t mode = { false, 0, true, pt.fm > pt.fn };
+    uint8_t note = (uint8_t)(69 + 12 * log2f(pt.fn / 440.0f));
+    uint16_t buf[BENCH_BLOCK];
+    uint32_t block = 0;
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK, block++) {
+        uint8_t n = note + 4 * (block & 3);
+        queue.push({ (uint8_t)((block & 4) ? 0x80 : 0x90), n, 100, (uint32_t)(done + (block * 37) % BENCH_BLOCK) });
+        renderTimed(synth, queue, buf, BENCH_BLOCK, (uint32_t)done, mode);
+        synth.service();
+        r.checksum += checksum(buf, BENCH_BLOCK);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief plays a chord of `voices` notes around `pt.fn` on `synth`, gliding in Standard Mode
+*/
+template <uint8_t N>
+static void playChord(DsfSynth<N> &synth, const bench_point_t &pt, uint8_t voices)
+{
+    dsf_note_mode_t mode = { false, 0, true, pt.fm > pt.fn };
+    uint8_t root = (uint8_t)(69 + 12 * log2f(pt.fn / 440.0f));
+    synth.voices.setGlideTime(BENCH_SAMPLE_RATE / 50);
+    synth.env.setAttack(50);
+    for (uint8_t v = 0; v < voices; v++) synth.noteOn((uint8_t)(root + 3 * v - 12), 64 + v, mode);
+}
+
+/*!
+    @brief checks that `DsfDualRender` renders exactly what `DsfSynth::renderBlock()` does, through note changes, bend
+    and release, with block sizes that don't divide the pool pass
+*/
+static bool verifyDualRender()
+{
+    constexpr size_t blocks = 60;
+    static const size_t sizes[] = { 64, 100, 7, DSF_SYNTH_BLOCK };
+    DsfSynth<BENCH_SYNTH_VOICES> single(BENCH_SAMPLE_RATE, BENCH_DAC_BITS), dual(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    DsfDualRender<BENCH_SYNTH_VOICES> render(dual);
+    uint16_t a[DSF_SYNTH_BLOCK], b[DSF_SYNTH_BLOCK];
+    bench_point_t pt = { 220.0f, 440.0f, 0.5f };
+
+    for (DsfSynth<BENCH_SYNTH_VOICES> *s : { &single, &dual }) {
+        s->env.setRelease(20);
+        playChord(*s, pt, 5);
+    }
+
+    for (size_t blk = 0; blk < blocks; blk++) {
+        for (DsfSynth<BENCH_SYNTH_VOICES> *s : { &single, &dual }) {
+            if (blk == 10) s->pitchBend(4096);
+            if (blk == 20) s->noteOff(57);
+            if (blk == 30) s->controlChange(123, 0);
+            s->service();
+        }
+        size_t n = sizes[blk % 4];
+        single.renderBlock(a, n);
+        render.renderBlock(b, n);
+        for (size_t i = 0; i < n; i++) {
+            if (a[i] != b[i]) {
+                fprintf(stderr, "dual render: block %zu sample %zu is %u, single-threaded %u\n", blk, i, b[i], a[i]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*!
+    @brief a `BENCH_SYNTH_VOICES`-voice `DsfSynth` in firmware-sized blocks, on one thread or split over two
+*/
+template <bool DUAL, bool CACHE = false>
+static bench_result_t runSynth(const bench_point_t &pt, size_t samples)
+{
+    DsfSynth<BENCH_SYNTH_VOICES> synth(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    if (CACHE) {
+        benchWaveCache.clear();
+        synth.voices.setWaveCache(&benchWaveCache);
+    }
+    playChord(synth, pt, BENCH_SYNTH_VOICES);
+    DsfDualRender<BENCH_SYNTH_VOICES> *dual = DUAL ? new DsfDualRender<BENCH_SYNTH_VOICES>(synth) : nullptr;
+    uint16_t buf[BENCH_BLOCK];
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        if (CACHE) synth.service();
+        if (DUAL) dual->renderBlock(buf, BENCH_BLOCK);
+        else synth.renderBlock(buf, BENCH_BLOCK);
+        r.checksum += checksum(buf, BENCH_BLOCK);
+    }
+    r.ns = elapsedNs(start);
+    delete dual;
+    return r;
+}
+
+/*!
+    @brief 19-tone equal temperament with A4 at 440 Hz as a Scala scale, the tuning of `synth-16-scala`
+*/
+static const char *const benchScl = "! 19-EDO\n19-tone equal temperament\n19\n"
+                                    "63.15789\n126.31579\n189.47368\n252.63158\n315.78947\n378.94737\n442.10526\n"
+                                    "505.26316\n568.42105\n631.57895\n694.73684\n757.89474\n821.05263\n884.21053\n"
+                                    "947.36842\n1010.52632\n1073.68421\n1136.84211\n2/1\n";
+
+/*!
+    @return the pitch difference between two increments (or frequencies) in cents
+*/
+static double centsBetween(double a, double b)
+{
+    return 1200.0 * log2(a / b);
+}
+
+/*!
+    @brief checks `tuning` against the frequencies in Hz it was loaded from: every note's carrier and modulator
+    increments within `BENCH_TUNING_CENTS` of exact, and its pitch (for glide) within the same of `log2`
+
+    @param hz the frequency of every note; notes at 0 Hz are not checked
+    @param what the name of the tuning, for the error message
+*/
+static bool checkTuning(const DsfTuning &tuning, const double *hz, const char *what)
+{
+    static const double ratios[DSF_TUNING_RATIOS] = { 0.5, 2.0, sqrt(0.5), 2.0 * sqrt(2.0) };
+    double worst = 0;
+    int worstNote = 0;
+    for (uint8_t n = 0; n < 128; n++) {
+        if (hz[n] <= 0) continue;
+        double exact = hz[n] * 4294967296.0 / BENCH_SAMPLE_RATE;
+        for (uint8_t r = 0; r < DSF_TUNING_RATIOS; r++) {
+            dsf_note_mode_t mode = { false, 0, !(r & 2), (bool)(r & 1) };
+            uint32_t stepNote, stepMod;
+            tuning.steps(n, mode, stepNote, stepMod);
+            double err = std::max(fabs(centsBetween(stepNote, exact)), fabs(centsBetween(stepMod, exact * ratios[r])));
+            double pitch = 1200.0 * (tuning.pitch16(n) / 65536.0 - log2(hz[n] / (midiFreq16[0] / 65536.0)));
+            err = std::max(err, fabs(pitch));
+            if (err > worst) {
+                worst = err;
+                worstNote = n;
+            }
+        }
+    }
+    if (worst > BENCH_TUNING_CENTS) {
+        fprintf(stderr, "tuning (%s): note %d is %.4f cents out\n", what, worstNote, worst);
+        return false;
+    }
+    return true;
+}
+
+/*!
+    @brief checks the tuning path end to end: the compile-time equal-temperament tables against `pow()`, the default
+    `DsfTuning` against them and against the fix15 `noteFreqs()` path it replaced, a Scala scale through the blob and
+    through an MTS bulk dump (with unmapped keys left alone), and that malformed blobs and dumps are refused
+*/
+static bool verifyTuning()
+{
+    double hz[128];
+    for (int n = 0; n < 128; n++) {
+        hz[n] = 440.0 * pow(2.0, (n - 69) / 12.0);
+        if (fabs(midiFreq16[n] - hz[n] * 65536.0) > 0.5 || fabs(midiFreq15[n] - hz[n] * 32768.0) > 0.5) {
+            fprintf(stderr, "tuning: equal-tempered note %d is %u (Q16) / %d (fix15), exact %.3f Hz\n", n, midiFreq16[n],
+                    midiFreq15[n], hz[n]);
+            return false;
+        }
+    }
+
+    DsfTuning tuning(BENCH_SAMPLE_RATE);
+    if (!checkTuning(tuning, hz, "equal")) return false;
+    uint32_t scale = DsfOsc::phaseScale(BENCH_SAMPLE_RATE);
+    for (uint8_t n = 0; n < 128; n++) {
+        dsf_note_mode_t mode = { n >= 64, (uint8_t)(n & 7), (n & 1) != 0, (n & 2) != 0 };
+        fix15 fNote, fMod;
+        noteFreqs(n, mode, fNote, fMod);
+        uint32_t stepNote, stepMod;
+        tuning.steps(n, mode, stepNote, stepMod);
+        double err = std::max(fabs(centsBetween(stepNote, DsfOsc::phaseStep(fNote, scale))),
+                              fabs(centsBetween(stepMod, DsfOsc::phaseStep(fMod, scale))));
+        if (err > BENCH_TUNING_CENTS) {
+            fprintf(stderr, "tuning: note %d is %.4f cents from noteFreqs()\n", n, err);
+            return false;
+        }
+    }
+
+    DsfScala scala;
+    if (!scala.parseScl(benchScl) || !scala.parseKbm("12\n0\n127\n60\n69\n440\n19\n0\nx\n3\n5\n6\n8\nx\n"
+                                                 "11\n13\n14\n16\n17\n")) {
+        fprintf(stderr, "tuning: Scala: %s\n", scala.error().c_str());
+        return false;
+    }
+    uint32_t freq16[128];
+    scala.freqs16(freq16);
+    for (int n = 0; n < 128; n++) hz[n] = scala.freq((uint8_t)n);
+
+    uint8_t blob[DSF_TUNING_BLOB_SIZE];
+    DsfTuning fromBlob(BENCH_SAMPLE_RATE);
+    DsfTuning::writeBlob(freq16, blob);
+    if (!fromBlob.loadBlob(blob, sizeof(blob)) || !checkTuning(fromBlob, hz, "blob")) return false;
+    for (uint8_t n = 0; n < 128; n++) {
+        if (fromBlob.freq16(n) != freq16[n]) {
+            fprintf(stderr, "tuning: blob round trip changed note %d\n", n);
+            return false;
+        }
+    }
+
+    // unmapped keys are "no change" in the dump, so they keep equal temperament
+    uint8_t dump[DSF_MTS_DUMP_SIZE];
+    scala.mtsDump(3, scala.description().c_str(), dump);
+    DsfTuning fromMts(BENCH_SAMPLE_RATE);
+    if (!fromMts.loadMts(dump, sizeof(dump))) {
+        fprintf(stderr, "tuning: MTS dump refused\n");
+        return false;
+    }
+    for (int n = 0; n < 128; n++) {
+        if (hz[n] <= 0) hz[n] = 440.0 * pow(2.0, (n - 69) / 12.0);
+    }
+    if (!checkTuning(fromMts, hz, "MTS")) return false;
+
+    blob[0] ^= 1;
+    dump[100] ^= 1;
+    bool refused = !fromBlob.loadBlob(blob, sizeof(blob)) && !fromBlob.loadBlob(blob + 1, sizeof(blob) - 1) &&
+                   !fromMts.loadMts(dump, sizeof(dump)) && !fromMts.loadMts(dump, sizeof(dump) - 1);
+    if (!refused || fromBlob.freq16(60) != freq16[60]) {
+        fprintf(stderr, "tuning: a malformed blob or dump was accepted\n");
+        return false;
+    }
+    return true;
+}
+
+/*!
+    @brief `synth-16` playing in the `benchScl` tuning; the same cost as equal temperament, since note-ons read the
+    tuning's tables either way
+*/
+static bench_result_t runSynthScala(const bench_point_t &pt, size_t samples)
+{
+    DsfScala scala;
+    scala.parseScl(benchScl);
+    uint32_t freq16[128];
+    scala.freqs16(freq16);
+
+    DsfSynth<BENCH_SYNTH_VOICES> synth(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    synth.tuning.setFreqs(freq16);
+    playChord(synth, pt, BENCH_SYNTH_VOICES);
+    uint16_t buf[BENCH_BLOCK];
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        synth.renderBlock(buf, BENCH_BLOCK);
+        r.checksum += checksum(buf, BENCH_BLOCK);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief rebuilds the tuning tables from a frequency table over and over; one "sample" is one note of a load, so
+    128 times the figure is what loading a tuning costs
+*/
+static bench_result_t runTuningLoad(const bench_point_t &pt, size_t samples)
+{
+    uint32_t freq16[128];
+    for (int n = 0; n < 128; n++) freq16[n] = (uint32_t)(midiFreq16[n] * (pt.fm / pt.fn));
+    DsfTuning tuning(BENCH_SAMPLE_RATE);
+    bench_result_t r = { 0, 0 };
+
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += 128) {
+        freq16[done & 0x7F]++;
+        tuning.setFreqs(freq16);
+        r.checksum += tuning.pitch16(60);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief checks the deferred log with one producer thread per channel against a consumer formatting every record:
+    per channel the sequence numbers must arrive in order, and the records received plus the drops reported in the
+    output must add up to every `log()` call. Also checks that a line longer than the buffer is cut and terminated.
+*/
+static bool verifyLog()
+{
+    constexpr uint8_t channels = 3;
+    DsfLog<channels, BENCH_LOG_SIZE> log;
+    std::atomic<uint8_t> running{ channels };
+    std::vector<std::thread> producers;
+    uint32_t rejected[channels] = {};
+
+    for (uint8_t ch = 0; ch < channels; ch++) {
+        producers.emplace_back([&, ch]() {
+            for (uint32_t seq = 0; seq < BENCH_LOG_RECORDS; seq++) {
+                if (!log.log(ch, "channel %d record %d of %d", ch, (int32_t)seq, BENCH_LOG_RECORDS)) rejected[ch]++;
+                if ((seq & 0x3F) == 0) std::this_thread::yield(); // let the others run on a single-core host
+            }
+            running.fetch_sub(1);
+        });
+    }
+
+    uint32_t received[channels] = {}, reported[channels] = {}, expect[channels] = {};
+    bool ordered = true, parsed = true, done = false;
+    char line[DSF_LOG_LINE];
+    while (!done) {
+        // the producers may finish between the last format() and this check; one more drain picks up the rest
+        done = (running.load() == 0);
+        size_t len;
+        while ((len = log.format(line, sizeof(line))) > 0) {
+            unsigned ch, seq, total, drops;
+            if (sscanf(line, "channel %u record %u of %u", &ch, &seq, &total) == 3 && ch < channels &&
+                total == BENCH_LOG_RECORDS) {
+                if (seq < expect[ch]) ordered = false;
+                expect[ch] = seq + 1;
+                received[ch]++;
+            } else if (sscanf(line, "log: %u records dropped on channel %u", &drops, &ch) == 2 && ch < channels) {
+                reported[ch] += drops;
+            } else {
+                parsed = false;
+            }
+            if (strlen(line) != len) parsed = false;
+        }
+        std::this_thread::yield();
+    }
+    for (std::thread &t : producers) t.join();
+
+    bool ok = ordered && parsed;
+    if (!ordered) fprintf(stderr, "log: records out of order or torn\n");
+    if (!parsed) fprintf(stderr, "log: a line didn't match its format\n");
+    for (uint8_t ch = 0; ch < channels; ch++) {
+        if (received[ch] + reported[ch] != BENCH_LOG_RECORDS || reported[ch] != rejected[ch] ||
+            log.dropped(ch) != rejected[ch] || log.logged(ch) != received[ch]) {
+            fprintf(stderr, "log: channel %u received %u and reported %u drops of %u; log() rejected %u\n", ch,
+                    received[ch], reported[ch], BENCH_LOG_RECORDS, rejected[ch]);
+            ok = false;
+        }
+    }
+
+    char small[16];
+    log.log(0, "%d is more than fifteen characters", 12345);
+    size_t len = log.format(small, sizeof(small));
+    if (len != sizeof(small) - 1 || strcmp(small, "12345 is more t") != 0) {
+        fprintf(stderr, "log: long line gave \"%s\" (%zu characters)\n", small, len);
+        ok = false;
+    }
+    return ok;
+}
+
+/*!
+    @brief what an interrupt pays to log: `log()` with all six arguments, timed in batches of one ring's worth; the
+    batches are formatted, untimed, in between
+*/
+static bench_result_t runLog(const bench_point_t &pt, size_t samples)
+{
+    DsfLog<1, BENCH_LOG_SIZE> log;
+    char line[DSF_LOG_LINE];
+    int32_t a = float2fix15(pt.a);
+    bench_result_t r = { 0, 0 };
+
+    for (size_t done = 0; done < samples; done += BENCH_LOG_SIZE) {
+        auto start = bench_clock::now();
+        for (int32_t i = 0; i < BENCH_LOG_SIZE; i++) {
+            log.log(0, "Note On: %d, a = %d, %d %d %d %d", i, a, (int32_t)pt.fn, (int32_t)pt.fm, (int32_t)done, i);
+        }
+        r.ns += elapsedNs(start);
+        while (size_t len = log.format(line, sizeof(line))) r.checksum += len;
+    }
+    return r;
+}
+
+/********************
+ * DEADLINE MONITOR
+ ********************/
+
+/*!
+    @brief the stages `renderDeadline()` times, as in the firmware's render loop
+*/
+enum bench_stage_t : uint8_t
+{
+    bench_stage_envelope,
+    bench_stage_kernel,
+    bench_stage_sink,
+    bench_stages
+};
+static const char *const benchStageNames[bench_stages] = { "envelope", "kernel", "sink" };
+
+typedef DsfDeadlineMonitor<dsf_chrono_clock_t, bench_stages> bench_deadline_t;
+
+/*!
+    @brief a clock the test sets by hand; 24 bits wide like SysTick, so differences across its wrap are checked too
+*/
+struct bench_step_clock_t {
+    static constexpr uint32_t mask = 0x00FFFFFFu;
+    static inline uint32_t t = 0;
+
+    static void start() {}
+    static uint32_t now() { return t; }
+    static uint32_t hz() { return 1000000u; }
+};
+
+/*!
+    @brief checks the monitor's bookkeeping against block and stage times set on a hand-driven clock: histogram bins,
+    worst case, overruns against the budget, late blocks, minimum slack and the per-stage totals, across a clock wrap
+*/
+static bool verifyDeadline()
+{
+    DsfDeadlineMonitor<bench_step_clock_t, 2> deadline;
+    const uint32_t budget = 1000; // 16 bins of 125 ticks from 0 to 2000
+    struct block_t {
+        uint32_t first, second; // ticks in stage 0 and stage 1
+        int32_t slack;
+        uint8_t bin;
+    };
+    const block_t blocks[] = {
+        { 40, 60, 300, 0 }, { 200, 300, 200, 4 }, { 999, 0, 100, 7 }, { 500, 500, 0, 8 },
+        { 1, 1000, -1, 8 }, { 900, 1000, -64, 15 }, { 4000, 1000, 64, 15 },
+    };
+    bool ok = true;
+
+    deadline.start(budget);
+    bench_step_clock_t::t = 0x00FFFE00u; // wraps during the second block
+    uint64_t stage0 = 0, stage1 = 0;
+    uint32_t bins[16] = {};
+    for (const block_t &b : blocks) {
+        deadline.blockStart();
+        bench_step_clock_t::t += b.first;
+        deadline.stageEnd(0);
+        bench_step_clock_t::t += b.second;
+        deadline.stageEnd(1);
+        deadline.blockEnd(b.slack);
+        stage0 += b.first;
+        stage1 += b.second;
+        bins[b.bin]++;
+        bench_step_clock_t::t += 77; // idle between blocks, not charged to anything
+    }
+    // a stage outside any block
+    deadline.stageStart();
+    bench_step_clock_t::t += 5;
+    deadline.stageEnd(0);
+
+    for (uint8_t i = 0; i < 16; i++) {
+        if (deadline.bin(i) != bins[i]) {
+            fprintf(stderr, "deadline: bin %u holds %u blocks, expected %u\n", i, deadline.bin(i), bins[i]);
+            ok = false;
+        }
+    }
+    if (deadline.blocks() != 7 || deadline.overruns() != 3 || deadline.late() != 2 || deadline.worst() != 5000 ||
+        deadline.minSlack() != -64) {
+        fprintf(stderr, "deadline: %u blocks, %u overruns, %u late, worst %u, min slack %d; expected 7, 3, 2, 5000, -64\n",
+                deadline.blocks(), deadline.overruns(), deadline.late(), deadline.worst(), (int)deadline.minSlack());
+        ok = false;
+    }
+    if (deadline.calls(0) != 8 || deadline.stageTicks(0) != stage0 + 5 || deadline.stageMax(0) != 4000 ||
+        deadline.calls(1) != 7 || deadline.stageTicks(1) != stage1 || deadline.stageMax(1) != 1000) {
+        fprintf(stderr, "deadline: stage totals don't add up\n");
+        ok = false;
+    }
+
+    deadline.reset();
+    if (deadline.blocks() || deadline.bin(0) || deadline.calls(0) || deadline.budgetTicks() != budget) {
+        fprintf(stderr, "deadline: reset() left statistics behind\n");
+        ok = false;
+    }
+    return ok;
+}
+
+/*!
+    @brief the `synth-16` render loop with every block timed by `deadline` the way the firmware times it: envelope and
+    voices as separate stages, the block handed to a null sink, and the slack against a sink that started playing in
+    real time with the first block and lets the renderer run `BENCH_SINK_BLOCKS` ahead
+*/
+static bench_result_t renderDeadline(const bench_point_t &pt, size_t samples, bench_deadline_t &deadline)
+{
+    DsfSynth<BENCH_SYNTH_VOICES> synth(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    playChord(synth, pt, BENCH_SYNTH_VOICES);
+    DsfNullSink sink(BENCH_BLOCK);
+    int32_t acc[BENCH_BLOCK];
+    bench_result_t r = { 0, 0 };
+
+    deadline.start((uint32_t)((uint64_t)dsf_chrono_clock_t::hz() * BENCH_BLOCK / BENCH_SAMPLE_RATE));
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_BLOCK) {
+        uint16_t *block = sink.acquire();
+        deadline.blockStart();
+        synth.prepareBlock(BENCH_BLOCK);
+        deadline.stageEnd(bench_stage_envelope);
+        synth.renderPart(acc, BENCH_BLOCK, 0, 1);
+        synth.finishBlock(block, BENCH_BLOCK, acc);
+        deadline.stageEnd(bench_stage_kernel);
+        sink.commit();
+        deadline.stageEnd(bench_stage_sink);
+        int64_t played = (int64_t)(elapsedNs(start) * BENCH_SAMPLE_RATE / 1e9);
+        deadline.blockEnd((int32_t)((int64_t)done + BENCH_SINK_BLOCKS * BENCH_BLOCK - played));
+    }
+    r.ns = elapsedNs(start);
+    r.checksum = sink.checksum();
+    return r;
+}
+
+/*!
+    @brief `synth-16` under the deadline monitor; the difference to `synth-16` is what the instrumentation costs
+*/
+static bench_result_t runSynthDeadline(const bench_point_t &pt, size_t samples)
+{
+    bench_deadline_t deadline;
+    return renderDeadline(pt, samples, deadline);
+}
+
+/********************
+ * APPLICATION LOOP
+ ********************/
+
+/*!
+    @brief the example's application loop on simulated hardware, recording every code it renders
+*/
+struct bench_app_t {
+    explicit bench_app_t(uint32_t blocksPerPass) : hal(SAMPLE_RATE, SINK_BLOCK), app(hal)
+    {
+        hal.setBlocksPerPass(blocksPerPass);
+        hal.setCapture(&codes);
+        app.setup();
+    }
+
+    DsfSimHal<deadline_stages> hal;
+    DsfExampleApp app;
+    std::vector<uint16_t> codes;
+};
+
+/*!
+    @brief schedules the session's pots, buttons and encoder (every kind of `dsf_input_t` apart from MIDI and SysEx,
+    which `playSession()` sends through the app the way core 1 does) and an underrun
+*/
+static void scriptSession(bench_app_t &b)
+{
+    const struct {
+        uint32_t block;
+        uint8_t type, id;
+        int16_t value;
+    } script[] = {
+        { 0, input_control, adc_in_EnvAttack, 200 }, { 0, input_control, adc_in_EnvDecay, 1500 },
+        { 0, input_control, adc_in_EnvSustain, 3000 }, { 37, input_button, button_harmonic, 0 },
+        { 70, input_control, adc_in_EnvDecay, 3900 }, { 95, input_button, button_mult, 0 },
+        { 140, input_encoder, 0, 1 }, { 160, input_button, button_encoder, 1 }, { 161, input_encoder, 0, 3 },
+        { 200, input_encoder, 0, -5 }, { 230, input_button, button_env_invert, 0 },
+        { 260, input_button, button_encoder, 0 }, { 261, input_button, button_encoder, 1 },
+        { 300, input_control, adc_in_EnvSustain, 100 }, { 330, input_button, button_harmonic, 0 },
+    };
+    for (const auto &s : script) {
+        dsf_input_t in = {};
+        in.type = s.type;
+        in.id = s.id;
+        in.value = s.value;
+        b.hal.schedule(s.block, in);
+    }
+    b.hal.jump(350, 353 * SINK_BLOCK); // the sink skips three blocks
+}
+
+/*!
+    @brief runs the app until `blocks` blocks are rendered. With `dump`, also plays the session's MIDI the way core 1
+    delivers it, through `receiveMidi()` stamped `MIDI_LATENCY` ahead: notes at varying offsets, bend, a few messages
+    that are already late and the tuning dump `dump`.
+*/
+static void playSession(bench_app_t &b, uint32_t blocks, const uint8_t *dump = nullptr)
+{
+    while (b.hal.blocks() < blocks) {
+        uint32_t block = b.hal.blocks(), due = b.app.audioClock() + MIDI_LATENCY;
+        uint8_t note = (uint8_t)(48 + (block / 24) % 19);
+        if (dump && block % 24 == 2) {
+            uint8_t on[] = { 0x90, note, 100 };
+            b.app.receiveMidi(on, sizeof(on), due + block % 61);
+        }
+        if (dump && block % 24 == 15) {
+            uint8_t off[] = { 0x80, note, 0, 0xE0, 0, (uint8_t)(32 + block % 64) };
+            b.app.receiveMidi(off, sizeof(off), due);
+        }
+        if (dump && block % 97 == 50) {
+            uint8_t late[] = { 0x90, 72, 90, 0x80, 72, 0 };
+            b.app.receiveMidi(late, sizeof(late), due - 3 * MIDI_LATENCY);
+        }
+        if (dump && block % 120 == 100) {
+            b.app.receiveMidi(dump, DSF_MTS_DUMP_SIZE, due);
+            b.app.handOffTuning();
+        }
+        b.app.loop();
+    }
+}
+
+/*!
+    @brief replays `trace` up to its last checksum
+
+    @return `true` if every checksum matched and the codes are the first ones of `recorded`
+*/
+static bool replayTrace(const std::vector<uint8_t> &trace, const std::vector<uint16_t> &recorded, const char *what)
+{
+    bench_app_t *b = new bench_app_t(3);
+    bool loaded = b->hal.load(trace.data(), trace.size());
+    b->app.start();
+    playSession(*b, (uint32_t)(b->hal.lastChecked() + 1));
+
+    bool ok = loaded && b->hal.checked() > 0 && b->hal.mismatches() == 0 && b->codes.size() <= recorded.size() &&
+              std::equal(b->codes.begin(), b->codes.end(), recorded.begin());
+    if (!ok) {
+        fprintf(stderr, "replay: %s trace (%zu bytes, %s) replayed %u blocks, %u of %u checksums differ, codes %s\n",
+                what, trace.size(), loaded ? "loaded" : "malformed", b->hal.blocks(), b->hal.mismatches(),
+                b->hal.checked(), std::equal(b->codes.begin(), b->codes.end(), recorded.begin()) ? "match" : "differ");
+    }
+    delete b;
+    return ok;
+}
+
+/*!
+    @brief records a scripted session of the example app, with pots, buttons, encoder, MIDI (some of it late), a
+    tuning dump and an underrun, and replays the trace into a fresh app taking three blocks per pass instead of one:
+    the replay must render exactly the recorded codes and match every checksum. A trace with one note changed must
+    report its first mismatch at the check after that note; a trace that filled up must replay as a prefix.
+*/
+static bool verifyReplay()
+{
+    DsfScala scala;
+    uint8_t dump[DSF_MTS_DUMP_SIZE];
+    if (!scala.parseScl(benchScl)) return false;
+    scala.mtsDump(1, scala.description().c_str(), dump);
+
+    std::vector<uint8_t> buf(TRACE_SIZE), shortBuf(BENCH_TRACE_SHORT);
+    std::vector<uint16_t> recorded;
+    bool ok = true;
+    for (int pass = 0; pass < 2; pass++) {
+        std::vector<uint8_t> &mem = pass ? shortBuf : buf;
+        DsfTraceWriter writer(mem.data(), mem.size());
+        bench_app_t *b = new bench_app_t(1);
+        scriptSession(*b);
+        b->app.start(&writer);
+        playSession(*b, BENCH_SESSION_BLOCKS, dump);
+        if (pass == 0) recorded = b->codes;
+        else if (b->codes != recorded) ok = false; // recording twice gives the same session
+        std::vector<uint8_t> trace(writer.data(), writer.data() + writer.size());
+        delete b;
+
+        if (writer.full() != (pass == 1)) {
+            fprintf(stderr, "replay: a %zu-byte trace of %d blocks is %s\n", mem.size(), BENCH_SESSION_BLOCKS,
+                    writer.full() ? "full" : "not full");
+            ok = false;
+        }
+        if (!replayTrace(trace, recorded, pass ? "full" : "whole")) ok = false;
+        if (pass) continue;
+
+        // change the first note-on to a semitone up: the replay must diverge in the checked blocks where it plays
+        DsfTraceReader reader(trace.data(), trace.size());
+        dsf_trace_record_t r;
+        uint32_t played = 0;
+        while (reader.next(r)) {
+            if (r.kind == trace_input && r.in.type == input_midi && r.in.midi[0] == 0x90) {
+                played = r.block;
+                break;
+            }
+        }
+        uint8_t first[] = { 0x90, 48, 100 };
+        auto at = std::search(trace.begin(), trace.end(), first, first + sizeof(first));
+        if (at == trace.end()) {
+            fprintf(stderr, "replay: the first note-on isn't in the trace\n");
+            return false;
+        }
+        at[1]++;
+        bench_app_t *t = new bench_app_t(3);
+        t->hal.load(trace.data(), trace.size());
+        t->app.start();
+        playSession(*t, (uint32_t)(t->hal.lastChecked() + 1));
+        uint32_t from, to;
+        t->hal.firstMismatchBlocks(from, to);
+        if (t->hal.mismatches() == 0 || played < from || played > to) {
+            fprintf(stderr, "replay: the changed note (block %u) gave %u mismatches, the first in blocks %u-%u\n",
+                    played, t->hal.mismatches(), from, to);
+            ok = false;
+        }
+        delete t;
+    }
+    return ok;
+}
+
+/*!
+    @brief the example's whole application loop, `VOICES` voices: inputs, MIDI between spans, envelope, render and
+    trace, on the simulated hardware; `pt` sets the chord and the `a` sweep through the sustain pot
+*/
+static bench_result_t runApp(const bench_point_t &pt, size_t samples)
+{
+    uint8_t trace[BENCH_TRACE_SHORT];
+    DsfTraceWriter writer(trace, sizeof(trace));
+    bench_app_t *b = new bench_app_t(BENCH_SINK_BLOCKS);
+    dsf_input_t sustain = {};
+    sustain.type = input_control;
+    sustain.id = adc_in_EnvSustain;
+    sustain.value = (int16_t)(pt.a * DSF_CTRL_MAX);
+    b->hal.schedule(0, sustain);
+    if (pt.fm < pt.fn) b->app.multState = false;
+    b->app.start(&writer);
+
+    uint8_t root = (uint8_t)(69 + 12 * log2f(pt.fn / 440.0f));
+    for (uint8_t v = 0; v < VOICES; v++) {
+        uint8_t on[] = { 0x90, (uint8_t)(root + 3 * v), 100 };
+        b->app.receiveMidi(on, sizeof(on), 0);
+    }
+
+    uint32_t blocks = (uint32_t)(samples / SINK_BLOCK);
+    b->codes.reserve(blocks * SINK_BLOCK);
+    bench_result_t r = { 0, 0 };
+    auto start = bench_clock::now();
+    while (b->hal.blocks() < blocks) b->app.loop();
+    r.ns = elapsedNs(start);
+    for (uint16_t c : b->codes) r.checksum += c;
+    delete b;
+    return r;
+}
+
+/*!
+    @brief the centroid a `DsfProbe` should measure at a setting that doesn't wrap, from the partials
+    `a^|k| sin(2π (fn + k fm) t)` folded into 0..Nyquist (a fold flips the sign) and summed by frequency, so partials
+    that land on each other add as amplitudes; partials at DC and at Nyquist are left out, as the probe's FFT (and, at
+    Nyquist, the sampling itself) leaves them out
+*/
+static double surveyCentroid(double fn, double fm, double a)
+{
+    std::map<int64_t, double> partials; // by frequency in mHz
+    for (int32_t k = -400; k <= 400; k++) {
+        double amp = pow(a, abs(k)), f = fn + k * fm;
+        if (f < 0) {
+            f = -f;
+            amp = -amp;
+        }
+        f = fmod(f, (double)BENCH_SAMPLE_RATE);
+        if (f > BENCH_SAMPLE_RATE / 2) {
+            f = BENCH_SAMPLE_RATE - f;
+            amp = -amp;
+        }
+        partials[llround(f * 1000)] += amp;
+    }
+    double sum = 0, weighted = 0;
+    for (auto &p : partials) {
+        if (p.first == 0 || p.first == BENCH_SAMPLE_RATE / 2 * 1000) continue;
+        sum += p.second * p.second;
+        weighted += p.second * p.second * p.first / 1000.0;
+    }
+    return weighted / sum;
+}
+
+/*!
+    @brief checks the pieces of `dsf-survey`: the FFT against a direct DFT, the centroid of two tones, a probe's
+    centroid against the partial sum where `DsfOsc` doesn't wrap, its peak and wrap count against `dsfReference()`, its
+    aliasing against the partials summed one by one, and that the work-stealing pool runs every index exactly once
+    when one worker's share is much slower than the rest
+*/
+static bool verifySurvey()
+{
+    bool ok = true;
+    DsfSpectrum spectrum(BENCH_SURVEY_BURST);
+    std::vector<uint16_t> burst(BENCH_SURVEY_BURST);
+    const size_t n = burst.size();
+
+    DsfOsc osc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+    osc.freqs(float2fix15(440.0f), float2fix15(440.0f * 1.41421356f));
+    osc.renderBlock(burst.data(), n, float2fix15(0.6f));
+    const float *pw = spectrum.power(burst.data());
+    double mean = 0, peak = 0, worst = 0;
+    for (uint16_t c : burst) mean += c;
+    mean /= n;
+    for (size_t k = 0; k < spectrum.bins(); k++) {
+        double re = 0, im = 0;
+        for (size_t i = 0; i < n; i++) {
+            double x = (burst[i] - mean) * (0.5 - 0.5 * cos(2.0 * M_PI * i / n));
+            double ph = 2.0 * M_PI * (double)(k * i % n) / n;
+            re += x * cos(ph);
+            im -= x * sin(ph);
+        }
+        double p = re * re + im * im;
+        peak = std::max(peak, p);
+        worst = std::max(worst, fabs(pw[k] - p));
+    }
+    if (worst > 1e-4 * peak) {
+        fprintf(stderr, "survey: the FFT differs from the DFT by %g of the peak bin\n", worst / peak);
+        ok = false;
+    }
+
+    // two tones on bins 64 and 192 with amplitudes 1000 and 500: the centroid is (64 * 4 + 192) / 5 bins
+    for (size_t i = 0; i < n; i++) {
+        burst[i] = (uint16_t)lround(2048 + 1000 * sin(2.0 * M_PI * 64 * i / n) + 500 * sin(2.0 * M_PI * 192 * i / n));
+    }
+    spectrum.power(burst.data());
+    double twoTones = 89.6 * BENCH_SAMPLE_RATE / n;
+    if (fabs(spectrum.centroid(BENCH_SAMPLE_RATE) - twoTones) > 0.01 * BENCH_SAMPLE_RATE / n) {
+        fprintf(stderr, "survey: two-tone centroid %.2f Hz, expected %.2f\n", spectrum.centroid(BENCH_SAMPLE_RATE), twoTones);
+        ok = false;
+    }
+
+    DsfProbe probe(BENCH_SAMPLE_RATE, BENCH_DAC_BITS, n);
+    uint32_t scale = DsfOsc::phaseScale(BENCH_SAMPLE_RATE), checked = 0;
+    std::vector<double> ref(n);
+    for (float fn : { 110.0f, 440.0f, 1760.0f, 5000.0f }) {
+        for (float ratio : { 0.5f, 1.0f, 2.0f, 1.41421356f }) {
+            for (float a : { 0.3f, 0.6f, 0.9f }) {
+                dsf_probe_t m = probe.measure(fn, fn * ratio, a);
+                double fnPlayed = DsfOsc::phaseStep(float2fix15(fn), scale) * (double)BENCH_SAMPLE_RATE / 4294967296.0;
+                double fmPlayed = DsfOsc::phaseStep(float2fix15(fn * ratio), scale) * (double)BENCH_SAMPLE_RATE / 4294967296.0;
+                double aPlayed = fix2float15(float2fix15(a));
+
+                // where nothing wraps and the table noise is well below the signal, the centroid is the partials'
+                if (m.wrap == 0 && m.peak_db > -6 && a <= 0.6f) {
+                    double expected = surveyCentroid(fnPlayed, fmPlayed, aPlayed);
+                    checked++;
+                    if (fabs(m.centroid - expected) > BENCH_SURVEY_CENTROID * expected) {
+                        fprintf(stderr, "survey: fn %.0f, ratio %.3f, a %.1f: centroid %.1f Hz, expected %.1f\n", fn,
+                                ratio, a, m.centroid, expected);
+                        ok = false;
+                    }
+                }
+
+                const double halfDac = ((1 << BENCH_DAC_BITS) - 1) / 2.0;
+                dsfReference(fnPlayed, fmPlayed, aPlayed, BENCH_SAMPLE_RATE, BENCH_DAC_BITS, ref.data(), n);
+                double refPeak = 0;
+                uint32_t wrapped = 0;
+                for (double r : ref) {
+                    double x = fabs(r - halfDac) / halfDac;
+                    refPeak = std::max(refPeak, x);
+                    if (x > 1.0) wrapped++;
+                }
+                if (fabs(m.peak_db - 20.0 * log10(refPeak)) > 0.01 || abs((int)lround(m.wrap * n) - (int)wrapped) > 1) {
+                    fprintf(stderr, "survey: fn %.0f, ratio %.3f, a %.1f: peak %.3f dB and %.0f samples wrapped, "
+                            "reference %.3f dB and %u\n", fn, ratio, a, m.peak_db, m.wrap * n, 20.0 * log10(refPeak),
+                            wrapped);
+                    ok = false;
+                }
+
+                double above = 0, all = 0;
+                for (int32_t k = -100000; k <= 100000; k++) {
+                    double p = pow(aPlayed, 2.0 * abs(k));
+                    all += p;
+                    if (fabs(fnPlayed + k * fmPlayed) > BENCH_SAMPLE_RATE / 2) above += p;
+                }
+                double aliasDb = (above > 0) ? 10.0 * log10(above / all) : DSF_PROBE_FLOOR_DB;
+                if (aliasDb > DSF_PROBE_FLOOR_DB / 2 && fabs(m.alias_db - aliasDb) > BENCH_SURVEY_ALIAS_DB) {
+                    fprintf(stderr, "survey: fn %.0f, ratio %.3f, a %.1f: aliasing %.3f dB, partials %.3f dB\n", fn,
+                            ratio, a, m.alias_db, aliasDb);
+                    ok = false;
+                }
+            }
+        }
+    }
+    if (checked < 8) {
+        fprintf(stderr, "survey: only %u settings without wrapping to check the centroid on\n", checked);
+        ok = false;
+    }
+
+    // worker 0's share is a hundred times slower than the others: the others steal it, and no index runs twice
+    const size_t indices = 100000;
+    std::vector<std::atomic<uint8_t>> runs(indices);
+    DsfStealPool pool(4);
+    pool.run(indices, 16, [&](size_t begin, size_t end, unsigned worker) {
+        for (size_t i = begin; i < end; i++) {
+            volatile uint32_t spin = (i < indices / 4) ? 2000 : 20;
+            while (spin) spin = spin - 1;
+            runs[i]++;
+        }
+    });
+    size_t wrong = 0;
+    for (std::atomic<uint8_t> &r : runs) wrong += (r.load() != 1);
+    if (wrong) {
+        fprintf(stderr, "survey: the pool ran %zu of %zu indices other than once (%llu steals)\n", wrong, indices,
+                (unsigned long long)pool.steals());
+        ok = false;
+    }
+    return ok;
+}
+
+/*!
+    @brief one `dsf-survey` point: both bursts, the FFT and the formula's peak, `samples / BENCH_SURVEY_BURST` times
+*/
+static bench_result_t runSurvey(const bench_point_t &pt, size_t samples)
+{
+    DsfProbe probe(BENCH_SAMPLE_RATE, BENCH_DAC_BITS, BENCH_SURVEY_BURST);
+    bench_result_t r = { 0, 0 };
+    auto start = bench_clock::now();
+    for (size_t done = 0; done < samples; done += BENCH_SURVEY_BURST) {
+        dsf_probe_t m = probe.measure(pt.fn, pt.fm, pt.a);
+        r.checksum += (uint64_t)m.centroid + (uint64_t)(m.wrap * 1000);
+    }
+    r.ns = elapsedNs(start);
+    return r;
+}
+
+/*!
+    @brief registry of kernel variants; add new kernels here to have them measured across the whole grid
+*/
+static const bench_kernel_t kernels[] = {
+    { "getNextSample", runGetNextSample<kernel_divide>, 1, nullptr, captureGetNextSample<kernel_divide> },
+    { "renderBlock", runRenderBlock<kernel_divide>, 1, verifyRenderBlock<kernel_divide>, captureRenderBlock<kernel_divide> },
+    { "renderBlock-ramp", runRenderBlockRamp<kernel_divide>, 1 },
+    { "renderBlock-pitch", runRenderBlockPitch<kernel_divide>, 1 },
+    { "getNextSample-recip", runGetNextSample<kernel_reciprocal>, 1, verifyReciprocal,
+      captureGetNextSample<kernel_reciprocal> },
+    { "renderBlock-recip", runRenderBlock<kernel_reciprocal>, 1, verifyRenderBlock<kernel_reciprocal>,
+      captureRenderBlock<kernel_reciprocal> },
+    { "renderBlock-ramp-recip", runRenderBlockRamp<kernel_reciprocal>, 1 },
+    { "getNextSample-band", runGetNextSample<kernel_divide, true>, 1, verifyBandLimited,
+      captureGetNextSample<kernel_divide, true>, true },
+    { "renderBlock-band", runRenderBlock<kernel_divide, true>, 1, verifyRenderBlock<kernel_divide, true>,
+      captureRenderBlock<kernel_divide, true>, true },
+    { "renderBlock-ramp-band", runRenderBlockRamp<kernel_divide, true>, 1 },
+    { "renderBlock-band-recip", runRenderBlock<kernel_reciprocal, true>, 1, verifyRenderBlock<kernel_reciprocal, true>,
+      captureRenderBlock<kernel_reciprocal, true>, true },
+    { "getNextSample-q26", runGetNextSample<kernel_divide, false, DsfOscT<dsf_arith_q26>>, 1, verifyArith<dsf_arith_q26>,
+      captureGetNextSample<kernel_divide, false, DsfOscT<dsf_arith_q26>> },
+    { "renderBlock-q26", runRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_q26>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_q26>> },
+    { "renderBlock-ramp-q26", runRenderBlockRamp<kernel_divide, false, DsfOscT<dsf_arith_q26>>, 1 },
+    { "renderBlock-band-q26", runRenderBlock<kernel_divide, true, DsfOscT<dsf_arith_q26>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, true, DsfOscT<dsf_arith_q26>>, true },
+    { "getNextSample-q15", runGetNextSample<kernel_divide, false, DsfOscT<dsf_arith_q15>>, 1, verifyNarrow,
+      captureGetNextSample<kernel_divide, false, DsfOscT<dsf_arith_q15>> },
+    { "renderBlock-q15", runRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_q15>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_q15>> },
+    { "renderBlock-ramp-q15", runRenderBlockRamp<kernel_divide, false, DsfOscT<dsf_arith_q15>>, 1 },
+    { "renderBlock-band-q15", runRenderBlock<kernel_divide, true, DsfOscT<dsf_arith_q15>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, true, DsfOscT<dsf_arith_q15>>, true },
+    { "getNextSample-float", runGetNextSample<kernel_divide, false, DsfOscT<dsf_arith_float>>, 1, verifyArith<dsf_arith_float>,
+      captureGetNextSample<kernel_divide, false, DsfOscT<dsf_arith_float>> },
+    { "renderBlock-float", runRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_float>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_float>> },
+    { "renderBlock-ramp-float", runRenderBlockRamp<kernel_divide, false, DsfOscT<dsf_arith_float>>, 1 },
+    { "renderBlock-band-float", runRenderBlock<kernel_divide, true, DsfOscT<dsf_arith_float>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, true, DsfOscT<dsf_arith_float>>, true },
+    { "renderBlock-lerp", runRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_fix15, 8, lookup_linear>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_fix15, 8, lookup_linear>> },
+    { "renderBlock-t10", runRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_fix15, 10>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_fix15, 10>> },
+    { "renderBlock-t10-lerp", runRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_fix15, 10, lookup_linear>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_fix15, 10, lookup_linear>> },
+    { "renderBlock-t12", runRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_fix15, 12>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_fix15, 12>> },
+    { "renderBlock-t12-lerp", runRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_fix15, 12, lookup_linear>>, 1, nullptr,
+      captureRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_fix15, 12, lookup_linear>> },
+    { "renderBlock-q26-t12-lerp", runRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_q26, 12, lookup_linear>>, 1,
+      nullptr, captureRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_q26, 12, lookup_linear>> },
+    { "renderBlock-float-t12-lerp", runRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_float, 12, lookup_linear>>, 1,
+      nullptr, captureRenderBlock<kernel_divide, false, DsfOscT<dsf_arith_float, 12, lookup_linear>> },
+    { "voicePool-4", runVoicePool<4, kernel_divide>, 4 },
+    { "voicePool-8", runVoicePool<8, kernel_divide>, 8 },
+    { "voicePool-16", runVoicePool<16, kernel_divide>, 16 },
+    { "voicePool-16-recip", runVoicePool<16, kernel_reciprocal>, 16 },
+    { "voicePool-16-band", runVoicePool<16, kernel_divide, true>, 16 },
+    { "voicePool-16-cache", runVoicePool<16, kernel_divide, false, true>, 16, verifyWaveCache },
+    { "simd-scalar-16", runSimd<simd_scalar>, BENCH_SIMD_VOICES, verifySimd<simd_scalar> },
+    { "simd-sse2-16", runSimd<simd_sse2>, BENCH_SIMD_VOICES, verifySimd<simd_sse2> },
+    { "simd-avx2-16", runSimd<simd_avx2>, BENCH_SIMD_VOICES, verifySimd<simd_avx2> },
+    { "simd-avx512-16", runSimd<simd_avx512>, BENCH_SIMD_VOICES, verifySimd<simd_avx512> },
+    { "controls-update", runControls, 1, verifyControls },
+    { "envelope-linear", runEnvelope<env_linear>, 1, verifyEnvelope },
+    { "envelope-exponential", runEnvelope<env_exponential>, 1 },
+    { "sink-null-pool-4", runSinkNull, 4, verifyFileSink },
+    { "midi-queue-synth-4", runMidiQueue, 4, verifyMidiQueue },
+    { "midi-timed-synth-4", runMidiTimed, 4, verifyMidiTiming },
+    { "midi-parser", runMidiParser, 1, verifyMidiParser },
+    { "synth-16", runSynth<false>, BENCH_SYNTH_VOICES },
+    { "synth-dual-16", runSynth<true>, BENCH_SYNTH_VOICES, verifyDualRender },
+    { "synth-16-cache", runSynth<false, true>, BENCH_SYNTH_VOICES },
+    { "synth-16-deadline", runSynthDeadline, BENCH_SYNTH_VOICES, verifyDeadline },
+    { "synth-16-scala", runSynthScala, BENCH_SYNTH_VOICES, verifyTuning },
+    { "tuning-load", runTuningLoad, 1 },
+    { "log-record", runLog, 1, verifyLog },
+    { "app-loop-4", runApp, VOICES, verifyReplay },
+    { "survey-probe", runSurvey, 1, verifySurvey },
+};
+
+/*!
+    @brief prints the RAM footprint of the oscillator types and the cost of constructing a bank of 32 oscillators
+*/
+static void reportFootprint()
+{
+    constexpr size_t bank = 32, rounds = 1000;
+    alignas(DsfOsc) static unsigned char storage[bank * sizeof(DsfOsc)];
+    DsfOsc *osc = reinterpret_cast<DsfOsc *>(storage);
+
+    auto start = bench_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < bank; i++) new (&osc[i]) DsfOsc(BENCH_SAMPLE_RATE, BENCH_DAC_BITS);
+        __asm__ __volatile__("" : : "r"(osc) : "memory");
+    }
+    double ns = elapsedNs(start) / (double)rounds;
+
+    printf("footprint: DsfOsc %zu bytes, DsfVoicePool<16> %zu bytes, shared sine table %zu bytes (flash)\n",
+           sizeof(DsfOsc), sizeof(DsfVoicePool<16>), sizeof(DsfOsc::table_sine));
+    printf("construct %zu x DsfOsc: %.1f ns\n\n", bank, ns);
+}
+
+/*!
+    @brief one table size and lookup mode in `reportLookup()`
+*/
+typedef struct {
+    const char *name;
+    size_t tableBytes;
+    bench_result_t (*run)(const bench_point_t &pt, size_t samples);
+    void (*capture)(const bench_point_t &pt, uint16_t *out, size_t n);
+} bench_lookup_t;
+
+template <uint8_t BITS, dsf_lookup_t L>
+static constexpr bench_lookup_t lookupRow(const char *name)
+{
+    typedef DsfOscT<dsf_arith_fix15, BITS, L> osc_t;
+    return { name, sizeof(osc_t::table_sine), runRenderBlock<kernel_divide, false, osc_t>,
+             captureRenderBlock<kernel_divide, false, osc_t> };
+}
+
+/*!
+    @brief the cost/quality trade-off of every table size and lookup mode of the fix15 `renderBlock()`
+
+    Measured where the formula stays inside the DAC range (modulator at twice the carrier, `a` inside the clamp), so the
+    accuracy columns show the table's error rather than wrapped samples: mean ns/sample, mean SNR and THD+N, and the
+    largest error over the grid's carriers and `a` = 0.1, 0.5, 0.9.
+*/
+static void reportLookup(size_t samples, int repeat)
+{
+    static const bench_lookup_t rows[] = {
+        lookupRow<8, lookup_truncate>("256 truncate"),   lookupRow<8, lookup_linear>("256 linear"),
+        lookupRow<10, lookup_truncate>("1024 truncate"), lookupRow<10, lookup_linear>("1024 linear"),
+        lookupRow<12, lookup_truncate>("4096 truncate"), lookupRow<12, lookup_linear>("4096 linear"),
+    };
+    std::vector<uint16_t> captured(BENCH_ACCURACY_SAMPLES);
+    std::vector<double> reference(BENCH_ACCURACY_SAMPLES);
+
+    printf("%-16s %8s %12s %8s %8s %8s\n", "table lookup", "bytes", "ns/sample", "SNR dB", "max err", "THD+N");
+    for (const bench_lookup_t &row : rows) {
+        double ns = 0, snr = 0, thdn = 0, maxErr = 0;
+        int points = 0;
+        for (float fn : { 55.0f, 440.0f, 3520.0f }) {
+            for (float a : { 0.1f, 0.5f, 0.9f }) {
+                bench_point_t pt = { fn, 2.0f * fn, a };
+                double best = row.run(pt, samples).ns;
+                for (int r = 1; r < repeat; r++) best = std::min(best, row.run(pt, samples).ns);
+                row.capture(pt, captured.data(), captured.size());
+                dsfReference(pt.fn, pt.fm, pt.a, BENCH_SAMPLE_RATE, BENCH_DAC_BITS, reference.data(), reference.size());
+                dsf_accuracy_t acc = dsfAccuracy(captured.data(), reference.data(), captured.size());
+                ns += best / (double)samples;
+                snr += acc.snr_db;
+                thdn += acc.thdn_db;
+                maxErr = std::max(maxErr, acc.max_error);
+                points++;
+            }
+        }
+        printf("%-16s %8zu %12.3f %8.2f %8.1f %8.2f\n", row.name, row.tableBytes, ns / points, snr / points, maxErr,
+               thdn / points);
+    }
+    printf("\n");
+}
+
+/*!
+    @brief what the firmware prints with `DEADLINE_DUMP_KEY`, for `synth-16` on this machine: the host runs far ahead of
+    real time, so expect short blocks and a growing slack
+*/
+static void reportDeadline(size_t samples)
+{
+    bench_deadline_t deadline;
+    renderDeadline({ 440.0f, 880.0f, 0.5f }, samples, deadline);
+    deadline.print(benchStageNames);
+    printf("\n");
+}
+
+/********************
+ * BASELINE
+ ********************/
+
+static std::string baselineKey(const char *kernel, const bench_point_t &pt)
+{
+    char key[96];
+    snprintf(key, sizeof(key), "%s,%.2f,%.2f,%.2f", kernel, pt.fn, pt.fm, pt.a);
+    return key;
+}
+
+/*!
+    @brief reads a file written with `--write-baseline`
+
+    @return `false` if the file can't be opened
+*/
+static bool loadBaseline(const char *path, std::map<std::string, bench_baseline_t> &rows)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char line[256], name[64];
+    while (fgets(line, sizeof(line), f)) {
+        bench_point_t pt;
+        bench_baseline_t b;
+        if (sscanf(line, "%63[^,],%f,%f,%f,%lf,%lf,%lf,%lf", name, &pt.fn, &pt.fm, &pt.a, &b.acc.snr_db, &b.acc.max_error,
+                   &b.acc.thdn_db, &b.nsPerSample) == 8) {
+            rows[baselineKey(name, pt)] = b;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+/*!
+    @brief compares one grid point with its baseline row and prints every metric that got worse
+
+    @param slowdown accepted ns/sample increase in percent; 0 skips the speed check (timings depend on the machine)
+    @return `false` on a regression
+*/
+static bool checkBaseline(const char *kernel, const bench_point_t &pt, const bench_baseline_t &base,
+                          const dsf_accuracy_t &acc, double nsPerSample, double slowdown)
+{
+    bool ok = true;
+    auto regress = [&](const char *metric, double was, double now) {
+        printf("%-24s %9.2f %9.2f %5.2f REGRESSION %s: %.3f -> %.3f\n", kernel, pt.fn, pt.fm, pt.a, metric, was, now);
+        ok = false;
+    };
+    if (acc.snr_db < base.acc.snr_db - BENCH_TOLERANCE_DB) regress("SNR dB", base.acc.snr_db, acc.snr_db);
+    if (acc.thdn_db > base.acc.thdn_db + BENCH_TOLERANCE_DB) regress("THD+N dB", base.acc.thdn_db, acc.thdn_db);
+    if (acc.max_error > base.acc.max_error + BENCH_TOLERANCE_LSB) regress("max error LSB", base.acc.max_error, acc.max_error);
+    if (slowdown > 0 && nsPerSample > base.nsPerSample * (1.0 + slowdown / 100.0)) regress("ns/sample", base.nsPerSample, nsPerSample);
+    return ok;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [--samples N] [--repeat N] [--filter NAME] [--csv FILE]\n"
+                    "       [--baseline FILE] [--write-baseline FILE] [--slowdown PCT]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    size_t samples = 1 << 20;
+    int repeat = 3;
+    double slowdown = 0;
+    const char *filter = nullptr;
+    const char *csvPath = nullptr;
+    const char *baselinePath = nullptr, *writeBaselinePath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--samples") && i + 1 < argc) {
+            samples = strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (!strcmp(argv[i], "--write-baseline") && i + 1 < argc) {
+            writeBaselinePath = argv[++i];
+        } else if (!strcmp(argv[i], "--slowdown") && i + 1 < argc) {
+            slowdown = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    // keep whole blocks so every kernel renders the same number of samples
+    samples = ((samples + BENCH_BLOCK - 1) / BENCH_BLOCK) * BENCH_BLOCK;
+    if (repeat < 1) repeat = 1;
+
+    std::map<std::string, bench_baseline_t> baseline;
+    if (baselinePath && !loadBaseline(baselinePath, baseline)) return 1;
+
+    FILE *csv = nullptr;
+    if (csvPath) {
+        csv = strcmp(csvPath, "-") ? fopen(csvPath, "w") : stdout;
+        if (!csv) {
+            perror(csvPath);
+            return 1;
+        }
+        fprintf(csv, "kernel,voices,fn_hz,fm_hz,a,samples,ns_per_sample,samples_per_sec,ns_per_voice,max_voices,checksum,"
+                     "snr_db,max_error_lsb,thdn_db\n");
+    }
+
+    FILE *baselineOut = nullptr;
+    if (writeBaselinePath) {
+        baselineOut = fopen(writeBaselinePath, "w");
+        if (!baselineOut) {
+            perror(writeBaselinePath);
+            return 1;
+        }
+        fprintf(baselineOut, "kernel,fn_hz,fm_hz,a,snr_db,max_error_lsb,thdn_db,ns_per_sample\n");
+    }
+
+    reportFootprint();
+    if (!filter || strstr("lookup", filter)) reportLookup(samples, repeat);
+    if (!filter || strstr("deadline", filter)) reportDeadline(samples);
+
+    printf("%-24s %9s %9s %5s %12s %14s %10s %8s %8s %8s\n", "kernel", "fn", "fm", "a", "ns/sample", "samples/sec",
+           "ns/voice", "SNR dB", "max err", "THD+N");
+
+    std::vector<uint16_t> captured(BENCH_ACCURACY_SAMPLES);
+    std::vector<double> reference(BENCH_ACCURACY_SAMPLES);
+    size_t regressions = 0;
+    int status = 0;
+    for (const bench_kernel_t &k : kernels) {
+        if (filter && !strstr(k.name, filter)) continue;
+        if (k.verify) {
+            bool ok = k.verify();
+            printf("%-24s verify: %s\n", k.name, ok ? "pass" : "FAIL");
+            if (!ok) {
+                status = 1;
+                continue;
+            }
+        }
+        double totalNs = 0;
+        size_t points = 0;
+
+        for (float fn : gridFn) {
+            for (float ratio : gridRatio) {
+                for (float a : gridA) {
+                    bench_point_t pt = { fn, fn * ratio, a };
+                    bench_result_t best = k.run(pt, samples);
+                    for (int r = 1; r < repeat; r++) {
+                        bench_result_t next = k.run(pt, samples);
+                        if (next.ns < best.ns) best = next;
+                    }
+
+                    double nsPerSample = best.ns / (double)samples;
+                    double perSec = 1e9 / nsPerSample;
+                    double nsPerVoice = nsPerSample / (double)k.voices;
+                    unsigned maxVoices = (unsigned)(BENCH_BUDGET_NS / nsPerVoice);
+                    totalNs += nsPerSample;
+                    points++;
+
+                    printf("%-24s %9.2f %9.2f %5.2f %12.3f %14.0f %10.3f", k.name, pt.fn, pt.fm, pt.a, nsPerSample, perSec,
+                           nsPerVoice);
+                    if (csv) {
+                        fprintf(csv, "%s,%u,%.2f,%.2f,%.2f,%zu,%.4f,%.0f,%.4f,%u,%llu,", k.name, k.voices, pt.fn, pt.fm, pt.a,
+                                samples, nsPerSample, perSec, nsPerVoice, maxVoices, (unsigned long long)best.checksum);
+                    }
+                    if (!k.capture) {
+                        printf(" %8s %8s %8s\n", "-", "-", "-");
+                        if (csv) fprintf(csv, ",,\n");
+                        continue;
+                    }
+
+                    // accuracy against the double-precision model, from a fresh oscillator
+                    k.capture(pt, captured.data(), captured.size());
+                    int32_t harmonics = -1;
+                    if (k.band) {
+                        uint32_t scale = DsfOsc::phaseScale(BENCH_SAMPLE_RATE);
+                        harmonics = DsfOsc::harmonics(DsfOsc::phaseStep(float2fix15(pt.fn), scale),
+                                                      DsfOsc::phaseStep(float2fix15(pt.fm), scale));
+                    }
+                    dsfReference(pt.fn, pt.fm, pt.a, BENCH_SAMPLE_RATE, BENCH_DAC_BITS, reference.data(), reference.size(),
+                                 harmonics);
+                    dsf_accuracy_t acc = dsfAccuracy(captured.data(), reference.data(), captured.size());
+                    printf(" %8.2f %8.1f %8.2f\n", acc.snr_db, acc.max_error, acc.thdn_db);
+                    if (csv) fprintf(csv, "%.4f,%.4f,%.4f\n", acc.snr_db, acc.max_error, acc.thdn_db);
+                    if (baselineOut) {
+                        fprintf(baselineOut, "%s,%.2f,%.2f,%.2f,%.4f,%.4f,%.4f,%.4f\n", k.name, pt.fn, pt.fm, pt.a, acc.snr_db,
+                                acc.max_error, acc.thdn_db, nsPerSample);
+                    }
+                    auto row = baseline.find(baselineKey(k.name, pt));
+                    if (row != baseline.end() && !checkBaseline(k.name, pt, row->second, acc, nsPerSample, slowdown)) {
+                        regressions++;
+                    }
+                }
+            }
+        }
+        if (points) {
+            double meanNs = totalNs / (double)points;
+            printf("%-24s %-25s %12.3f   -> %u voices fit in the %.0f ns sample budget\n\n", k.name, "mean", meanNs,
+                   (unsigned)(BENCH_BUDGET_NS * k.voices / meanNs), BENCH_BUDGET_NS);
+        }
+    }
+
+    if (csv && csv != stdout) fclose(csv);
+    if (baselineOut) fclose(baselineOut);
+    if (baselinePath) {
+        printf("baseline %s: %zu regressions\n", baselinePath, regressions);
+        if (regressions) status = 1;
+    }
+    return status;
+}
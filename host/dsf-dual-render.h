@@ -0,0 +1,143 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Two-Thread Renderer (host)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * The host counterpart of the firmware's dual-core rendering:
+ * the calling thread and one worker each render half of a
+ * `DsfSynth`'s voices into their own accumulator, meeting at
+ * a barrier before and after, and the caller mixes down. The
+ * same `prepareBlock()`/`renderPart()`/`finishBlock()` split
+ * runs on the RP2040 with the inter-core FIFO in place of the
+ * barrier, so the partitioning and the mix can be checked and
+ * timed here.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <atomic>
+#include <thread>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-synth.h"
+
+/*!
+    @brief Reusable spinning barrier for a fixed number of threads.
+
+    The last thread to arrive starts a new generation; the others spin on it (yielding, so a single-core host still
+    makes progress). Arriving is a release and leaving an acquire, so everything written before `wait()` on one thread
+    is visible after `wait()` on the others.
+*/
+class DsfSpinBarrier {
+
+    public:
+        explicit DsfSpinBarrier(unsigned count) : threads(count) {}
+
+        void wait()
+        {
+            unsigned gen = generation.load(std::memory_order_acquire);
+            if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == threads) {
+                arrived.store(0, std::memory_order_relaxed);
+                generation.store(gen + 1, std::memory_order_release);
+            } else {
+                while (generation.load(std::memory_order_acquire) == gen) std::this_thread::yield();
+            }
+        }
+
+    private:
+        std::atomic<unsigned> arrived{ 0 }, generation{ 0 };
+        const unsigned threads;
+};
+
+/*!
+    @brief Renders a `DsfSynth` on two threads: even voices on the caller, odd voices on a worker.
+
+    The output is identical to `DsfSynth::renderBlock()`. The synth may only be changed (notes, bend, envelope) between
+    `renderBlock()` calls, which is where the firmware drains its MIDI queue too.
+
+    @tparam N number of voices of the synth
+*/
+template <uint8_t N>
+class DsfDualRender {
+
+    public:
+        explicit DsfDualRender(DsfSynth<N> &synth);
+        ~DsfDualRender();
+        void renderBlock(uint16_t *out, size_t n);
+
+    private:
+        void worker();
+
+        DsfSynth<N> &synth;
+        DsfSpinBarrier start{ 2 }, done{ 2 };
+        int32_t acc[2][DSF_SYNTH_BLOCK];
+        size_t blockLen = 0;
+        bool quit = false;
+        std::thread thread;
+};
+
+/*!
+    @brief Constructor; starts the worker thread.
+
+    @param synth the synth to render; must outlive this object
+*/
+template <uint8_t N>
+DsfDualRender<N>::DsfDualRender(DsfSynth<N> &synth) : synth(synth)
+{
+    thread = std::thread(&DsfDualRender<N>::worker, this);
+}
+
+/*!
+    @brief stops and joins the worker thread
+*/
+template <uint8_t N>
+DsfDualRender<N>::~DsfDualRender()
+{
+    quit = true;
+    start.wait();
+    thread.join();
+}
+
+/*!
+    @brief renders `n` samples, splitting each block of up to `DSF_SYNTH_BLOCK` samples between the two threads
+
+    @param out caller-supplied buffer of at least `n` samples
+    @param n the number of samples to render
+*/
+template <uint8_t N>
+void DsfDualRender<N>::renderBlock(uint16_t *out, size_t n)
+{
+    while (n > 0) {
+        size_t len = (n < DSF_SYNTH_BLOCK) ? n : DSF_SYNTH_BLOCK;
+        synth.prepareBlock(len);
+        blockLen = len;
+
+        start.wait();
+        synth.renderPart(acc[0], len, 0, 2);
+        done.wait();
+
+        synth.finishBlock(out, len, acc[0], acc[1]);
+        out += len;
+        n -= len;
+    }
+}
+
+/*!
+    @brief the worker: renders the odd voices of every block until told to quit
+*/
+template <uint8_t N>
+void DsfDualRender<N>::worker()
+{
+    while (true) {
+        start.wait();
+        if (quit) return;
+        synth.renderPart(acc[1], blockLen, 1, 2);
+        done.wait();
+    }
+}
@@ -0,0 +1,38 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Host Deadline Clock
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Stands in for the RP2040 SysTick counter the firmware times
+ * its render loop with, so `DsfDeadlineMonitor` runs on the
+ * host: nanoseconds from `std::chrono::steady_clock`.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <chrono>
+#include <cstdint>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-deadline.h"
+
+/*!
+    @brief `DsfDeadlineMonitor` clock counting nanoseconds; wraps after 4.3 s, far longer than any block
+*/
+struct dsf_chrono_clock_t {
+    static constexpr uint32_t mask = 0xFFFFFFFFu;
+
+    static void start() {}
+    static inline uint32_t now()
+    {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    static uint32_t hz() { return 1000000000u; }
+};
@@ -0,0 +1,98 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Host Audio Sinks
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-host-sinks.h"
+
+/*!
+    @brief adds the block to the checksum and drops it
+*/
+void DsfNullSink::commit()
+{
+    for (uint16_t s : block) sum += s;
+    blockCount++;
+}
+
+/*!
+    @brief Constructor. Opens (truncates) `path`; `ok()` turns false if it can't be opened or a write fails.
+
+    @param path output file
+    @param wav `true` for a WAV file, `false` for headerless PCM
+    @param sample_rate the sample rate written to the WAV header, in Hz
+    @param dac_bit_depth the bit depth of the DAC codes that will be committed
+    @param block_size samples per block
+*/
+DsfFileSink::DsfFileSink(const char *path, bool wav, uint32_t sample_rate, uint8_t dac_bit_depth, size_t block_size)
+    : block(block_size), pcm(block_size)
+{
+    fs = sample_rate;
+    dacbits = dac_bit_depth;
+    isWav = wav;
+    file = fopen(path, "wb");
+    if (!file) failed = true;
+    else if (isWav) writeHeader(0);
+}
+
+DsfFileSink::~DsfFileSink()
+{
+    close();
+}
+
+/*!
+    @brief converts the block to signed 16-bit PCM and appends it to the file
+*/
+void DsfFileSink::commit()
+{
+    if (!file) return;
+
+    int32_t centre = 1 << (dacbits - 1);
+    int shift = 16 - dacbits;
+    for (size_t i = 0; i < block.size(); i++) pcm[i] = (int16_t)((block[i] - centre) * (1 << shift));
+
+    // WAV and raw PCM are little-endian, like every host this builds on
+    if (fwrite(pcm.data(), sizeof(int16_t), pcm.size(), file) != pcm.size()) failed = true;
+    dataBytes += (uint32_t)(pcm.size() * sizeof(int16_t));
+    blockCount++;
+}
+
+/*!
+    @brief patches the WAV sizes and closes the file; further commits are ignored
+*/
+void DsfFileSink::close()
+{
+    if (!file) return;
+    if (isWav) {
+        fseek(file, 0, SEEK_SET);
+        writeHeader(dataBytes);
+    }
+    if (fclose(file) != 0) failed = true;
+    file = nullptr;
+}
+
+/*!
+    @brief writes a 44-byte canonical WAV header (PCM, mono, 16-bit)
+
+    @param data_bytes size of the sample data that follows
+*/
+void DsfFileSink::writeHeader(uint32_t data_bytes)
+{
+    auto put16 = [](uint8_t *p, uint16_t v) { p[0] = v & 0xFF; p[1] = v >> 8; };
+    auto put32 = [](uint8_t *p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF; };
+
+    uint8_t h[44] = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' };
+    put32(h + 4, 36 + data_bytes);
+    put32(h + 16, 16);        // fmt chunk size
+    put16(h + 20, 1);         // PCM
+    put16(h + 22, 1);         // mono
+    put32(h + 24, fs);
+    put32(h + 28, fs * 2);    // byte rate
+    put16(h + 32, 2);         // block align
+    put16(h + 34, 16);        // bits per sample
+    h[36] = 'd'; h[37] = 'a'; h[38] = 't'; h[39] = 'a';
+    put32(h + 40, data_bytes);
+
+    if (fwrite(h, 1, sizeof(h), file) != sizeof(h)) failed = true;
+}
@@ -0,0 +1,72 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Host Audio Sinks
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * `DsfAudioSink` implementations for the host: raw PCM and
+ * WAV files (16-bit signed, mono) and a null sink that
+ * discards blocks, for benchmarking the render loop.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdio>
+#include <vector>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-audio-sink.h"
+
+/*!
+    @brief Discards every block; never runs out of room and never underruns.
+*/
+class DsfNullSink : public DsfAudioSink {
+
+    public:
+        explicit DsfNullSink(size_t block_size) : block(block_size) {}
+        uint16_t *acquire() override { return block.data(); }
+        void commit() override;
+        size_t blockSize() const override { return block.size(); }
+
+        /*!
+            @return sum of every committed sample, so the rendering can't be optimised away
+        */
+        uint64_t checksum() const { return sum; }
+
+    private:
+        std::vector<uint16_t> block;
+        uint64_t sum = 0;
+};
+
+/*!
+    @brief Writes blocks as 16-bit signed little-endian PCM, either headerless (`.raw`) or as a mono WAV file.
+
+    DAC codes are centred and shifted up to 16 bits: code `c` of a `b`-bit DAC becomes `(c - 2^(b-1)) << (16 - b)`. The
+    WAV header is written when the sink is opened and its sizes are patched in `close()` (or the destructor).
+*/
+class DsfFileSink : public DsfAudioSink {
+
+    public:
+        DsfFileSink(const char *path, bool wav, uint32_t sample_rate, uint8_t dac_bit_depth, size_t block_size);
+        ~DsfFileSink() override;
+        uint16_t *acquire() override { return file ? block.data() : nullptr; }
+        void commit() override;
+        size_t blockSize() const override { return block.size(); }
+        bool ok() const { return !failed; }
+        void close();
+
+    private:
+        void writeHeader(uint32_t data_bytes);
+
+        std::vector<uint16_t> block;
+        std::vector<int16_t> pcm;
+        FILE *file;
+        uint32_t fs, dataBytes = 0;
+        uint8_t dacbits;
+        bool isWav, failed = false;
+};
@@ -0,0 +1,106 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Parameter Probe (host)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-probe.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*!
+    @param sample_rate the sample rate in Hz
+    @param dac_bit_depth the DAC bit depth the oscillator renders for
+    @param samples burst length, a power of two (at least 4)
+*/
+DsfProbe::DsfProbe(uint16_t sample_rate, uint8_t dac_bit_depth, size_t samples)
+    : osc(sample_rate, dac_bit_depth), spectrum(samples), burst(samples), fs(sample_rate)
+{
+}
+
+static float toDb(double num, double den, double scale)
+{
+    if (den <= 0 || num <= 0) return DSF_PROBE_FLOOR_DB;
+    return (float)std::max((double)DSF_PROBE_FLOOR_DB, scale * log10(num / den));
+}
+
+/*!
+    @brief peak and wrap fraction of the formula itself: `(1 - a^2) sin(θ) / (1 + a^2 - 2a cos(β))`, with θ and β
+    advanced by rotating unit vectors rather than calling `sin()`/`cos()` for every sample
+*/
+void DsfProbe::ideal(double fn, double fm, double a, dsf_probe_t &r)
+{
+    const size_t n = burst.size();
+    const double wn = 2.0 * M_PI * fn / fs, wm = 2.0 * M_PI * fm / fs;
+    const double rnC = cos(wn), rnS = sin(wn), rmC = cos(wm), rmS = sin(wm);
+    const double num = 1.0 - a * a, den = 1.0 + a * a;
+    double thC = 1, thS = 0, beC = 1, beS = 0, peak = 0;
+    size_t wrapped = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        double x = fabs(num * thS / (den - 2.0 * a * beC));
+        if (x > peak) peak = x;
+        if (x > 1.0) wrapped++;
+        double c = thC * rnC - thS * rnS;
+        thS = thS * rnC + thC * rnS;
+        thC = c;
+        c = beC * rmC - beS * rmS;
+        beS = beS * rmC + beC * rmS;
+        beC = c;
+    }
+    r.peak_db = toDb(peak, 1.0, 20.0);
+    r.wrap = (float)wrapped / (float)n;
+}
+
+/*!
+    @brief the power of the partials `a^|k| sin(2π (fn + k fm) t)` above Nyquist relative to all of them
+
+    The upper sidebands from `k+` on and the lower ones from `k-` on (the first beyond `+fs/2` and `-fs/2`) are geometric
+    series, so the ratio is `(a^(2 k+) + a^(2 k-)) / (1 + a^2)`. Partials that fold onto each other are counted by
+    power, as if they didn't.
+
+    @param fn carrier frequency in Hz, below Nyquist
+    @param fm modulator frequency in Hz
+    @param a the `a` term, `0 <= a < 1`
+    @param sample_rate the sample rate in Hz
+    @return the ratio in dB, at least `DSF_PROBE_FLOOR_DB`
+*/
+float DsfProbe::aliasDb(double fn, double fm, double a, double sample_rate)
+{
+    if (fm <= 0) return DSF_PROBE_FLOOR_DB;
+    double nyquist = sample_rate / 2;
+    double up = floor((nyquist - fn) / fm) + 1, down = floor((nyquist + fn) / fm) + 1;
+    double alias = pow(a, 2 * up) + pow(a, 2 * down);
+    return toDb(alias, 1 + a * a, 10.0);
+}
+
+/*!
+    @brief renders one setting from phase 0 and measures it
+
+    @param fn carrier frequency in Hz
+    @param fm modulator frequency in Hz
+    @param a the `a` term, clamped to `param_a_min15..param_a_max15` like `DsfOsc` does
+    @return the measurements, see `dsf_probe_t`
+*/
+dsf_probe_t DsfProbe::measure(float fn, float fm, float a)
+{
+    fix15 fn15 = float2fix15(fn), fm15 = float2fix15(fm), a15 = float2fix15(a);
+    if (a15 > param_a_max15) a15 = param_a_max15;
+    if (a15 < param_a_min15) a15 = param_a_min15;
+
+    osc.freqs(fn15, fm15);
+    osc.renderBlock(burst.data(), burst.size(), a15);
+
+    dsf_probe_t r;
+    spectrum.power(burst.data());
+    r.centroid = (float)spectrum.centroid(fs);
+
+    uint32_t scale = DsfOsc::phaseScale(fs);
+    double stepToHz = (double)fs / 4294967296.0;
+    double fnPlayed = DsfOsc::phaseStep(fn15, scale) * stepToHz, fmPlayed = DsfOsc::phaseStep(fm15, scale) * stepToHz;
+    r.alias_db = aliasDb(fnPlayed, fmPlayed, fix2float15(a15), fs);
+    ideal(fnPlayed, fmPlayed, fix2float15(a15), r);
+    return r;
+}
@@ -0,0 +1,76 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Parameter Probe (host)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Measures what one (fn, fm, a) setting sounds like through
+ * `DsfOsc`: the spectral centroid of what it renders, how
+ * much of the formula's energy lies in partials above
+ * Nyquist that fold back, and how close the formula comes to
+ * the DAC range (and how often it leaves it and wraps).
+ * `dsf-survey` runs it over a whole grid.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-oscillator-pico.h"
+#include "dsf-spectrum.h"
+
+#define DSF_PROBE_FLOOR_DB -200.0f // reported instead of minus infinity for a perfect result
+
+/*!
+    @brief the measurements of one setting
+
+    @param centroid spectral centroid of the rendered burst in Hz (see `DsfSpectrum::centroid()`), wrapping included
+    @param alias_db power of the partials `fn + k fm` that lie beyond ±Nyquist and fold back, relative to the power of
+           all of them, in dB
+    @param peak_db the formula's largest magnitude over the burst relative to the DAC's half range, in dB; above 0,
+           `DsfOsc` wraps
+    @param wrap fraction of the burst's samples that leave the DAC range and wrap
+*/
+typedef struct {
+    float centroid, alias_db, peak_db, wrap;
+} dsf_probe_t;
+
+/*!
+    @brief Measures settings of a `DsfOsc` from bursts of `samples` samples.
+
+    Every burst starts from a fresh phase, so a setting measures the same wherever it falls in a sweep. `a` is clamped
+    the way `DsfOsc` clamps it. The centroid is measured on the rendered codes, so it includes what wrapping and the
+    table add; aliasing, peak and wrap describe the formula itself, in double precision at the frequencies the
+    oscillator's phase increments actually play, because wrapping would swamp the folded partials in any spectrum of
+    the output. Keep one probe per thread: it owns its oscillator and buffers.
+*/
+class DsfProbe {
+
+    public:
+        DsfProbe(uint16_t sample_rate, uint8_t dac_bit_depth, size_t samples);
+
+        dsf_probe_t measure(float fn, float fm, float a);
+
+        static float aliasDb(double fn, double fm, double a, double sample_rate);
+
+        /*!
+            @return the burst of the last `measure()` as `DsfOsc` plays it
+        */
+        const std::vector<uint16_t> &output() const { return burst; }
+
+    private:
+        void ideal(double fn, double fm, double a, dsf_probe_t &r);
+
+        DsfOsc osc;
+        DsfSpectrum spectrum;
+        std::vector<uint16_t> burst;
+        uint16_t fs;
+};
@@ -0,0 +1,97 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Double-Precision Reference Model (host)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-reference.h"
+
+#include <cmath>
+
+#define DSF_REF_FLOOR_DB 200.0 // reported for a perfect match instead of infinity
+
+/*!
+    @brief renders `n` samples of `(1 - a^2) sin(θ) / (1 + a^2 - 2a cos(β))` in DAC units, or of the finite sum with
+    `harmonics` sidebands on each side (see `DsfOsc::setBandLimited()`)
+
+    Both phases start at 0 like a fresh `DsfOsc`, and the result is mapped to the DAC range the same way
+    (`x * halfDac + halfDac`) but neither rounded nor clipped.
+
+    @param fn carrier frequency in Hz
+    @param fm modulator frequency in Hz
+    @param a the `a` term, used as given (no clamp)
+    @param sample_rate the sample rate in Hz
+    @param dac_bit_depth the DAC bit depth the output is scaled to
+    @param out receives `n` samples
+    @param n the number of samples
+    @param harmonics sideband count N of the finite sum, or negative for the infinite sum
+*/
+void dsfReference(double fn, double fm, double a, uint32_t sample_rate, uint8_t dac_bit_depth, double *out, size_t n,
+                  int32_t harmonics)
+{
+    const double halfDac = ((double)((1u << dac_bit_depth) - 1)) / 2.0;
+    const double wn = 2.0 * M_PI * fn / sample_rate, wm = 2.0 * M_PI * fm / sample_rate;
+    const double aN1 = (harmonics < 0) ? 0.0 : pow(a, harmonics + 1);
+
+    for (size_t i = 0; i < n; i++) {
+        // phase from the sample index, not accumulated, so the reference itself doesn't drift
+        double beta = wm * (double)i;
+        double num = 1.0 - a * a;
+        if (harmonics >= 0) num -= 2.0 * aN1 * (cos((harmonics + 1) * beta) - a * cos(harmonics * beta));
+        double x = num * sin(wn * (double)i) / (1.0 + a * a - 2.0 * a * cos(beta));
+        out[i] = x * halfDac + halfDac;
+    }
+}
+
+static double toDb(double num, double den)
+{
+    if (den <= 0) return DSF_REF_FLOOR_DB;
+    if (num <= 0) return -DSF_REF_FLOOR_DB;
+    return 10.0 * log10(num / den);
+}
+
+/*!
+    @brief compares a rendered signal with the reference
+
+    @param out rendered DAC codes
+    @param ref the reference from `dsfReference()` for the same settings
+    @param n the number of samples in both
+    @return SNR, max error and THD+N, see `dsf_accuracy_t`
+*/
+dsf_accuracy_t dsfAccuracy(const uint16_t *out, const double *ref, size_t n)
+{
+    dsf_accuracy_t r = { 0, 0, 0 };
+    if (n == 0) return r;
+
+    double meanOut = 0, meanRef = 0;
+    for (size_t i = 0; i < n; i++) {
+        meanOut += out[i];
+        meanRef += ref[i];
+    }
+    meanOut /= n;
+    meanRef /= n;
+
+    double refPower = 0, errPower = 0, outPower = 0, cross = 0;
+    for (size_t i = 0; i < n; i++) {
+        double e = out[i] - ref[i];
+        double o = out[i] - meanOut, s = ref[i] - meanRef;
+        refPower += s * s;
+        errPower += e * e;
+        outPower += o * o;
+        cross += o * s;
+        if (fabs(e) > r.max_error) r.max_error = fabs(e);
+    }
+
+    // best gain for the reference in the output; what it can't explain is distortion plus noise
+    double gain = (refPower > 0) ? cross / refPower : 0;
+    double residual = 0;
+    for (size_t i = 0; i < n; i++) {
+        double d = (out[i] - meanOut) - gain * (ref[i] - meanRef);
+        residual += d * d;
+    }
+
+    r.snr_db = toDb(refPower, errPower);
+    r.thdn_db = toDb(residual, outPower);
+    return r;
+}
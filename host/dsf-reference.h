@@ -0,0 +1,36 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Double-Precision Reference Model (host)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Moorer's Equation 4 as `DsfOsc` evaluates it, but in double
+ * precision with exact sine/cosine, exact frequencies and no
+ * clamp on `a` (infinite or finite sum), plus the measurements
+ * used to compare a kernel's output against it.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+
+/*!
+    @brief how far a rendered signal is from the reference
+
+    @param snr_db reference power over error power (error = output - reference), in dB; includes gain, phase and
+           clipping errors
+    @param max_error largest absolute error, in DAC LSB
+    @param thdn_db THD+N: power left after removing the best least-squares fit of the reference (and DC) from the
+           output, relative to the output's AC power, in dB (more negative is better)
+*/
+typedef struct {
+    double snr_db, max_error, thdn_db;
+} dsf_accuracy_t;
+
+void dsfReference(double fn, double fm, double a, uint32_t sample_rate, uint8_t dac_bit_depth, double *out, size_t n,
+                  int32_t harmonics = -1);
+dsf_accuracy_t dsfAccuracy(const uint16_t *out, const double *ref, size_t n);
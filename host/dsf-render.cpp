@@ -0,0 +1,354 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Offline MIDI Renderer
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Renders a Standard MIDI File to WAV (or raw PCM) with the
+ * same synth the firmware runs: every track/channel gets its
+ * own `DsfSynth`, the parts are rendered in parallel on a
+ * thread pool, then mixed and normalised to full scale.
+ *
+ * Usage: dsf-render [options] input.mid output.wav
+ *        dsf-render --scl FILE [--kbm FILE] --write-tuning FILE
+ ************************************************************/
+
+/*
+ * C++ HEADERS
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <vector>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-synth.h"
+#include "dsf-smf.h"
+#include "dsf-host-sinks.h"
+#include "dsf-scala.h"
+
+/*
+ * RENDER SETTINGS
+ */
+#define RENDER_VOICES 4 // per part, as VOICES in the example
+#define RENDER_BLOCK 64 // samples between event checks and `service()` calls
+#define RENDER_DAC_BITS 15 // the widest code the pool's fix15 mapping holds without overflow
+#define RENDER_TAIL_MS 50 // extra silence after the last release
+
+/*!
+    @brief render options, set from the command line
+
+    @param fs sample rate in Hz
+    @param threads worker threads, 0 = one per core
+    @param mode Standard/Strange Mode, as the example's buttons and encoder set it
+    @param attack, decay, release envelope times in ms
+    @param sustain sustain level in percent
+    @param shape envelope segment shape
+    @param envInvert `true` sweeps `a` up with the envelope, `false` down
+    @param bendRange pitch bend range in semitones
+    @param glideMs legato portamento time in ms
+    @param tuned `true` to play `freq16` instead of equal temperament
+    @param freq16 note frequencies in Q16.16 Hz, from the Scala files
+*/
+typedef struct {
+    uint16_t fs;
+    unsigned threads;
+    dsf_note_mode_t mode;
+    uint32_t attack, decay, release, sustain;
+    dsf_env_shape_t shape;
+    bool envInvert;
+    uint8_t bendRange;
+    uint32_t glideMs;
+    bool tuned;
+    uint32_t freq16[128];
+} render_options_t;
+
+/*!
+    @brief a MIDI message at a sample position
+*/
+typedef struct {
+    size_t sample;
+    uint8_t command, data1, data2;
+} render_event_t;
+
+/*!
+    @brief the messages of one track/channel pair and its rendered audio, centred on 0
+*/
+typedef struct {
+    uint16_t track;
+    uint8_t channel;
+    std::vector<render_event_t> events;
+    std::vector<int16_t> audio;
+} render_part_t;
+
+/*!
+    @brief renders one part from start to `samples`, block by block, applying each message at its sample
+*/
+static void renderPart(render_part_t &part, size_t samples, const render_options_t &opt)
+{
+    // DsfSynth is about 4 KB, mostly tuning tables; one per part on this thread's stack
+    DsfSynth<RENDER_VOICES> synth(opt.fs, RENDER_DAC_BITS);
+    if (opt.tuned) synth.tuning.setFreqs(opt.freq16);
+    synth.env.setShape(opt.shape);
+    synth.env.setAttack(opt.attack);
+    synth.env.setDecay(opt.decay);
+    synth.env.setRelease(opt.release);
+    synth.env.setSustain((fix15)(opt.sustain * one15 / 100));
+    synth.setEnvInvert(opt.envInvert);
+    synth.setBendRange(opt.bendRange);
+    synth.voices.setGlideTime(opt.glideMs * opt.fs / 1000);
+
+    uint16_t block[RENDER_BLOCK];
+    part.audio.resize(samples);
+    size_t pos = 0, next = 0;
+
+    while (pos < samples) {
+        while (next < part.events.size() && part.events[next].sample <= pos) {
+            const render_event_t &e = part.events[next++];
+            synth.midi({ e.command, e.data1, e.data2 }, opt.mode);
+        }
+
+        size_t len = std::min<size_t>(RENDER_BLOCK, samples - pos);
+        if (next < part.events.size()) len = std::min(len, part.events[next].sample - pos);
+
+        synth.renderBlock(block, len);
+        synth.service();
+        for (size_t i = 0; i < len; i++) part.audio[pos + i] = (int16_t)((block[i] - (1 << (RENDER_DAC_BITS - 1))) * 2);
+        pos += len;
+    }
+}
+
+/*!
+    @brief renders every part on `threads` workers; each worker takes the next unrendered part until none are left
+*/
+static void renderParts(std::vector<render_part_t> &parts, size_t samples, const render_options_t &opt, unsigned threads)
+{
+    std::atomic<size_t> nextPart(0);
+    auto worker = [&]() {
+        for (size_t p = nextPart++; p < parts.size(); p = nextPart++) renderPart(parts[p], samples, opt);
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread &t : pool) t.join();
+}
+
+/*!
+    @brief groups the note, controller and bend messages by track and channel, converted to sample positions
+
+    Parts without a note-on are dropped.
+*/
+static std::vector<render_part_t> splitParts(const DsfSmf &smf, uint16_t fs)
+{
+    std::map<uint32_t, render_part_t> byKey;
+    for (const dsf_smf_event_t &e : smf.events()) {
+        uint8_t command = e.status & 0xF0;
+        if (command != 0x80 && command != 0x90 && command != 0xB0 && command != 0xE0) continue;
+        render_part_t &part = byKey[((uint32_t)e.track << 4) | (e.status & 0x0F)];
+        part.track = e.track;
+        part.channel = e.status & 0x0F;
+        part.events.push_back({ (size_t)llround(e.seconds * fs), command, e.data1, e.data2 });
+    }
+
+    std::vector<render_part_t> parts;
+    for (auto &kv : byKey) {
+        bool hasNotes = std::any_of(kv.second.events.begin(), kv.second.events.end(),
+                                    [](const render_event_t &e) { return e.command == 0x90 && e.data2 > 0; });
+        if (hasNotes) parts.push_back(std::move(kv.second));
+    }
+    return parts;
+}
+
+/*!
+    @brief sums the parts, normalises the peak to full scale and writes 16-bit codes through the sink
+*/
+static bool writeMix(const std::vector<render_part_t> &parts, size_t samples, DsfFileSink &sink)
+{
+    std::vector<int32_t> mix(samples, 0);
+    for (const render_part_t &part : parts) {
+        for (size_t i = 0; i < samples; i++) mix[i] += part.audio[i];
+    }
+
+    int64_t peak = 1;
+    for (int32_t s : mix) peak = std::max<int64_t>(peak, std::abs(s));
+
+    size_t pos = 0;
+    while (pos < samples) {
+        uint16_t *block = sink.acquire();
+        if (!block) return false;
+        for (size_t i = 0; i < sink.blockSize(); i++, pos++) {
+            int64_t s = (pos < samples) ? (int64_t)mix[pos] * 32767 / peak : 0;
+            block[i] = (uint16_t)(s + 32768);
+        }
+        sink.commit();
+    }
+    return true;
+}
+
+/*!
+    @brief writes the tuning as an MTS bulk dump (`.syx`) or a `DsfTuning` blob (anything else)
+*/
+static bool writeTuning(const char *path, const DsfScala &scala, const uint32_t freq16[128])
+{
+    uint8_t data[DSF_MTS_DUMP_SIZE > DSF_TUNING_BLOB_SIZE ? DSF_MTS_DUMP_SIZE : DSF_TUNING_BLOB_SIZE];
+    size_t len;
+    const char *ext = strrchr(path, '.');
+    if (ext && !strcmp(ext, ".syx")) {
+        scala.mtsDump(0, scala.description().c_str(), data);
+        len = DSF_MTS_DUMP_SIZE;
+    } else {
+        len = DsfTuning::writeBlob(freq16, data);
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = (fwrite(data, 1, len, f) == len);
+    return (fclose(f) == 0) && ok;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options] input.mid output.wav|output.raw\n"
+            "       %s --scl FILE [--kbm FILE] --write-tuning FILE\n"
+            "  --rate HZ          sample rate (default 40000)\n"
+            "  --threads N        worker threads (default: one per core)\n"
+            "  --strange K        Strange Mode with root strangeModeRoots[K], 0-7\n"
+            "  --inharmonic       Standard Mode modulator times root2\n"
+            "  --half             Standard Mode modulator at half the note (default double)\n"
+            "  --attack MS        envelope attack (default 100)\n"
+            "  --decay MS         envelope decay (default 300)\n"
+            "  --sustain PERCENT  envelope sustain level (default 70)\n"
+            "  --release MS       envelope release (default: the decay time, as on the board)\n"
+            "  --exponential      exponential envelope segments\n"
+            "  --env-down         envelope sweeps a down instead of up\n"
+            "  --bend-range SEMIS pitch bend range (default 2)\n"
+            "  --glide MS         legato glide time, 0 = off (default 60)\n"
+            "  --scl FILE         Scala scale to play in (default 12-tone equal temperament)\n"
+            "  --kbm FILE         Scala keyboard mapping for the scale (default: middle C on degree 0, A4 = 440 Hz)\n"
+            "  --write-tuning FILE  also write the tuning, as an MTS bulk dump if FILE ends in .syx, else a blob\n",
+            prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+    render_options_t opt = { 40000, 0, { false, 0, true, true }, 100, 300, 0, 70, env_linear, true, 2, 60 };
+    bool releaseSet = false;
+    const char *inPath = nullptr, *outPath = nullptr;
+    const char *sclPath = nullptr, *kbmPath = nullptr, *tuningPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "--rate") && hasValue) {
+            opt.fs = (uint16_t)strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--threads") && hasValue) {
+            opt.threads = strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--strange") && hasValue) {
+            opt.mode.strange = true;
+            opt.mode.strangeKey = (uint8_t)(strtoul(argv[++i], nullptr, 0) & 0x07);
+        } else if (!strcmp(argv[i], "--inharmonic")) {
+            opt.mode.harmonic = false;
+        } else if (!strcmp(argv[i], "--half")) {
+            opt.mode.mult = false;
+        } else if (!strcmp(argv[i], "--attack") && hasValue) {
+            opt.attack = strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--decay") && hasValue) {
+            opt.decay = strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--sustain") && hasValue) {
+            opt.sustain = std::min(100ul, strtoul(argv[++i], nullptr, 0));
+        } else if (!strcmp(argv[i], "--release") && hasValue) {
+            opt.release = strtoul(argv[++i], nullptr, 0);
+            releaseSet = true;
+        } else if (!strcmp(argv[i], "--exponential")) {
+            opt.shape = env_exponential;
+        } else if (!strcmp(argv[i], "--env-down")) {
+            opt.envInvert = false;
+        } else if (!strcmp(argv[i], "--bend-range") && hasValue) {
+            opt.bendRange = (uint8_t)strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--glide") && hasValue) {
+            opt.glideMs = strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--scl") && hasValue) {
+            sclPath = argv[++i];
+        } else if (!strcmp(argv[i], "--kbm") && hasValue) {
+            kbmPath = argv[++i];
+        } else if (!strcmp(argv[i], "--write-tuning") && hasValue) {
+            tuningPath = argv[++i];
+        } else if (argv[i][0] != '-' && !inPath) {
+            inPath = argv[i];
+        } else if (argv[i][0] != '-' && !outPath) {
+            outPath = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    bool tuningOnly = tuningPath && !inPath;
+    if ((!tuningOnly && (!inPath || !outPath)) || (tuningPath && !sclPath) || (kbmPath && !sclPath) || opt.fs < 8000) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!releaseSet) opt.release = opt.decay;
+
+    DsfScala scala;
+    if (sclPath) {
+        if (!scala.loadScl(sclPath)) {
+            fprintf(stderr, "%s: %s\n", sclPath, scala.error().c_str());
+            return 1;
+        }
+        if (kbmPath && !scala.loadKbm(kbmPath)) {
+            fprintf(stderr, "%s: %s\n", kbmPath, scala.error().c_str());
+            return 1;
+        }
+        scala.freqs16(opt.freq16);
+        opt.tuned = true;
+        printf("%s: %s, %zu degrees\n", sclPath, scala.description().c_str(), scala.degrees());
+    }
+    if (tuningPath) {
+        if (!writeTuning(tuningPath, scala, opt.freq16)) {
+            fprintf(stderr, "%s: write failed\n", tuningPath);
+            return 1;
+        }
+        printf("wrote tuning to %s\n", tuningPath);
+        if (tuningOnly) return 0;
+    }
+
+    DsfSmf smf;
+    if (!smf.load(inPath)) {
+        fprintf(stderr, "%s: %s\n", inPath, smf.error().c_str());
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<render_part_t> parts = splitParts(smf, opt.fs);
+    double seconds = smf.length() + (opt.release + opt.decay + RENDER_TAIL_MS) / 1000.0;
+    size_t samples = (size_t)ceil(seconds * opt.fs);
+
+    unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1u, std::min<unsigned>(threads, parts.size()));
+    renderParts(parts, samples, opt, threads);
+
+    const char *ext = strrchr(outPath, '.');
+    bool wav = !(ext && !strcmp(ext, ".raw"));
+    DsfFileSink sink(outPath, wav, opt.fs, 16, RENDER_BLOCK);
+    bool written = sink.ok() && writeMix(parts, samples, sink);
+    sink.close();
+    if (!written || !sink.ok()) {
+        fprintf(stderr, "%s: write failed\n", outPath);
+        return 1;
+    }
+
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    double audioSeconds = (double)samples / opt.fs;
+    printf("%s: format %u, %u tracks, %zu parts\n", inPath, smf.format(), smf.tracks(), parts.size());
+    printf("rendered %.2f s at %u Hz in %.1f ms on %u threads: %.1fx realtime\n", audioSeconds, opt.fs, wallMs, threads,
+           audioSeconds * 1000.0 / wallMs);
+    return 0;
+}
@@ -0,0 +1,182 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Trace Replay
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Runs the example's application loop (`DsfExampleApp`) on
+ * simulated hardware with the inputs of a trace recorded on
+ * the board, and checks that every block renders the DAC
+ * codes the board rendered. The first checksum that differs
+ * pins a divergence down to 16 blocks; `--out` writes the
+ * replayed audio to listen to.
+ *
+ * Usage: dsf-replay [options] trace.bin|console.log
+ ************************************************************/
+
+/*
+ * C++ HEADERS
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-example-app.h"
+#include "dsf-sim-hal.h"
+#include "dsf-host-sinks.h"
+
+/*!
+    @brief reads a trace: the binary `DsfTraceWriter` output, or the last `DSFTRACE` hex dump in a saved console log
+
+    @return `false` if the file can't be read or holds neither
+*/
+static bool readTrace(const char *path, std::vector<uint8_t> &trace)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    std::vector<uint8_t> file;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) file.insert(file.end(), buf, buf + n);
+    fclose(f);
+
+    if (file.size() >= 4 && !memcmp(file.data(), DSF_TRACE_MAGIC, 4)) {
+        trace = file;
+        return true;
+    }
+
+    std::string text(file.begin(), file.end());
+    size_t at = text.rfind("DSFTRACE ");
+    if (at == std::string::npos) return false;
+    size_t line = text.find('\n', at);
+    size_t end = text.find("END", line);
+    if (line == std::string::npos || end == std::string::npos) return false;
+
+    trace.clear();
+    int hi = -1;
+    for (size_t i = line; i < end; i++) {
+        char c = text[i];
+        int v = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (v < 0) continue;
+        if (hi < 0) {
+            hi = v;
+        } else {
+            trace.push_back((uint8_t)(hi << 4 | v));
+            hi = -1;
+        }
+    }
+    return true;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options] trace.bin|console.log\n"
+            "  --out FILE       write the replayed audio, as WAV unless FILE ends in .raw\n"
+            "  --blocks N       replay N blocks (default: up to the last checksum in the trace)\n"
+            "  --log            print the app's VERBOSE messages\n"
+            "  --profile        print the deadline statistics of the replay (host times)\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    const char *inPath = nullptr, *outPath = nullptr;
+    long blocks = -1;
+    bool log = false, profile = false;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "--out") && hasValue) {
+            outPath = argv[++i];
+        } else if (!strcmp(argv[i], "--blocks") && hasValue) {
+            blocks = strtol(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--log")) {
+            log = true;
+        } else if (!strcmp(argv[i], "--profile")) {
+            profile = true;
+        } else if (argv[i][0] != '-' && !inPath) {
+            inPath = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!inPath) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<uint8_t> trace;
+    if (!readTrace(inPath, trace)) {
+        fprintf(stderr, "%s: no trace found\n", inPath);
+        return 1;
+    }
+    DsfTraceReader reader(trace.data(), trace.size());
+    if (!reader.ok()) {
+        fprintf(stderr, "%s: not a version %d trace\n", inPath, DSF_TRACE_VERSION);
+        return 1;
+    }
+    const dsf_trace_info_t &info = reader.info();
+    if (info.sampleRate != SAMPLE_RATE || info.blockSize != SINK_BLOCK || info.dacBits != DAC_BIT_DEPTH ||
+        info.voices != VOICES) {
+        fprintf(stderr, "%s: recorded at %u Hz, %u-sample blocks, %u-bit DAC, %u voices; dsf-replay was built for "
+                "%u Hz, %u, %u, %u (dsf-example-config.h)\n", inPath, info.sampleRate, info.blockSize, info.dacBits,
+                info.voices, SAMPLE_RATE, SINK_BLOCK, DAC_BIT_DEPTH, VOICES);
+        return 1;
+    }
+
+    DsfSimHal<deadline_stages> hal(SAMPLE_RATE, SINK_BLOCK);
+    if (!hal.load(trace.data(), trace.size())) fprintf(stderr, "%s: malformed record, replaying what comes before it\n", inPath);
+    if (blocks < 0) blocks = hal.lastChecked() + 1;
+
+    DsfFileSink *file = nullptr;
+    if (outPath) {
+        const char *ext = strrchr(outPath, '.');
+        file = new DsfFileSink(outPath, !(ext && !strcmp(ext, ".raw")), SAMPLE_RATE, DAC_BIT_DEPTH, SINK_BLOCK);
+        hal.setOutput(file);
+    }
+
+    // about 30 KB, mostly the synth's tables and the wave cache
+    DsfExampleApp *app = new DsfExampleApp(hal);
+    app->setup();
+    app->start();
+
+    auto start = std::chrono::steady_clock::now();
+    char line[DSF_LOG_LINE + 1];
+    while (hal.blocks() < (uint32_t)blocks) {
+        app->loop();
+        while (log && app->verboseLog.format(line, sizeof(line))) printf("%s\n", line);
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    bool written = true;
+    if (file) {
+        file->close();
+        written = file->ok();
+        delete file;
+        if (!written) fprintf(stderr, "%s: write failed\n", outPath);
+    }
+
+    double seconds = (double)blocks * SINK_BLOCK / SAMPLE_RATE;
+    printf("%s: %zu bytes, replayed %ld blocks (%.2f s) in %.1f ms: %.1fx realtime\n", inPath, trace.size(), blocks,
+           seconds, wallMs, seconds * 1000.0 / wallMs);
+    if (hal.mismatches()) {
+        uint32_t from, to;
+        hal.firstMismatchBlocks(from, to);
+        printf("%u of %u checksums differ; the codes first differ in blocks %u-%u\n", hal.mismatches(), hal.checked(),
+               from, to);
+    } else {
+        printf("%u checksums match\n", hal.checked());
+    }
+    if (profile) hal.deadline.print(deadlineStageNames);
+
+    delete app;
+    return (hal.mismatches() || !written) ? 1 : 0;
+}
@@ -0,0 +1,290 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Scala Tuning Reader
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-scala.h"
+#include "dsf-tuning.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+/*!
+    @brief reads a whole text file
+
+    @return `false` if it can't be read
+*/
+static bool readText(const char *path, std::string &text)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    char chunk[4096];
+    size_t n;
+    text.clear();
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) text.append(chunk, n);
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+/*!
+    @brief the lines of a Scala file that aren't comments (`!` in the first column), without line endings
+*/
+static std::vector<std::string> dataLines(const std::string &text)
+{
+    std::vector<std::string> lines;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty() && line[0] == '!') continue;
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+/*!
+    @brief the first whitespace-separated token of `line`
+*/
+static std::string firstToken(const std::string &line)
+{
+    std::istringstream in(line);
+    std::string token;
+    in >> token;
+    return token;
+}
+
+/*!
+    @brief Constructor. Starts as 12-tone equal temperament with the default mapping.
+*/
+DsfScala::DsfScala()
+{
+    for (int i = 1; i <= 12; i++) cents.push_back(100.0 * i);
+}
+
+bool DsfScala::fail(const std::string &message)
+{
+    err = message;
+    return false;
+}
+
+/*!
+    @brief reads a `.scl` file, see `parseScl()`
+*/
+bool DsfScala::loadScl(const char *path)
+{
+    std::string text;
+    if (!readText(path, text)) return fail("can't read scale file");
+    return parseScl(text);
+}
+
+/*!
+    @brief parses a Scala scale: a description line, the number of degrees, then one pitch per degree, either in cents
+    (with a decimal point) or as a ratio (`3/2`, or an integer); the last degree is the period
+
+    @param text the file contents
+    @return `true` on success; on failure `error()` says why and the scale is unchanged
+*/
+bool DsfScala::parseScl(const std::string &text)
+{
+    std::vector<std::string> lines = dataLines(text);
+    if (lines.size() < 2) return fail("scale file too short");
+
+    char *end;
+    long count = strtol(firstToken(lines[1]).c_str(), &end, 10);
+    if (*end || count < 1) return fail("bad number of scale degrees");
+    if (lines.size() < 2 + (size_t)count) return fail("fewer pitches than scale degrees");
+
+    std::vector<double> degrees;
+    for (long i = 0; i < count; i++) {
+        std::string token = firstToken(lines[2 + i]);
+        double value;
+        if (token.find('.') != std::string::npos) {
+            value = strtod(token.c_str(), &end);
+            if (*end || token.empty()) return fail("bad pitch: " + token);
+        } else {
+            long num = strtol(token.c_str(), &end, 10), den = 1;
+            if (*end == '/') den = strtol(end + 1, &end, 10);
+            if (*end || token.empty() || num <= 0 || den <= 0) return fail("bad pitch: " + token);
+            value = 1200.0 * log2((double)num / (double)den);
+        }
+        degrees.push_back(value);
+    }
+    if (degrees.back() <= 0) return fail("the period must be above 1/1");
+
+    desc = lines[0];
+    cents = degrees;
+    return true;
+}
+
+/*!
+    @brief reads a `.kbm` file, see `parseKbm()`
+*/
+bool DsfScala::loadKbm(const char *path)
+{
+    std::string text;
+    if (!readText(path, text)) return fail("can't read keyboard mapping");
+    return parseKbm(text);
+}
+
+/*!
+    @brief parses a Scala keyboard mapping: pattern size, first and last key, middle key (scale degree 0), reference
+    key, reference frequency, the degree the pattern repeats at, then one degree (or `x`) per key of the pattern. A
+    size of 0 maps every key to the next degree.
+
+    @param text the file contents
+    @return `true` on success; on failure `error()` says why and the mapping is unchanged
+*/
+bool DsfScala::parseKbm(const std::string &text)
+{
+    std::vector<std::string> lines = dataLines(text);
+    if (lines.size() < 7) return fail("keyboard mapping too short");
+
+    long v[7];
+    double freqValue = 0;
+    for (int i = 0; i < 7; i++) {
+        std::string token = firstToken(lines[i]);
+        char *end;
+        if (i == 5) {
+            freqValue = strtod(token.c_str(), &end);
+            if (*end || token.empty() || freqValue <= 0) return fail("bad reference frequency");
+        } else {
+            v[i] = strtol(token.c_str(), &end, 10);
+            if (*end || token.empty() || v[i] < 0) return fail("bad keyboard mapping header");
+        }
+    }
+    if (v[1] > 127 || v[2] > 127 || v[3] > 127 || v[4] > 127) return fail("key out of range");
+    if (lines.size() < 7 + (size_t)v[0]) return fail("fewer keys than the mapping size");
+
+    std::vector<int32_t> keys;
+    for (long i = 0; i < v[0]; i++) {
+        std::string token = firstToken(lines[7 + i]);
+        if (token.empty() || token == "x" || token == "X") {
+            keys.push_back(-1);
+            continue;
+        }
+        char *end;
+        long degree = strtol(token.c_str(), &end, 10);
+        if (*end || degree < 0) return fail("bad mapping entry: " + token);
+        keys.push_back((int32_t)degree);
+    }
+
+    std::vector<int32_t> oldMapping = mapping;
+    int32_t oldMiddle = middleNote, oldOctave = octaveDegree;
+    mapping = keys;
+    middleNote = (int32_t)v[3];
+    octaveDegree = (int32_t)v[6];
+    int32_t degree;
+    if (!mapped((uint8_t)v[4], degree)) {
+        mapping = oldMapping;
+        middleNote = oldMiddle;
+        octaveDegree = oldOctave;
+        return fail("the reference key is not mapped");
+    }
+    firstNote = (int32_t)v[1];
+    lastNote = (int32_t)v[2];
+    refNote = (int32_t)v[4];
+    refFreq = freqValue;
+    return true;
+}
+
+/*!
+    @brief the scale degree the mapping gives `note`, ignoring the key range
+
+    @return `false` if the pattern leaves the key out
+*/
+bool DsfScala::mapped(uint8_t note, int32_t &degree) const
+{
+    int32_t i = (int32_t)note - middleNote;
+    if (mapping.empty()) {
+        degree = i;
+        return true;
+    }
+    int32_t m = (int32_t)mapping.size();
+    int32_t k = (i >= 0) ? i / m : -((-i + m - 1) / m); // floor division
+    int32_t key = mapping[i - k * m];
+    if (key < 0) return false;
+    degree = key + k * (octaveDegree ? octaveDegree : (int32_t)cents.size());
+    return true;
+}
+
+/*!
+    @return the pitch of scale degree `degree` above degree 0 in cents, repeating the scale every period
+*/
+double DsfScala::degreeCents(int32_t degree) const
+{
+    int32_t n = (int32_t)cents.size();
+    int32_t q = (degree >= 0) ? degree / n : -((-degree + n - 1) / n);
+    int32_t r = degree - q * n;
+    return q * cents.back() + (r ? cents[r - 1] : 0.0);
+}
+
+/*!
+    @return the frequency of `note` in Hz, 0 if the mapping leaves it out
+*/
+double DsfScala::freq(uint8_t note) const
+{
+    int32_t degree, refDegree = 0;
+    if ((int32_t)note < firstNote || (int32_t)note > lastNote || !mapped(note, degree)) return 0;
+    mapped((uint8_t)refNote, refDegree); // checked by parseKbm()
+    return refFreq * exp2((degreeCents(degree) - degreeCents(refDegree)) / 1200.0);
+}
+
+/*!
+    @brief the frequencies of all 128 notes in Q16.16 Hz, for `DsfTuning::setFreqs()` or `DsfTuning::writeBlob()`
+*/
+void DsfScala::freqs16(uint32_t freq16[128]) const
+{
+    for (int n = 0; n < 128; n++) {
+        double f = freq((uint8_t)n) * 65536.0 + 0.5;
+        freq16[n] = (f >= 4294967295.0) ? UINT32_MAX : (uint32_t)f;
+    }
+}
+
+/*!
+    @brief encodes the tuning as a MIDI Tuning Standard bulk dump (all-call device ID 7F), for `DsfTuning::loadMts()`
+
+    Notes the mapping leaves out are sent as `7F 7F 7F`, "no change"; pitches outside MIDI's range are clamped.
+
+    @param program tuning program number, 0-127
+    @param name up to 16 ASCII characters, padded with spaces
+    @param msg receives `DSF_MTS_DUMP_SIZE` bytes
+*/
+void DsfScala::mtsDump(uint8_t program, const char *name, uint8_t *msg) const
+{
+    msg[0] = 0xF0;
+    msg[1] = 0x7E;
+    msg[2] = 0x7F;
+    msg[3] = 0x08;
+    msg[4] = 0x01;
+    msg[5] = program & 0x7F;
+    size_t nameLen = strlen(name);
+    for (size_t i = 0; i < 16; i++) msg[6 + i] = (i < nameLen) ? (name[i] & 0x7F) : ' ';
+
+    uint8_t *p = msg + 22;
+    for (int n = 0; n < 128; n++, p += 3) {
+        double f = freq((uint8_t)n);
+        if (f <= 0) {
+            p[0] = p[1] = p[2] = 0x7F;
+            continue;
+        }
+        // semitones above note 0, in units of 1/16384 semitone; 7F 7F 7F is reserved, so the top is 7F 7F 7E
+        double semis = 69.0 + 12.0 * log2(f / 440.0);
+        long units = lround(semis * 16384.0);
+        if (units < 0) units = 0;
+        if (units > 128L * 16384 - 2) units = 128L * 16384 - 2;
+        p[0] = (uint8_t)(units >> 14);
+        p[1] = (uint8_t)((units >> 7) & 0x7F);
+        p[2] = (uint8_t)(units & 0x7F);
+    }
+
+    uint8_t sum = 0;
+    for (size_t i = 1; i < DSF_MTS_DUMP_SIZE - 2; i++) sum ^= msg[i];
+    msg[DSF_MTS_DUMP_SIZE - 2] = sum & 0x7F;
+    msg[DSF_MTS_DUMP_SIZE - 1] = 0xF7;
+}
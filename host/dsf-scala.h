@@ -0,0 +1,67 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Scala Tuning Reader
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Reads Scala scale (`.scl`) and keyboard mapping (`.kbm`)
+ * files and turns them into the 128 note frequencies
+ * `DsfTuning` takes, as a tuning blob for the firmware or as
+ * a MIDI Tuning Standard bulk dump to send to it.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*!
+    @brief A Scala scale with its keyboard mapping.
+
+    Without a `.kbm` the default mapping applies: each key is the next scale degree, with middle C (60) on degree 0 and
+    A4 (69) at 440 Hz. Notes the mapping leaves out (`x`, or outside its key range) get frequency 0 and stay silent.
+*/
+class DsfScala {
+
+    public:
+        DsfScala();
+        bool loadScl(const char *path);
+        bool parseScl(const std::string &text);
+        bool loadKbm(const char *path);
+        bool parseKbm(const std::string &text);
+        double freq(uint8_t note) const;
+        void freqs16(uint32_t freq16[128]) const;
+        void mtsDump(uint8_t program, const char *name, uint8_t *msg) const;
+
+        /*!
+            @return why the last load or parse failed
+        */
+        const std::string &error() const { return err; }
+
+        /*!
+            @return the scale's description line
+        */
+        const std::string &description() const { return desc; }
+
+        /*!
+            @return scale degrees per period (the period is the last degree, usually the octave)
+        */
+        size_t degrees() const { return cents.size(); }
+
+    private:
+        bool fail(const std::string &message);
+        double degreeCents(int32_t degree) const;
+        bool mapped(uint8_t note, int32_t &degree) const;
+
+        std::string err, desc;
+        std::vector<double> cents; // degrees 1..n; degree 0 is 0 cents
+        // keyboard mapping
+        std::vector<int32_t> mapping; // scale degree per key of the pattern, -1 for unmapped
+        int32_t firstNote = 0, lastNote = 127, middleNote = 60, refNote = 69, octaveDegree = 0;
+        double refFreq = 440.0;
+};
@@ -0,0 +1,77 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Simulated Round-Robin ADC (host)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Stands in for the RP2040 ADC + DMA ring used by the example
+ * so `DsfControls` can be exercised on the host: every call to
+ * `produce()` writes conversions into the ring the same way
+ * the DMA channel does, with the channel sequence and wrap of
+ * the real hardware.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-controls.h"
+
+/*!
+    @brief Round-robin ADC writing into a ring buffer.
+
+    Each channel reads a settable level plus uniform noise of `+/- noise` LSB from a fixed-seed generator, so runs are
+    repeatable.
+
+    @tparam CHANNELS number of channels in the round-robin sequence
+    @tparam RING ring length in samples
+*/
+template <uint8_t CHANNELS, uint16_t RING>
+class DsfSimAdc {
+
+    public:
+        explicit DsfSimAdc(uint16_t noise) : noise(noise)
+        {
+            for (uint8_t c = 0; c < CHANNELS; c++) level[c] = 0;
+            for (uint16_t i = 0; i < RING; i++) ring[i] = 0;
+        }
+
+        /*!
+            @brief sets the (noise-free) reading of `channel`, 0..`DSF_CTRL_MAX`
+        */
+        void set(uint8_t channel, uint16_t value) { level[channel] = value; }
+
+        /*!
+            @brief writes the next `n` conversions into the ring
+        */
+        void produce(size_t n)
+        {
+            for (size_t i = 0; i < n; i++) {
+                int32_t v = level[channel];
+                if (noise > 0) {
+                    seed = seed * 1664525u + 1013904223u;
+                    v += (int32_t)((seed >> 8) % (2u * noise + 1)) - noise;
+                }
+                if (v < 0) v = 0;
+                if (v > DSF_CTRL_MAX) v = DSF_CTRL_MAX;
+                ring[writePos] = (uint16_t)v;
+                writePos = (writePos + 1 == RING) ? 0 : writePos + 1;
+                channel = (channel + 1 == CHANNELS) ? 0 : channel + 1;
+            }
+        }
+
+        /*!
+            @return index of the next entry to be written, as read from the DMA write address on the device
+        */
+        uint16_t position() const { return writePos; }
+
+        volatile uint16_t ring[RING];
+
+    private:
+        uint16_t level[CHANNELS];
+        int32_t noise;
+        uint32_t seed = 12345;
+        uint16_t writePos = 0;
+        uint8_t channel = 0;
+};
@@ -0,0 +1,234 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Simulated Hardware (host)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * `DsfHal` for running an application loop on the host: a
+ * sample clock instead of the timer, GPIO outputs kept in a
+ * word, a sink that takes a set number of blocks per pass,
+ * inputs scheduled by block (by hand or from a trace) and the
+ * trace's DAC checksums compared as the blocks are rendered.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-hal.h"
+#include "dsf-trace.h"
+#include "dsf-host-clock.h"
+
+/*!
+    @brief Simulated hardware for an application loop.
+
+    Time is the sample clock: the DAC plays `lead` blocks behind the block being rendered, as if the loop always kept
+    the sink full, and `timeUs()` is that sample in microseconds. Each `poll()` (one per pass of the loop) lets the sink
+    take `setBlocksPerPass()` blocks, one by default. There is no second core, so `core1Start()` refuses and the loop renders every voice
+    itself, which gives the same codes as two cores.
+
+    Inputs are handed out by `pollInput()` before the block they are scheduled for. `load()` schedules the inputs of a
+    trace, replays its sample clock jumps and expects its checksums; `blockEnd()` compares each one after its block.
+
+    @tparam STAGES deadline stages of the application loop, timed with the host's clock
+*/
+template <uint8_t STAGES>
+class DsfSimHal : public DsfHal {
+
+    public:
+        DsfSimHal(uint32_t sample_rate, size_t block_size, uint32_t lead = 3)
+            : fs(sample_rate), leadSamples(lead * (uint32_t)block_size), sink(*this, block_size)
+        {
+            deadline.start((uint32_t)((uint64_t)dsf_chrono_clock_t::hz() * block_size / sample_rate));
+        }
+
+        uint64_t timeUs() override
+        {
+            uint32_t pos = sink.position();
+            return (pos > leadSamples) ? (uint64_t)(pos - leadSamples) * 1000000 / fs : 0;
+        }
+
+        void gpioPut(uint8_t pin, bool on) override { gpioMask(1u << pin, on); }
+        void gpioMask(uint32_t mask, bool on) override { gpio = on ? (gpio | mask) : (gpio & ~mask); }
+        DsfAudioSink &dac() override { return sink; }
+        void poll() override { sink.passBlocks = 0; }
+
+        bool pollInput(dsf_input_t &in) override
+        {
+            if (nextInput == inputs.size() || inputs[nextInput].block > sink.blocks()) return false;
+            scheduled_t &s = inputs[nextInput++];
+            in = s.in;
+            if (in.type == input_sysex) in.data = s.data.data();
+            return true;
+        }
+
+        void stageStart() override { deadline.stageStart(); }
+        void stageEnd(uint8_t stage) override { deadline.stageEnd(stage); }
+        void blockStart() override { deadline.blockStart(); }
+
+        /*!
+            @brief after each block: compares the trace's checksum, if there is one for this block
+        */
+        void blockEnd(int32_t slack) override
+        {
+            deadline.blockEnd(slack);
+            uint32_t block = sink.blocks() - 1;
+            auto it = checks.find(block);
+            if (it == checks.end()) return;
+            checkCount++;
+            if (sum.value() != it->second && mismatchCount++ == 0) {
+                firstMismatch = block;
+                firstMismatchFrom = checkedUpTo;
+            }
+            checkedUpTo = block + 1;
+            sum.reset();
+        }
+
+        /*!
+            @brief applies `in` before block `block`; inputs must be scheduled in block order. SysEx data is copied.
+        */
+        void schedule(uint32_t block, const dsf_input_t &in)
+        {
+            scheduled_t s = { block, in, {} };
+            if (in.type == input_sysex) {
+                s.data.assign(in.data, in.data + in.len);
+                s.in.data = nullptr;
+            }
+            inputs.push_back(s);
+        }
+
+        /*!
+            @brief makes block `block` play at sample `clock`, like a sink skipping ahead after an underrun
+        */
+        void jump(uint32_t block, uint32_t clock) { sink.jumps[block] = clock; }
+
+        /*!
+            @brief schedules a trace's inputs and clock jumps and expects its checksums
+
+            @return `false` if the trace is unreadable or malformed; the records before the bad one are loaded
+        */
+        bool load(const uint8_t *trace, size_t len)
+        {
+            DsfTraceReader reader(trace, len);
+            if (!reader.ok()) return false;
+            dsf_trace_record_t r;
+            while (reader.next(r)) {
+                if (r.kind == trace_check) {
+                    checks[r.block] = r.value;
+                    lastCheck = r.block;
+                } else if (r.kind == trace_position) {
+                    jump(r.block, r.value);
+                } else {
+                    schedule(r.block, r.in);
+                }
+            }
+            return !reader.malformed();
+        }
+
+        /*!
+            @brief sets the sink's blocks per `poll()`; 0 stops it taking blocks
+        */
+        void setBlocksPerPass(uint32_t n) { sink.perPass = n; }
+
+        /*!
+            @brief also passes every committed block on to `out` (e.g. a `DsfFileSink`) and/or appends it to `capture`
+        */
+        void setOutput(DsfAudioSink *out) { sink.out = out; }
+        void setCapture(std::vector<uint16_t> *capture) { sink.capture = capture; }
+
+        /*!
+            @return the GPIO outputs, one bit per pin
+        */
+        uint32_t pins() const { return gpio; }
+
+        /*!
+            @return blocks committed so far
+        */
+        uint32_t blocks() const { return sink.blocks(); }
+
+        /*!
+            @return the last block with an expected checksum, -1 if there is none
+        */
+        int64_t lastChecked() const { return lastCheck; }
+
+        uint32_t checked() const { return checkCount; }
+        uint32_t mismatches() const { return mismatchCount; }
+
+        /*!
+            @brief the first checksum that didn't match: the codes first differ somewhere in blocks `from..to`
+        */
+        void firstMismatchBlocks(uint32_t &from, uint32_t &to) const
+        {
+            from = firstMismatchFrom;
+            to = firstMismatch;
+        }
+
+        DsfDeadlineMonitor<dsf_chrono_clock_t, STAGES> deadline;
+
+    private:
+        typedef struct {
+            uint32_t block;
+            dsf_input_t in;
+            std::vector<uint8_t> data;
+        } scheduled_t;
+
+        /*!
+            @brief the simulated DAC: takes `perPass` blocks per pass, follows the clock jumps, sums the codes for the
+            checks
+        */
+        class SimSink : public DsfAudioSink {
+
+            public:
+                SimSink(DsfSimHal &owner, size_t block_size) : hal(owner), block(block_size) {}
+
+                uint16_t *acquire() override { return (passBlocks < perPass) ? block.data() : nullptr; }
+
+                void commit() override
+                {
+                    hal.sum.add(block.data(), block.size());
+                    if (capture) capture->insert(capture->end(), block.begin(), block.end());
+                    if (out) {
+                        if (uint16_t *b = out->acquire()) {
+                            memcpy(b, block.data(), block.size() * sizeof(uint16_t));
+                            out->commit();
+                        }
+                    }
+                    clock = position() + (uint32_t)block.size();
+                    passBlocks++;
+                    blockCount++;
+                }
+
+                size_t blockSize() const override { return block.size(); }
+
+                uint32_t position() const override
+                {
+                    auto it = jumps.find(blockCount);
+                    return (it != jumps.end()) ? it->second : clock;
+                }
+
+                DsfSimHal &hal;
+                std::vector<uint16_t> block;
+                std::map<uint32_t, uint32_t> jumps;
+                DsfAudioSink *out = nullptr;
+                std::vector<uint16_t> *capture = nullptr;
+                uint32_t clock = 0, passBlocks = 0, perPass = 1;
+        };
+
+        uint32_t fs, leadSamples, gpio = 0;
+        SimSink sink;
+        std::vector<scheduled_t> inputs;
+        size_t nextInput = 0;
+        std::map<uint32_t, uint32_t> checks;
+        DsfTraceSum sum;
+        int64_t lastCheck = -1;
+        uint32_t checkCount = 0, mismatchCount = 0, firstMismatch = 0, firstMismatchFrom = 0, checkedUpTo = 0;
+};
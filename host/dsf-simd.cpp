@@ -0,0 +1,334 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * SIMD Multi-Voice Renderer (host/offline)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-simd.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DSF_SIMD_X86 1
+#include <immintrin.h>
+// GCC 12's AVX-512 headers trip -Wmaybe-uninitialized on their own _mm512_undefined_*() placeholders
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#else
+#define DSF_SIMD_X86 0
+#endif
+
+#define DSF_SIMD_LANES 16 // widest path; voice arrays are padded to a multiple of this
+#define DSF_SIMD_MAX_DAC_BITS 12 // keeps the DAC scaling inside 32-bit lanes, see render()
+
+/*!
+    @brief Constructor.
+
+    @param sample_rate the sample rate in Hz
+    @param dac_bit_depth the number of bits in the DAC; the SIMD paths support up to 12, wider DACs use the scalar path
+    @param voices number of independent voices
+*/
+DsfSimdVoices::DsfSimdVoices(uint16_t sample_rate, uint8_t dac_bit_depth, size_t voices)
+{
+    fs = sample_rate;
+    stepScale = DsfOsc::phaseScale(fs);
+    halfDac = float2fix15(((float)((1 << dac_bit_depth) - 1) / 2.0));
+    halfDacInt = (1 << (dac_bit_depth - 1)) - 1;
+    count = voices;
+    padded = ((voices + DSF_SIMD_LANES - 1) / DSF_SIMD_LANES) * DSF_SIMD_LANES;
+
+    countNote.assign(padded, 0);
+    countMod.assign(padded, 0);
+    stepNote.assign(padded, 0);
+    stepMod.assign(padded, 0);
+    numScale.assign(padded, 0);
+    denBase.assign(padded, one15); // padding lanes divide by one, never by zero
+    twoA.assign(padded, 0);
+    for (size_t v = 0; v < count; v++) setA(v, param_a_min15);
+
+    path = simd_scalar;
+    if (dac_bit_depth <= DSF_SIMD_MAX_DAC_BITS) setIsa(detect());
+}
+
+/*!
+    @brief sets the carrier and modulation frequencies of one voice, same as `DsfOsc::freqs()`
+
+    @param voice voice index
+    @param freqNote the fixed-point frequency for the carrier
+    @param freqMod the fixed-point frequency for the modulator
+    @param reset resets the voice's frequency counters; defaults true
+*/
+void DsfSimdVoices::freqs(size_t voice, fix15 freqNote, fix15 freqMod, bool reset)
+{
+    if (voice >= count) return;
+    stepNote[voice] = DsfOsc::phaseStep(freqNote, stepScale);
+    stepMod[voice] = DsfOsc::phaseStep(freqMod, stepScale);
+    if (reset) {
+        countNote[voice] = 0;
+        countMod[voice] = 0;
+    }
+}
+
+/*!
+    @brief sets `a` for one voice and precomputes `1 - a^2`, `1 + a^2` and `2a` exactly as `DsfOsc` does
+
+    @param voice voice index
+    @param param_a the `a` term from Moorer's equation, clamped to `param_a_min15 <= a <= param_a_max15`
+*/
+void DsfSimdVoices::setA(size_t voice, fix15 param_a)
+{
+    if (voice >= count) return;
+    if (param_a > param_a_max15) param_a = param_a_max15;
+    if (param_a < param_a_min15) param_a = param_a_min15;
+    fix15 a_squared = multfix15(param_a, param_a);
+    numScale[voice] = one15 - a_squared;
+    denBase[voice] = one15 + a_squared;
+    twoA[voice] = multfix15(two15, param_a);
+}
+
+/*!
+    @return the widest render path this CPU supports
+*/
+dsf_simd_isa_t DsfSimdVoices::detect()
+{
+#if DSF_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return simd_avx512;
+    if (__builtin_cpu_supports("avx2")) return simd_avx2;
+    if (__builtin_cpu_supports("sse2")) return simd_sse2;
+#endif
+    return simd_scalar;
+}
+
+/*!
+    @return printable name of a render path
+*/
+const char *DsfSimdVoices::isaName(dsf_simd_isa_t isa)
+{
+    switch (isa)
+    {
+    case simd_sse2: return "sse2";
+    case simd_avx2: return "avx2";
+    case simd_avx512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+/*!
+    @brief forces a render path, e.g. to compare paths against each other
+
+    @param isa the requested path
+    @return false (and no change) if this CPU or the DAC bit depth does not support it
+*/
+bool DsfSimdVoices::setIsa(dsf_simd_isa_t isa)
+{
+    if (isa > detect()) return false;
+    if (isa != simd_scalar && halfDacInt > (1 << (DSF_SIMD_MAX_DAC_BITS - 1)) - 1) return false;
+    path = isa;
+    return true;
+}
+
+/*!
+    @brief renders `n` frames of all voices
+
+    Output is interleaved by voice: sample `i` of voice `v` is `out[i * voices() + v]`.
+
+    The DAC scaling `multfix15(sample, halfDac)` needs 64 bits in general, but `halfDac` is `(2^bits - 1) * 2^14`, so it
+    equals `sample * (2^(bits-1) - 1) + (sample >> 1)`, which fits a 32-bit lane for DACs up to 12 bits.
+
+    @param out caller-supplied buffer of at least `n * voices()` samples
+    @param n number of frames
+*/
+void DsfSimdVoices::render(uint16_t *out, size_t n)
+{
+    switch (path)
+    {
+    case simd_avx512: renderAvx512(out, n); break;
+    case simd_avx2: renderAvx2(out, n); break;
+    case simd_sse2: renderSse2(out, n); break;
+    default: renderScalar(out, n); break;
+    }
+}
+
+void DsfSimdVoices::renderScalar(uint16_t *out, size_t n)
+{
+    for (size_t v = 0; v < count; v++) {
+        uint32_t cNote = countNote[v], cMod = countMod[v];
+        for (size_t i = 0; i < n; i++) {
+            fix15 sample = divfix15(multfix15(numScale[v], DsfOsc::sine(cNote)),
+                                    (denBase[v] - multfix15(twoA[v], DsfOsc::cosine(cMod))));
+            fix15 dacValue = multfix15(sample, halfDac) + halfDac;
+            out[i * count + v] = (uint16_t)fix2int15(dacValue);
+            cNote += stepNote[v];
+            cMod += stepMod[v];
+        }
+        countNote[v] = cNote;
+        countMod[v] = cMod;
+    }
+}
+
+#if DSF_SIMD_X86
+
+/*!
+    @brief copies the valid lanes of one frame into the interleaved output
+*/
+static inline void storeLanes(uint16_t *out, const uint16_t *lanes, size_t first, size_t width, size_t count)
+{
+    size_t valid = (count - first < width) ? count - first : width;
+    memcpy(out + first, lanes, valid * sizeof(uint16_t));
+}
+
+/*!
+    @brief 32-bit low multiply for SSE2, which only has the unsigned 32x32->64 even-lane multiply
+*/
+__attribute__((target("sse2")))
+static inline __m128i mullo32(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+__attribute__((target("sse2")))
+void DsfSimdVoices::renderSse2(uint16_t *out, size_t n)
+{
+    const __m128i kHalfInt = _mm_set1_epi32(halfDacInt), kHalfDac = _mm_set1_epi32(halfDac);
+    const __m128i kQuarter = _mm_set1_epi32(DSF_QUARTER_PHASE);
+    const fix15 *table = DsfOsc::table_sine.v;
+    alignas(16) uint32_t idxNote[4], idxMod[4];
+    alignas(16) uint16_t lanes[8];
+
+    for (size_t v = 0; v < count; v += 4) {
+        __m128i cNote = _mm_loadu_si128((const __m128i *)&countNote[v]);
+        __m128i cMod = _mm_loadu_si128((const __m128i *)&countMod[v]);
+        const __m128i sNote = _mm_loadu_si128((const __m128i *)&stepNote[v]);
+        const __m128i sMod = _mm_loadu_si128((const __m128i *)&stepMod[v]);
+        const __m128i num = _mm_loadu_si128((const __m128i *)&numScale[v]);
+        const __m128i den = _mm_loadu_si128((const __m128i *)&denBase[v]);
+        const __m128i twoAv = _mm_loadu_si128((const __m128i *)&twoA[v]);
+
+        for (size_t i = 0; i < n; i++) {
+            _mm_store_si128((__m128i *)idxNote, _mm_srli_epi32(cNote, 24));
+            _mm_store_si128((__m128i *)idxMod, _mm_srli_epi32(_mm_add_epi32(cMod, kQuarter), 24));
+            __m128i sine = _mm_setr_epi32(table[idxNote[0]], table[idxNote[1]], table[idxNote[2]], table[idxNote[3]]);
+            __m128i cosine = _mm_setr_epi32(table[idxMod[0]], table[idxMod[1]], table[idxMod[2]], table[idxMod[3]]);
+
+            __m128i numerator = _mm_slli_epi32(_mm_srai_epi32(mullo32(num, sine), 15), 15);
+            __m128i denominator = _mm_sub_epi32(den, _mm_srai_epi32(mullo32(twoAv, cosine), 15));
+
+            __m128d qLo = _mm_div_pd(_mm_cvtepi32_pd(numerator), _mm_cvtepi32_pd(denominator));
+            __m128d qHi = _mm_div_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(numerator, _MM_SHUFFLE(1, 0, 3, 2))),
+                                     _mm_cvtepi32_pd(_mm_shuffle_epi32(denominator, _MM_SHUFFLE(1, 0, 3, 2))));
+            __m128i sample = _mm_unpacklo_epi64(_mm_cvttpd_epi32(qLo), _mm_cvttpd_epi32(qHi));
+
+            __m128i scaled = _mm_add_epi32(mullo32(sample, kHalfInt), _mm_srai_epi32(sample, 1));
+            __m128i code = _mm_srai_epi32(_mm_add_epi32(scaled, kHalfDac), 15);
+            code = _mm_srai_epi32(_mm_slli_epi32(code, 16), 16); // keep the low 16 bits, like the (uint16_t) cast
+            _mm_store_si128((__m128i *)lanes, _mm_packs_epi32(code, code));
+            storeLanes(out + i * count, lanes, v, 4, count);
+
+            cNote = _mm_add_epi32(cNote, sNote);
+            cMod = _mm_add_epi32(cMod, sMod);
+        }
+
+        _mm_storeu_si128((__m128i *)&countNote[v], cNote);
+        _mm_storeu_si128((__m128i *)&countMod[v], cMod);
+    }
+}
+
+__attribute__((target("avx2")))
+void DsfSimdVoices::renderAvx2(uint16_t *out, size_t n)
+{
+    const __m256i kHalfInt = _mm256_set1_epi32(halfDacInt), kHalfDac = _mm256_set1_epi32(halfDac);
+    const __m256i kQuarter = _mm256_set1_epi32(DSF_QUARTER_PHASE);
+    const int *table = DsfOsc::table_sine.v;
+    alignas(16) uint16_t lanes[8];
+
+    for (size_t v = 0; v < count; v += 8) {
+        __m256i cNote = _mm256_loadu_si256((const __m256i *)&countNote[v]);
+        __m256i cMod = _mm256_loadu_si256((const __m256i *)&countMod[v]);
+        const __m256i sNote = _mm256_loadu_si256((const __m256i *)&stepNote[v]);
+        const __m256i sMod = _mm256_loadu_si256((const __m256i *)&stepMod[v]);
+        const __m256i num = _mm256_loadu_si256((const __m256i *)&numScale[v]);
+        const __m256i den = _mm256_loadu_si256((const __m256i *)&denBase[v]);
+        const __m256i twoAv = _mm256_loadu_si256((const __m256i *)&twoA[v]);
+
+        for (size_t i = 0; i < n; i++) {
+            __m256i sine = _mm256_i32gather_epi32(table, _mm256_srli_epi32(cNote, 24), 4);
+            __m256i cosine = _mm256_i32gather_epi32(table, _mm256_srli_epi32(_mm256_add_epi32(cMod, kQuarter), 24), 4);
+
+            __m256i numerator = _mm256_slli_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(num, sine), 15), 15);
+            __m256i denominator = _mm256_sub_epi32(den, _mm256_srai_epi32(_mm256_mullo_epi32(twoAv, cosine), 15));
+
+            __m256d qLo = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(numerator)),
+                                        _mm256_cvtepi32_pd(_mm256_castsi256_si128(denominator)));
+            __m256d qHi = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(numerator, 1)),
+                                        _mm256_cvtepi32_pd(_mm256_extracti128_si256(denominator, 1)));
+            __m256i sample = _mm256_set_m128i(_mm256_cvttpd_epi32(qHi), _mm256_cvttpd_epi32(qLo));
+
+            __m256i scaled = _mm256_add_epi32(_mm256_mullo_epi32(sample, kHalfInt), _mm256_srai_epi32(sample, 1));
+            __m256i code = _mm256_srai_epi32(_mm256_add_epi32(scaled, kHalfDac), 15);
+            code = _mm256_srai_epi32(_mm256_slli_epi32(code, 16), 16);
+            _mm_store_si128((__m128i *)lanes, _mm_packs_epi32(_mm256_castsi256_si128(code), _mm256_extracti128_si256(code, 1)));
+            storeLanes(out + i * count, lanes, v, 8, count);
+
+            cNote = _mm256_add_epi32(cNote, sNote);
+            cMod = _mm256_add_epi32(cMod, sMod);
+        }
+
+        _mm256_storeu_si256((__m256i *)&countNote[v], cNote);
+        _mm256_storeu_si256((__m256i *)&countMod[v], cMod);
+    }
+}
+
+__attribute__((target("avx512f")))
+void DsfSimdVoices::renderAvx512(uint16_t *out, size_t n)
+{
+    const __m512i kHalfInt = _mm512_set1_epi32(halfDacInt), kHalfDac = _mm512_set1_epi32(halfDac);
+    const __m512i kQuarter = _mm512_set1_epi32(DSF_QUARTER_PHASE);
+    const int *table = DsfOsc::table_sine.v;
+    alignas(32) uint16_t lanes[16];
+
+    for (size_t v = 0; v < count; v += 16) {
+        __m512i cNote = _mm512_loadu_si512(&countNote[v]);
+        __m512i cMod = _mm512_loadu_si512(&countMod[v]);
+        const __m512i sNote = _mm512_loadu_si512(&stepNote[v]);
+        const __m512i sMod = _mm512_loadu_si512(&stepMod[v]);
+        const __m512i num = _mm512_loadu_si512(&numScale[v]);
+        const __m512i den = _mm512_loadu_si512(&denBase[v]);
+        const __m512i twoAv = _mm512_loadu_si512(&twoA[v]);
+
+        for (size_t i = 0; i < n; i++) {
+            __m512i sine = _mm512_i32gather_epi32(_mm512_srli_epi32(cNote, 24), table, 4);
+            __m512i cosine = _mm512_i32gather_epi32(_mm512_srli_epi32(_mm512_add_epi32(cMod, kQuarter), 24), table, 4);
+
+            __m512i numerator = _mm512_slli_epi32(_mm512_srai_epi32(_mm512_mullo_epi32(num, sine), 15), 15);
+            __m512i denominator = _mm512_sub_epi32(den, _mm512_srai_epi32(_mm512_mullo_epi32(twoAv, cosine), 15));
+
+            __m512d qLo = _mm512_div_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(numerator)),
+                                        _mm512_cvtepi32_pd(_mm512_castsi512_si256(denominator)));
+            __m512d qHi = _mm512_div_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(numerator, 1)),
+                                        _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(denominator, 1)));
+            __m512i sample = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvttpd_epi32(qLo)), _mm512_cvttpd_epi32(qHi), 1);
+
+            __m512i scaled = _mm512_add_epi32(_mm512_mullo_epi32(sample, kHalfInt), _mm512_srai_epi32(sample, 1));
+            __m512i code = _mm512_srai_epi32(_mm512_add_epi32(scaled, kHalfDac), 15);
+            _mm256_store_si256((__m256i *)lanes, _mm512_cvtepi32_epi16(code)); // truncating narrow == (uint16_t) cast
+            storeLanes(out + i * count, lanes, v, 16, count);
+
+            cNote = _mm512_add_epi32(cNote, sNote);
+            cMod = _mm512_add_epi32(cMod, sMod);
+        }
+
+        _mm512_storeu_si512(&countNote[v], cNote);
+        _mm512_storeu_si512(&countMod[v], cMod);
+    }
+}
+
+#else
+
+void DsfSimdVoices::renderSse2(uint16_t *out, size_t n) { renderScalar(out, n); }
+void DsfSimdVoices::renderAvx2(uint16_t *out, size_t n) { renderScalar(out, n); }
+void DsfSimdVoices::renderAvx512(uint16_t *out, size_t n) { renderScalar(out, n); }
+
+#endif
@@ -0,0 +1,193 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Standard MIDI File Reader
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-smf.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#define SMF_DEFAULT_TEMPO 500000 // µs per quarter note (120 bpm) until the first tempo event
+
+static uint32_t be32(const uint8_t *p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]; }
+static uint16_t be16(const uint8_t *p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+/*!
+    @brief reads a variable-length quantity (at most 4 bytes)
+
+    @return `false` if it runs past `end` or is longer than 4 bytes
+*/
+static bool readVlq(const uint8_t *&p, const uint8_t *end, uint32_t &value)
+{
+    value = 0;
+    for (int i = 0; i < 4; i++) {
+        if (p >= end) return false;
+        uint8_t b = *p++;
+        value = (value << 7) | (b & 0x7F);
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool DsfSmf::fail(const char *message)
+{
+    err = message;
+    return false;
+}
+
+/*!
+    @brief reads a MIDI file from disk, see `parse()`
+
+    @param path the `.mid` file
+    @return `true` on success; `error()` says why not
+*/
+bool DsfSmf::load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return fail("can't open file");
+
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + n);
+    bool readError = ferror(f);
+    fclose(f);
+    if (readError) return fail("read error");
+
+    return parse(data.data(), data.size());
+}
+
+/*!
+    @brief parses a whole MIDI file held in memory
+
+    @param data the file contents
+    @param size length of `data` in bytes
+    @return `true` on success; `error()` says why not
+*/
+bool DsfSmf::parse(const uint8_t *data, size_t size)
+{
+    list.clear();
+    tempos.clear();
+    err.clear();
+    endTick = 0;
+
+    if (size < 14 || be32(data) != 0x4D546864 || be32(data + 4) < 6) return fail("not a Standard MIDI File");
+    fileFormat = be16(data + 8);
+    trackCount = be16(data + 10);
+    division = be16(data + 12);
+    if (fileFormat > 1) return fail("only format 0 and 1 files are supported");
+    if (division == 0) return fail("invalid time division");
+
+    const uint8_t *p = data + 8 + be32(data + 4), *end = data + size;
+    uint16_t track = 0;
+    while (track < trackCount && end - p >= 8) {
+        uint32_t length = be32(p + 4);
+        bool isTrack = (be32(p) == 0x4D54726B);
+        p += 8;
+        if (length > (size_t)(end - p)) return fail("truncated chunk");
+        // unknown chunk types must be skipped
+        if (isTrack && !parseTrack(p, p + length, track++)) return false;
+        p += length;
+    }
+    if (track < trackCount) return fail("fewer tracks than the header says");
+
+    // merge the tracks; stable, so messages at the same tick keep their file order
+    std::stable_sort(list.begin(), list.end(),
+                     [](const dsf_smf_event_t &x, const dsf_smf_event_t &y) { return x.tick < y.tick; });
+    applyTempoMap();
+    return true;
+}
+
+/*!
+    @brief appends the channel messages of one `MTrk` chunk to the list and collects its tempo events
+*/
+bool DsfSmf::parseTrack(const uint8_t *p, const uint8_t *end, uint16_t track)
+{
+    uint32_t tick = 0;
+    uint8_t running = 0;
+
+    while (p < end) {
+        uint32_t delta;
+        if (!readVlq(p, end, delta)) return fail("bad delta time");
+        tick += delta;
+        if (p >= end) return fail("truncated event");
+
+        uint8_t status = *p;
+        if (status & 0x80) {
+            p++;
+        } else {
+            // running status: reuse the last channel status, this byte is data
+            if (!running) return fail("data byte without status");
+            status = running;
+        }
+
+        if (status == 0xFF) {
+            if (p >= end) return fail("truncated meta event");
+            uint8_t type = *p++;
+            uint32_t length;
+            if (!readVlq(p, end, length) || length > (size_t)(end - p)) return fail("truncated meta event");
+            if (type == 0x51 && length == 3) tempos.push_back({ tick, ((uint32_t)p[0] << 16) | (p[1] << 8) | p[2] });
+            p += length;
+            running = 0;
+            if (type == 0x2F) break;
+        } else if (status == 0xF0 || status == 0xF7) {
+            uint32_t length;
+            if (!readVlq(p, end, length) || length > (size_t)(end - p)) return fail("truncated SysEx");
+            p += length;
+            running = 0;
+        } else if (status >= 0xF0) {
+            return fail("system message in track");
+        } else {
+            uint8_t command = status & 0xF0;
+            size_t dataBytes = (command == 0xC0 || command == 0xD0) ? 1 : 2;
+            if ((size_t)(end - p) < dataBytes) return fail("truncated channel message");
+            dsf_smf_event_t e = { tick, 0.0, track, status, (uint8_t)(p[0] & 0x7F), 0 };
+            if (dataBytes == 2) e.data2 = p[1] & 0x7F;
+            list.push_back(e);
+            p += dataBytes;
+            running = status;
+        }
+    }
+
+    if (tick > endTick) endTick = tick;
+    return true;
+}
+
+/*!
+    @brief converts every tick to seconds
+
+    Tempo events apply to all tracks (format 1 keeps them in the first one). SMPTE-timed files have a fixed number of
+    ticks per second and ignore tempo.
+*/
+void DsfSmf::applyTempoMap()
+{
+    if (division & 0x8000) {
+        int fps = -(int8_t)(division >> 8);
+        double ticksPerSecond = (fps == 29 ? 29.97 : fps) * (division & 0xFF);
+        for (dsf_smf_event_t &e : list) e.seconds = e.tick / ticksPerSecond;
+        endSeconds = endTick / ticksPerSecond;
+        return;
+    }
+
+    std::stable_sort(tempos.begin(), tempos.end(), [](const tempo_t &x, const tempo_t &y) { return x.tick < y.tick; });
+
+    // walk events and tempo changes together: seconds = base + (tick - baseTick) * secondsPerTick
+    size_t t = 0;
+    uint32_t baseTick = 0;
+    double base = 0, secondsPerTick = SMF_DEFAULT_TEMPO * 1e-6 / division;
+    auto advance = [&](uint32_t tick) {
+        while (t < tempos.size() && tempos[t].tick <= tick) {
+            base += (tempos[t].tick - baseTick) * secondsPerTick;
+            baseTick = tempos[t].tick;
+            secondsPerTick = tempos[t].usPerQuarter * 1e-6 / division;
+            t++;
+        }
+        return base + (tick - baseTick) * secondsPerTick;
+    };
+
+    for (dsf_smf_event_t &e : list) e.seconds = advance(e.tick);
+    endSeconds = advance(endTick);
+}
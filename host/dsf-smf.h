@@ -0,0 +1,82 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Standard MIDI File Reader
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Loads format 0 and 1 Standard MIDI Files into one list of
+ * channel messages, timed in seconds through the file's
+ * tempo map. SysEx and meta events other than tempo are
+ * skipped.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*!
+    @brief one channel message from a MIDI file
+
+    @param tick absolute time in file ticks
+    @param seconds absolute time in seconds, from the tempo map
+    @param track index of the `MTrk` chunk the message came from
+    @param status status byte (command in the high nibble, channel in the low nibble)
+    @param data1 first data byte (note, controller, bend LSB)
+    @param data2 second data byte (velocity, value, bend MSB), 0 for one-byte messages
+*/
+typedef struct {
+    uint32_t tick;
+    double seconds;
+    uint16_t track;
+    uint8_t status, data1, data2;
+} dsf_smf_event_t;
+
+/*!
+    @brief Standard MIDI File contents, flattened to time-ordered channel messages.
+*/
+class DsfSmf {
+
+    public:
+        bool load(const char *path);
+        bool parse(const uint8_t *data, size_t size);
+
+        /*!
+            @return why the last `load()` or `parse()` failed
+        */
+        const std::string &error() const { return err; }
+
+        /*!
+            @return channel messages of every track, ordered by time (file order within a tick)
+        */
+        const std::vector<dsf_smf_event_t> &events() const { return list; }
+
+        uint16_t format() const { return fileFormat; }
+        uint16_t tracks() const { return trackCount; }
+
+        /*!
+            @return time of the last event of any kind (including end of track), in seconds
+        */
+        double length() const { return endSeconds; }
+
+    private:
+        typedef struct {
+            uint32_t tick, usPerQuarter;
+        } tempo_t;
+
+        bool fail(const char *message);
+        bool parseTrack(const uint8_t *p, const uint8_t *end, uint16_t track);
+        void applyTempoMap();
+
+        std::vector<dsf_smf_event_t> list;
+        std::vector<tempo_t> tempos;
+        std::string err;
+        uint32_t endTick = 0;
+        double endSeconds = 0;
+        uint16_t fileFormat = 0, trackCount = 0, division = 0;
+};
@@ -0,0 +1,106 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Power Spectrum (host)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ ************************************************************/
+
+#include "dsf-spectrum.h"
+
+#include <cmath>
+
+/*!
+    @brief builds the window, the twiddle factors and the bit-reversal order for `n` samples
+
+    @param n burst length, a power of two (at least 4)
+*/
+DsfSpectrum::DsfSpectrum(size_t n) : n(n), window(n), twiddleRe(n / 2), twiddleIm(n / 2), re(n / 2), im(n / 2),
+                                     pw(n / 2 + 1), reverse(n / 2)
+{
+    for (size_t i = 0; i < n; i++) window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * (double)i / (double)n));
+
+    // e^(-2πik/n) for k < n/2: the half-size FFT uses the even entries, the separation step all of them
+    for (size_t k = 0; k < n / 2; k++) {
+        twiddleRe[k] = (float)cos(2.0 * M_PI * (double)k / (double)n);
+        twiddleIm[k] = (float)-sin(2.0 * M_PI * (double)k / (double)n);
+    }
+
+    size_t half = n / 2, bits = 0;
+    while (((size_t)1 << bits) < half) bits++;
+    for (size_t i = 0; i < half; i++) {
+        uint32_t r = 0;
+        for (size_t b = 0; b < bits; b++) r |= (uint32_t)((i >> b) & 1) << (bits - 1 - b);
+        reverse[i] = r;
+    }
+}
+
+/*!
+    @brief iterative radix-2 FFT of `re`/`im` (`n / 2` points, already in bit-reversed order)
+*/
+void DsfSpectrum::transform()
+{
+    size_t half = n / 2;
+    for (size_t len = 2; len <= half; len <<= 1) {
+        size_t step = n / len; // index into the size-n twiddles
+        for (size_t start = 0; start < half; start += len) {
+            for (size_t j = 0; j < len / 2; j++) {
+                float wr = twiddleRe[j * step], wi = twiddleIm[j * step];
+                size_t p = start + j, q = p + len / 2;
+                float tr = re[q] * wr - im[q] * wi;
+                float ti = re[q] * wi + im[q] * wr;
+                re[q] = re[p] - tr;
+                im[q] = im[p] - ti;
+                re[p] += tr;
+                im[p] += ti;
+            }
+        }
+    }
+}
+
+/*!
+    @brief the power spectrum of a burst
+
+    The mean is removed before the Hann window, so the DAC's mid-scale offset doesn't leak into the low bins.
+
+    @param codes `size()` DAC codes
+    @return `bins()` values, `|X[k]|^2` for bin `k` (DC to Nyquist); valid until the next call
+*/
+const float *DsfSpectrum::power(const uint16_t *codes)
+{
+    double mean = 0;
+    for (size_t i = 0; i < n; i++) mean += codes[i];
+    float m = (float)(mean / (double)n);
+
+    size_t half = n / 2;
+    for (size_t i = 0; i < half; i++) {
+        size_t j = reverse[i];
+        re[j] = ((float)codes[2 * i] - m) * window[2 * i];
+        im[j] = ((float)codes[2 * i + 1] - m) * window[2 * i + 1];
+    }
+    transform();
+
+    // X[k] = (Z[k] + Z*[half - k]) / 2 - i e^(-2πik/n) (Z[k] - Z*[half - k]) / 2
+    for (size_t k = 0; k <= half; k++) {
+        size_t a = k % half, b = (half - k) % half;
+        float evenRe = (re[a] + re[b]) * 0.5f, evenIm = (im[a] - im[b]) * 0.5f;
+        float oddRe = (im[a] + im[b]) * 0.5f, oddIm = (re[b] - re[a]) * 0.5f;
+        float wr = (k < half) ? twiddleRe[k] : -1.0f, wi = (k < half) ? twiddleIm[k] : 0.0f;
+        float xr = evenRe + oddRe * wr - oddIm * wi;
+        float xi = evenIm + oddRe * wi + oddIm * wr;
+        pw[k] = xr * xr + xi * xi;
+    }
+    return pw.data();
+}
+
+/*!
+    @return the power-weighted mean frequency of the last `power()` in Hz, DC bin excluded; 0 for a silent burst
+*/
+double DsfSpectrum::centroid(double sample_rate) const
+{
+    double sum = 0, weighted = 0;
+    for (size_t k = 1; k <= n / 2; k++) {
+        sum += pw[k];
+        weighted += pw[k] * (double)k;
+    }
+    return (sum > 0) ? weighted / sum * sample_rate / (double)n : 0.0;
+}
@@ -0,0 +1,49 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Power Spectrum (host)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * A radix-2 FFT of a burst of DAC codes, Hann-windowed with
+ * the mean removed, and the spectral centroid of the result.
+ * The tables are built once per size, so one instance per
+ * thread measures any number of bursts without allocating.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*!
+    @brief Power spectrum of `n` real samples (`n` a power of two, at least 4).
+
+    The real input is packed into `n / 2` complex values, transformed in place and separated again, which halves the
+    work of a complex FFT of size `n`. Single precision is plenty for levels and centroids of 12- to 16-bit codes.
+*/
+class DsfSpectrum {
+
+    public:
+        explicit DsfSpectrum(size_t n);
+
+        const float *power(const uint16_t *codes);
+        double centroid(double sample_rate) const;
+
+        size_t size() const { return n; }
+
+        /*!
+            @return the number of bins `power()` returns, `n / 2 + 1` (DC to Nyquist)
+        */
+        size_t bins() const { return n / 2 + 1; }
+
+    private:
+        void transform();
+
+        size_t n;
+        std::vector<float> window, twiddleRe, twiddleIm, re, im, pw;
+        std::vector<uint32_t> reverse;
+};
@@ -0,0 +1,148 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Work-Stealing Thread Pool (host)
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Runs a function over an index range on all cores. Each
+ * worker starts with an equal share and takes small chunks
+ * from the front of it; a worker that runs out steals the
+ * back half of the largest share left, so uneven work (a
+ * slow corner of a parameter grid) still keeps every core
+ * busy until the end.
+ ************************************************************/
+
+#pragma once
+
+/*
+ * C++ HEADERS
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*!
+    @brief Work-stealing pool for loops over `0..n-1`.
+
+    A worker's share is one 64-bit atomic holding `begin` (low half) and `end` (high half), so the owner taking a chunk
+    from the front and a thief cutting off the back are both a single compare-and-swap on the same word and can't hand
+    out an index twice. Stolen work becomes the thief's share, so it can be stolen again. A worker stops when it finds
+    every share empty; work that is in flight between two shares always belongs to a worker that is still running.
+
+    `run()` calls `work(begin, end, worker)` for consecutive chunks of at most `grain` indices, `worker` being
+    `0..threads()-1`, so the caller can keep scratch state per worker. The calling thread is worker 0.
+*/
+class DsfStealPool {
+
+    public:
+        /*!
+            @param threads worker count, 0 = one per core
+        */
+        explicit DsfStealPool(unsigned threads = 0)
+            : count(threads ? threads : (std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1)),
+              shares(new share_t[count])
+        {
+        }
+
+        unsigned threads() const { return count; }
+
+        /*!
+            @return shares stolen during the last `run()`
+        */
+        uint64_t steals() const { return stolen.load(std::memory_order_relaxed); }
+
+        /*!
+            @brief calls `work` for every index below `n` (at most 2^32 - 1) and returns when all are done
+
+            @param n the number of indices
+            @param grain the most indices per call of `work`
+            @param work `void(size_t begin, size_t end, unsigned worker)`
+        */
+        template <class F>
+        void run(size_t n, size_t grain, F work)
+        {
+            if (grain == 0) grain = 1;
+            for (unsigned w = 0; w < count; w++) shares[w].range.store(pack(n * w / count, n * (w + 1) / count));
+            stolen.store(0, std::memory_order_relaxed);
+
+            auto worker = [&](unsigned w) {
+                for (;;) {
+                    size_t begin, end;
+                    if (take(w, grain, begin, end)) work(begin, end, w);
+                    else if (!steal(w, grain)) break;
+                }
+            };
+
+            std::vector<std::thread> pool;
+            for (unsigned w = 1; w < count; w++) pool.emplace_back(worker, w);
+            worker(0);
+            for (std::thread &t : pool) t.join();
+        }
+
+    private:
+        // a share on its own cache line, so owners taking chunks don't contend with each other
+        typedef struct alignas(64) {
+            std::atomic<uint64_t> range;
+        } share_t;
+
+        static uint64_t pack(size_t begin, size_t end) { return (uint64_t)begin | ((uint64_t)end << 32); }
+        static size_t first(uint64_t r) { return (size_t)(uint32_t)r; }
+        static size_t last(uint64_t r) { return (size_t)(r >> 32); }
+
+        /*!
+            @brief takes up to `grain` indices from the front of worker `w`'s own share
+
+            @return `false` if the share is empty
+        */
+        bool take(unsigned w, size_t grain, size_t &begin, size_t &end)
+        {
+            std::atomic<uint64_t> &range = shares[w].range;
+            uint64_t r = range.load(std::memory_order_acquire);
+            while (first(r) < last(r)) {
+                begin = first(r);
+                end = (last(r) - begin > grain) ? begin + grain : last(r);
+                if (range.compare_exchange_weak(r, pack(end, last(r)), std::memory_order_acq_rel)) return true;
+            }
+            return false;
+        }
+
+        /*!
+            @brief moves the back half of the largest other share (all of it if that is no more than `grain`) into
+            worker `w`'s own share
+
+            @return `false` if every share was empty
+        */
+        bool steal(unsigned w, size_t grain)
+        {
+            for (;;) {
+                unsigned victim = w;
+                size_t most = 0;
+                for (unsigned i = 1; i < count; i++) {
+                    unsigned v = (w + i) % count;
+                    uint64_t r = shares[v].range.load(std::memory_order_relaxed);
+                    if (last(r) > first(r) && last(r) - first(r) > most) {
+                        most = last(r) - first(r);
+                        victim = v;
+                    }
+                }
+                if (victim == w) return false;
+
+                std::atomic<uint64_t> &range = shares[victim].range;
+                uint64_t r = range.load(std::memory_order_acquire);
+                if (first(r) >= last(r)) continue;
+                size_t size = last(r) - first(r);
+                size_t cut = (size <= grain) ? first(r) : last(r) - size / 2;
+                if (!range.compare_exchange_strong(r, pack(first(r), cut), std::memory_order_acq_rel)) continue;
+                shares[w].range.store(pack(cut, last(r)), std::memory_order_release);
+                stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        const unsigned count;
+        std::unique_ptr<share_t[]> shares;
+        std::atomic<uint64_t> stolen{ 0 };
+};
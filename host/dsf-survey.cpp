@@ -0,0 +1,237 @@
+/************************************************************
+ * Discrete Summation Formula Oscillator
+ * Parameter Survey
+ *
+ * https://github.com/rabbiabe/dsf-oscillator-pico
+ *
+ * Sweeps a grid of carrier frequencies, modulator ratios and
+ * `a` values through `DsfOsc` on every core and writes what
+ * each point sounds like (`DsfProbe`: spectral centroid,
+ * folded-back aliasing, peak against the DAC range) to a
+ * columnar results file, for choosing `a` ranges and ratios
+ * by the numbers rather than by ear.
+ *
+ * Usage: dsf-survey [options] results.dsfs|results.csv
+ ************************************************************/
+
+/*
+ * C++ HEADERS
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/*
+ * PROJECT HEADERS
+ */
+#include "dsf-probe.h"
+#include "dsf-steal-pool.h"
+
+/*
+ * SURVEY SETTINGS
+ */
+#define SURVEY_DAC_BITS 12 // as DAC_BIT_DEPTH in the example
+#define SURVEY_GRAIN 64 // points per chunk a worker takes from its share
+#define SURVEY_MAGIC "DSFS"
+#define SURVEY_VERSION 1
+#define SURVEY_NAME_LEN 16 // bytes per column name in the file header
+
+/*!
+    @brief one axis of the grid: `steps` values from `min` to `max`, spaced logarithmically or linearly
+*/
+typedef struct {
+    float min, max;
+    uint32_t steps;
+    bool log;
+} survey_axis_t;
+
+/*!
+    @brief the columns of the results file, in file order
+*/
+enum survey_column_t : uint8_t
+{
+    col_fn,
+    col_ratio,
+    col_a,
+    col_centroid,
+    col_alias,
+    col_peak,
+    col_wrap,
+    survey_columns
+};
+
+static const char *const columnNames[survey_columns] = { "fn", "ratio", "a", "centroid_hz", "alias_db", "peak_db",
+                                                         "wrap" };
+
+/*!
+    @brief the header of a results file, followed by `columns` names of `SURVEY_NAME_LEN` bytes (NUL-padded) and
+    then each column as `points` little-endian float32 values
+
+    Points are in grid order with `a` varying fastest: point `(f * steps[1] + r) * steps[2] + k` is carrier step `f`,
+    ratio step `r` and `a` step `k`, so a column reshapes to `[steps[0]][steps[1]][steps[2]]`.
+*/
+typedef struct {
+    char magic[4];
+    uint16_t version, columns;
+    uint32_t points, sampleRate, samples;
+    uint32_t steps[3]; // fn, ratio, a
+} survey_header_t;
+
+static float axisValue(const survey_axis_t &ax, uint32_t i)
+{
+    if (ax.steps < 2) return ax.min;
+    double t = (double)i / (double)(ax.steps - 1);
+    return (float)(ax.log ? ax.min * pow((double)ax.max / ax.min, t) : ax.min + (ax.max - ax.min) * t);
+}
+
+/*!
+    @brief parses `MIN,MAX,STEPS` into `ax`
+
+    @return `false` if malformed or out of `lo..hi`
+*/
+static bool parseAxis(const char *s, survey_axis_t &ax, float lo, float hi)
+{
+    float min, max;
+    unsigned steps;
+    if (sscanf(s, "%f,%f,%u", &min, &max, &steps) != 3) return false;
+    if (steps == 0 || min < lo || max > hi || max < min) return false;
+    ax.min = min;
+    ax.max = max;
+    ax.steps = steps;
+    return true;
+}
+
+static bool writeColumns(const char *path, const survey_header_t &h, const std::vector<float> *cols)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = (fwrite(&h, sizeof(h), 1, f) == 1);
+    for (uint8_t c = 0; c < survey_columns; c++) {
+        char name[SURVEY_NAME_LEN] = {};
+        strncpy(name, columnNames[c], sizeof(name) - 1);
+        ok = ok && (fwrite(name, sizeof(name), 1, f) == 1);
+    }
+    for (uint8_t c = 0; c < survey_columns; c++) ok = ok && (fwrite(cols[c].data(), sizeof(float), h.points, f) == h.points);
+    return (fclose(f) == 0) && ok;
+}
+
+static bool writeCsv(const char *path, uint32_t points, const std::vector<float> *cols)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    for (uint8_t c = 0; c < survey_columns; c++) fprintf(f, "%s%c", columnNames[c], (c + 1 < survey_columns) ? ',' : '\n');
+    for (uint32_t i = 0; i < points; i++) {
+        for (uint8_t c = 0; c < survey_columns; c++) fprintf(f, "%.6g%c", cols[c][i], (c + 1 < survey_columns) ? ',' : '\n');
+    }
+    bool ok = !ferror(f);
+    return (fclose(f) == 0) && ok;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options] results.dsfs|results.csv\n"
+            "  --fn MIN,MAX,STEPS     carrier frequencies in Hz below Nyquist, log-spaced (default 27.5,4186,100)\n"
+            "  --ratio MIN,MAX,STEPS  modulator/carrier ratios, log-spaced (default 0.25,4,100)\n"
+            "  --a MIN,MAX,STEPS      a values, linear, within the 0.1-0.9 clamp (default 0.1,0.9,100)\n"
+            "  --samples N            samples per burst, a power of two (default 1024)\n"
+            "  --rate HZ              sample rate (default 40000)\n"
+            "  --threads N            worker threads (default: one per core)\n"
+            "Writes a columnar float32 file, or CSV when the name ends in .csv.\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    survey_axis_t fnAxis = { 27.5f, 4186.0f, 100, true }, ratioAxis = { 0.25f, 4.0f, 100, true },
+                  aAxis = { 0.1f, 0.9f, 100, false };
+    unsigned long samples = 1024, fs = 40000;
+    unsigned threads = 0;
+    const char *outPath = nullptr;
+    bool ok = true;
+
+    for (int i = 1; i < argc && ok; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "--fn") && hasValue) {
+            ok = parseAxis(argv[++i], fnAxis, 1.0f, 20000.0f);
+        } else if (!strcmp(argv[i], "--ratio") && hasValue) {
+            ok = parseAxis(argv[++i], ratioAxis, 0.01f, 100.0f);
+        } else if (!strcmp(argv[i], "--a") && hasValue) {
+            ok = parseAxis(argv[++i], aAxis, fix2float15(param_a_min15), fix2float15(param_a_max15) + 1e-4f);
+        } else if (!strcmp(argv[i], "--samples") && hasValue) {
+            samples = strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--rate") && hasValue) {
+            fs = strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--threads") && hasValue) {
+            threads = strtoul(argv[++i], nullptr, 0);
+        } else if (argv[i][0] != '-' && !outPath) {
+            outPath = argv[i];
+        } else {
+            ok = false;
+        }
+    }
+    uint64_t points = (uint64_t)fnAxis.steps * ratioAxis.steps * aAxis.steps;
+    // carriers below Nyquist, and fm must fit fix15 (below 65536 Hz)
+    if (!ok || !outPath || samples < 4 || (samples & (samples - 1)) || fs < 8000 || fs > 65535 ||
+        fnAxis.max >= fs / 2.0f || fnAxis.max * ratioAxis.max >= 65535.0f || points >= UINT32_MAX) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<float> cols[survey_columns];
+    for (std::vector<float> &c : cols) c.resize(points);
+
+    DsfStealPool pool(threads);
+    std::vector<std::unique_ptr<DsfProbe>> probes;
+    for (unsigned w = 0; w < pool.threads(); w++) probes.emplace_back(new DsfProbe((uint16_t)fs, SURVEY_DAC_BITS, samples));
+
+    auto start = std::chrono::steady_clock::now();
+    pool.run(points, SURVEY_GRAIN, [&](size_t begin, size_t end, unsigned worker) {
+        DsfProbe &probe = *probes[worker];
+        for (size_t i = begin; i < end; i++) {
+            uint32_t k = i % aAxis.steps, r = (i / aAxis.steps) % ratioAxis.steps;
+            uint32_t f = (uint32_t)(i / ((uint64_t)aAxis.steps * ratioAxis.steps));
+            float fn = axisValue(fnAxis, f), ratio = axisValue(ratioAxis, r), a = axisValue(aAxis, k);
+            dsf_probe_t m = probe.measure(fn, fn * ratio, a);
+            cols[col_fn][i] = fn;
+            cols[col_ratio][i] = ratio;
+            cols[col_a][i] = a;
+            cols[col_centroid][i] = m.centroid;
+            cols[col_alias][i] = m.alias_db;
+            cols[col_peak][i] = m.peak_db;
+            cols[col_wrap][i] = m.wrap;
+        }
+    });
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const char *ext = strrchr(outPath, '.');
+    bool written;
+    if (ext && !strcmp(ext, ".csv")) {
+        written = writeCsv(outPath, (uint32_t)points, cols);
+    } else {
+        survey_header_t h = { {}, SURVEY_VERSION, survey_columns, (uint32_t)points, (uint32_t)fs, (uint32_t)samples,
+                              { fnAxis.steps, ratioAxis.steps, aAxis.steps } };
+        memcpy(h.magic, SURVEY_MAGIC, sizeof(h.magic));
+        written = writeColumns(outPath, h, cols);
+    }
+    if (!written) {
+        fprintf(stderr, "%s: write failed\n", outPath);
+        return 1;
+    }
+
+    uint32_t wrapping = 0, aliasing = 0;
+    for (uint32_t i = 0; i < points; i++) {
+        if (cols[col_wrap][i] > 0) wrapping++;
+        if (cols[col_alias][i] > -40.0f) aliasing++;
+    }
+    double seconds = (double)points * samples / fs;
+    printf("surveyed %llu points (%lu-sample bursts) in %.1f ms on %u threads, %llu steals: %.0f points/s, %.1fx realtime\n",
+           (unsigned long long)points, samples, wallMs, pool.threads(), (unsigned long long)pool.steals(),
+           points * 1000.0 / wallMs, seconds * 1000.0 / wallMs);
+    printf("%.1f%% of points wrap, %.1f%% alias above -40 dB\n", 100.0 * wrapping / points, 100.0 * aliasing / points);
+    return 0;
+}
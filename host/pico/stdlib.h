@@ -0,0 +1,17 @@
+/************************************************************
+ * Host stand-in for pico/stdlib.h
+ * 
+ * Provides the handful of Pico SDK types and helpers that the
+ * oscillator library uses so it can be built and measured on
+ * a Linux host. Only what the library needs lives here; the
+ * example firmware still requires the real SDK.
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+typedef unsigned int uint;
+
+static inline void tight_loop_contents() {}
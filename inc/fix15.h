@@ -1,3 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
 /****************************************
  * Macros for fixed-point arithmetic 
  * (faster than floating point)
@@ -17,3 +21,44 @@ typedef signed int fix15 ;
 #define char2fix15(a) (fix15)(((fix15)(a)) << 15)
 #define divfix15(a,b) (fix15)( (((signed long long)(a)) << 15) / (b))
 
+/****************************************
+ * Division-free quotient (multiplies only)
+ ****************************************/
+
+/*!
+    @brief reciprocal seeds for `recipdivfix15()`: `2^61 / m` at the midpoint of each of 16 equal slices of the normalised 
+    denominator `m` in `[2^30, 2^31)`. Good to about 5 bits, which two Newton-Raphson steps take to full precision.
+*/
+static constexpr uint32_t recip_seed15[16] = { 2082408386, 1963413621, 1857283155, 1762037865, 1676084798, 1598127366, 1527099483, 1462116526, 1402438301, 1347440720, 1296593901, 1249445032, 1205604855, 1164736894, 1126548799, 1090785345 };
+
+/*!
+    @brief divides two fixed-point values without a division
+
+    Stand-in for `divfix15(num, den)` when `den > 0`. The denominator is normalised to `m` in `[2^30, 2^31)`, a 1/m seed is 
+    read from `recip_seed15[]` and refined with two Newton-Raphson steps `x = x * (2 - m * x)`; the quotient is then a single 
+    multiply and shift, truncated toward zero like `divfix15()`.
+
+    Error bound: over the whole range `DsfOsc` can produce (`param_a_min15 <= a <= param_a_max15`, every table entry) the 
+    result is within 1 LSB (2^-15) of `divfix15()`, which is at most one code of difference at the DAC. The band-limited
+    numerators are covered too; `getNextSample-recip` in `dsf-bench` checks the bound.
+
+    @param num fixed-point numerator
+    @param den fixed-point denominator, must be greater than zero
+    @return `num / den` in fixed point
+*/
+static inline fix15 recipdivfix15(fix15 num, fix15 den)
+{
+    int shift = __builtin_clz((uint32_t)den) - 1;
+    uint32_t m = (uint32_t)den << shift;
+    uint32_t x = recip_seed15[(m >> 26) & 0xF];
+
+    for (uint8_t step = 0; step < 2; step++) {
+        uint32_t mx = (uint32_t)(((uint64_t)m * x) >> 31);
+        x = (uint32_t)(((uint64_t)x * ((1u << 31) - mx)) >> 30);
+    }
+
+    // num * 2^15 / den == num * x * 2^(shift + 15) / 2^61
+    int64_t product = (int64_t)num * x;
+    if (product < 0) return -(fix15)((-product) >> (46 - shift));
+    return (fix15)(product >> (46 - shift));
+}